@@ -18,11 +18,16 @@
 
 #include "Color.h"
 #include <math.h>
+#include <string.h>
+#include <stdint.h>
 #include "MathUtil.h"
+#include "ColorPipeline.h"
 
 #include <iostream>
+#include <algorithm>
 using namespace std;
 
+
 // Constant used for lab->xyz transform. Should be calculated with maximum accuracy possible.
 #define EPSILON (216.0 / 24389.0)
 
@@ -43,7 +48,9 @@ static matrix3x3 sRGB_transformation_inverted;
 
 static matrix3x3 d65_d50_adaptation_matrix;
 static matrix3x3 d50_d65_adaptation_matrix;
+static matrix3x3 sRGB_to_d50_normalized_matrix; /**< sRGB transformation, D65-D50 adaptation and division by D50 reference white */
 
+static void color_init_lookup_tables();
 
 void color_init()
 {
@@ -54,6 +61,16 @@ void color_init()
 	color_get_chromatic_adaptation_matrix(color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2), color_get_reference(REFERENCE_ILLUMINANT_D50, REFERENCE_OBSERVER_2), &d65_d50_adaptation_matrix);
 	color_get_chromatic_adaptation_matrix(color_get_reference(REFERENCE_ILLUMINANT_D50, REFERENCE_OBSERVER_2), color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2), &d50_d65_adaptation_matrix);
 
+	const vector3 *d50 = color_get_reference(REFERENCE_ILLUMINANT_D50, REFERENCE_OBSERVER_2);
+	matrix3x3_multiply(&sRGB_transformation, &d65_d50_adaptation_matrix, &sRGB_to_d50_normalized_matrix);
+	for (int i = 0; i < 3; i++){
+		for (int j = 0; j < 3; j++){
+			sRGB_to_d50_normalized_matrix.m[i][j] /= d50->m[i];
+		}
+	}
+
+	matrix3x3_init_batch_kernels();
+	color_init_lookup_tables();
 }
 
 
@@ -141,32 +158,26 @@ void color_hsv_to_rgb(const Color* a, Color* b)
 	}
 }
 
-void color_rgb_to_xyz(const Color* a, Color* b, const matrix3x3* transformation)
+static inline float srgb_to_linear(float value)
 {
-	float R=a->rgb.red, G=a->rgb.green, B=a->rgb.blue;
-
-	if (R>0.04045){
-		R=pow(((R+0.055)/1.055),2.4);
-	}else{
-		R=R/12.92;
-	}
-
-	if (G>0.04045){
-		G=pow(((G+0.055)/1.055),2.4);
-	}else{
-		G=G/12.92;
-	}
+	if (value > 0.04045)
+		return pow((value + 0.055) / 1.055, 2.4);
+	return value / 12.92;
+}
 
-	if (B>0.04045){
-		B=pow(((B+0.055)/1.055),2.4);
-	}else{
-		B=B/12.92;
-	}
+static inline float linear_to_srgb(float value)
+{
+	if (value > 0.0031308)
+		return 1.055 * (pow(value, 1 / 2.4f)) - 0.055;
+	return 12.92 * value;
+}
 
+void color_rgb_to_xyz(const Color* a, Color* b, const matrix3x3* transformation)
+{
 	vector3 rgb;
-	rgb.x = R;
-	rgb.y = G;
-	rgb.z = B;
+	rgb.x = srgb_to_linear(a->rgb.red);
+	rgb.y = srgb_to_linear(a->rgb.green);
+	rgb.z = srgb_to_linear(a->rgb.blue);
 
 	vector3_multiply_matrix3x3(&rgb, transformation, &rgb);
 
@@ -178,32 +189,10 @@ void color_rgb_to_xyz(const Color* a, Color* b, const matrix3x3* transformation)
 void color_xyz_to_rgb(const Color* a, Color* b, const matrix3x3* transformation_inverted)
 {
 	vector3 rgb;
-	float R,G,B;
-
 	vector3_multiply_matrix3x3((vector3*)a, transformation_inverted, &rgb);
-	R=rgb.x;
-	G=rgb.y;
-	B=rgb.z;
-
-	if (R>0.0031308){
-		R=1.055*(pow(R,1/2.4f))-0.055;
-	}else{
-		R=12.92*R;
-	}
-	if (G>0.0031308){
-		G=1.055*(pow(G,1/2.4f))-0.055;
-	}else{
-		G=12.92*G;
-	}
-	if(B>0.0031308){
-		B=1.055*(pow(B,1/2.4f))-0.055;
-	}else{
-		B=12.92*B;
-	}
-
-	b->rgb.red=R;
-	b->rgb.green=G;
-	b->rgb.blue=B;
+	b->rgb.red = linear_to_srgb(rgb.x);
+	b->rgb.green = linear_to_srgb(rgb.y);
+	b->rgb.blue = linear_to_srgb(rgb.z);
 }
 
 
@@ -460,29 +449,20 @@ void color_lab_to_rgb_d50(const Color* a, Color* b)
 
 #define Kk (24389.0 / 27.0)
 
+static inline float lab_f(float value)
+{
+	if (value > EPSILON)
+		return pow(value, 1.0f / 3.0f);
+	return (Kk * value + 16.0f) / 116.0f;
+}
+
 void color_xyz_to_lab(const Color* a, Color* b, const vector3* reference_white)
 {
 	float X,Y,Z;
 
-	X = a->xyz.x / reference_white->x; //95.047f;
-	Y = a->xyz.y / reference_white->y; //100.000f;
-	Z = a->xyz.z / reference_white->z; //108.883f;
-
-	if (X>EPSILON){
-		X=pow(X,1.0f/3.0f);
-	}else{
-		X=(Kk*X+16.0f)/116.0f;
-	}
-	if (Y>EPSILON){
-		Y=pow(Y,1.0f/3.0f);
-	}else{
-		Y=(Kk*Y+16.0f)/116.0f;
-	}
-	if (Z>EPSILON){
-		Z=pow(Z,1.0f/3.0f);
-	}else{
-		Z=(Kk*Z+16.0f)/116.0f;
-	}
+	X = lab_f(a->xyz.x / reference_white->x); //95.047f;
+	Y = lab_f(a->xyz.y / reference_white->y); //100.000f;
+	Z = lab_f(a->xyz.z / reference_white->z); //108.883f;
 
 	b->lab.L=(116*Y)-16;
 	b->lab.a=500*(X-Y);
@@ -832,3 +812,259 @@ bool color_equal(const Color* a, const Color* b)
 	}
 	return true;
 }
+
+/** Number of colors converted at once by batch functions. Sized to keep temporary channel buffers on the stack. */
+const size_t BatchChunkSize = 256;
+
+void color_rgb_to_lab_batch(const float *red, const float *green, const float *blue, size_t count, float *L, float *a, float *b, const vector3* reference_white, const matrix3x3* transformation, const matrix3x3* adaptation_matrix)
+{
+	float x[BatchChunkSize], y[BatchChunkSize], z[BatchChunkSize];
+	for (size_t offset = 0; offset < count; offset += BatchChunkSize){
+		size_t n = std::min(BatchChunkSize, count - offset);
+		for (size_t i = 0; i < n; i++){
+			x[i] = srgb_to_linear(red[offset + i]);
+			y[i] = srgb_to_linear(green[offset + i]);
+			z[i] = srgb_to_linear(blue[offset + i]);
+		}
+		vector3_multiply_matrix3x3_batch(x, y, z, n, transformation, x, y, z);
+		vector3_multiply_matrix3x3_batch(x, y, z, n, adaptation_matrix, x, y, z);
+		for (size_t i = 0; i < n; i++){
+			float X = lab_f(x[i] / reference_white->x);
+			float Y = lab_f(y[i] / reference_white->y);
+			float Z = lab_f(z[i] / reference_white->z);
+			L[offset + i] = (116 * Y) - 16;
+			a[offset + i] = 500 * (X - Y);
+			b[offset + i] = 200 * (Y - Z);
+		}
+	}
+}
+
+void color_lab_to_rgb_batch(const float *L, const float *a, const float *b, size_t count, float *red, float *green, float *blue, const vector3* reference_white, const matrix3x3* transformation_inverted, const matrix3x3* adaptation_matrix_inverted)
+{
+	float x[BatchChunkSize], y[BatchChunkSize], z[BatchChunkSize];
+	for (size_t offset = 0; offset < count; offset += BatchChunkSize){
+		size_t n = std::min(BatchChunkSize, count - offset);
+		for (size_t i = 0; i < n; i++){
+			Color c;
+			c.lab.L = L[offset + i];
+			c.lab.a = a[offset + i];
+			c.lab.b = b[offset + i];
+			color_lab_to_xyz(&c, &c, reference_white);
+			x[i] = c.xyz.x;
+			y[i] = c.xyz.y;
+			z[i] = c.xyz.z;
+		}
+		vector3_multiply_matrix3x3_batch(x, y, z, n, adaptation_matrix_inverted, x, y, z);
+		vector3_multiply_matrix3x3_batch(x, y, z, n, transformation_inverted, x, y, z);
+		for (size_t i = 0; i < n; i++){
+			red[offset + i] = linear_to_srgb(x[i]);
+			green[offset + i] = linear_to_srgb(y[i]);
+			blue[offset + i] = linear_to_srgb(z[i]);
+		}
+	}
+}
+
+void color_rgb_to_lab_d50_batch(const Color* a, Color* b, size_t count)
+{
+	static const RgbToLabPipeline pipeline;
+	pipeline(a, b, count);
+}
+
+void color_lab_to_rgb_d50_batch(const Color* a, Color* b, size_t count)
+{
+	static const LabToRgbPipeline pipeline;
+	pipeline(a, b, count);
+}
+
+void color_rgb_to_lch_d50_batch(const Color* a, Color* b, size_t count)
+{
+	static const RgbToLchPipeline pipeline;
+	pipeline(a, b, count);
+}
+
+void color_lch_to_rgb_d50_batch(const Color* a, Color* b, size_t count)
+{
+	static const LchToRgbPipeline pipeline;
+	pipeline(a, b, count);
+}
+
+void color_rgb_to_hsv_batch(const Color* a, Color* b, size_t count)
+{
+	for (size_t i = 0; i < count; i++){
+		Color c;
+		color_zero(&c);
+		color_rgb_to_hsv(&a[i], &c);
+		b[i].hsv.hue = c.hsv.hue;
+		b[i].hsv.saturation = c.hsv.saturation;
+		b[i].hsv.value = c.hsv.value;
+	}
+}
+
+void color_hsv_to_rgb_batch(const Color* a, Color* b, size_t count)
+{
+	for (size_t i = 0; i < count; i++){
+		Color c;
+		color_hsv_to_rgb(&a[i], &c);
+		b[i].rgb.red = c.rgb.red;
+		b[i].rgb.green = c.rgb.green;
+		b[i].rgb.blue = c.rgb.blue;
+	}
+}
+
+void color_rgb_to_hsl_batch(const Color* a, Color* b, size_t count)
+{
+	for (size_t i = 0; i < count; i++){
+		Color c;
+		color_zero(&c);
+		color_rgb_to_hsl(&a[i], &c);
+		b[i].hsl.hue = c.hsl.hue;
+		b[i].hsl.saturation = c.hsl.saturation;
+		b[i].hsl.lightness = c.hsl.lightness;
+	}
+}
+
+void color_hsl_to_rgb_batch(const Color* a, Color* b, size_t count)
+{
+	for (size_t i = 0; i < count; i++){
+		Color c;
+		color_hsl_to_rgb(&a[i], &c);
+		b[i].rgb.red = c.rgb.red;
+		b[i].rgb.green = c.rgb.green;
+		b[i].rgb.blue = c.rgb.blue;
+	}
+}
+
+void color_rgb8_to_rgb_batch(const unsigned char *data, int channels, size_t count, Color* b)
+{
+	for (size_t i = 0; i < count; i++){
+		b[i].rgb.red = data[0] / 255.0;
+		b[i].rgb.green = data[1] / 255.0;
+		b[i].rgb.blue = data[2] / 255.0;
+		data += channels;
+	}
+}
+
+/** Number of intervals in interpolated linearization tables. */
+const int LookupTableSize = 4096;
+static float srgb8_values[256]; /**< Channel values produced from 8-bit values */
+static float srgb8_linear[256]; /**< Exact linear values of 8-bit channel values */
+static float srgb_linear_table[LookupTableSize + 2];
+static float linear_srgb_table[LookupTableSize + 2];
+
+static void color_init_lookup_tables()
+{
+	for (int i = 0; i < 256; i++){
+		srgb8_values[i] = i / 255.0;
+		srgb8_linear[i] = srgb_to_linear(srgb8_values[i]);
+	}
+	for (int i = 0; i <= LookupTableSize; i++){
+		srgb_linear_table[i] = srgb_to_linear(i / double(LookupTableSize));
+		linear_srgb_table[i] = linear_to_srgb(i / double(LookupTableSize));
+	}
+	// Padding entry allows interpolation at value 1 without a range check
+	srgb_linear_table[LookupTableSize + 1] = srgb_linear_table[LookupTableSize];
+	linear_srgb_table[LookupTableSize + 1] = linear_srgb_table[LookupTableSize];
+}
+
+static inline float lookup_interpolated(const float *table, float value)
+{
+	float position = value * LookupTableSize;
+	int index = int(position);
+	float fraction = position - index;
+	return table[index] + (table[index + 1] - table[index]) * fraction;
+}
+
+float color_srgb_to_linear_fast(float value)
+{
+	if (!(value >= 0 && value <= 1))
+		return srgb_to_linear(value);
+	int index = int(value * 255 + 0.5f);
+	if (srgb8_values[index] == value)
+		return srgb8_linear[index];
+	return lookup_interpolated(srgb_linear_table, value);
+}
+
+float color_linear_to_srgb_fast(float value)
+{
+	if (!(value >= 0 && value <= 1))
+		return linear_to_srgb(value);
+	return lookup_interpolated(linear_srgb_table, value);
+}
+
+float color_cbrt_fast(float value)
+{
+	if (value <= 0) return 0;
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	bits = bits / 3 + 709921077;
+	float y;
+	memcpy(&y, &bits, sizeof(y));
+	for (int i = 0; i < 2; i++){
+		float y3 = y * y * y;
+		y = y * (y3 + 2 * value) / (2 * y3 + value);
+	}
+	return y;
+}
+
+static inline float lab_f_fast(float value)
+{
+	if (value > EPSILON)
+		return color_cbrt_fast(value);
+	return (Kk * value + 16.0f) / 116.0f;
+}
+
+float color_srgb_to_linear(float value)
+{
+	return srgb_to_linear(value);
+}
+
+float color_linear_to_srgb(float value)
+{
+	return linear_to_srgb(value);
+}
+
+float color_lab_f(float value)
+{
+	return lab_f(value);
+}
+
+float color_lab_f_fast(float value)
+{
+	return lab_f_fast(value);
+}
+
+void color_rgb_get_linear_fast(const Color* a, Color* b)
+{
+	b->rgb.red = color_srgb_to_linear_fast(a->rgb.red);
+	b->rgb.green = color_srgb_to_linear_fast(a->rgb.green);
+	b->rgb.blue = color_srgb_to_linear_fast(a->rgb.blue);
+}
+
+void color_linear_get_rgb_fast(const Color* a, Color* b)
+{
+	b->rgb.red = color_linear_to_srgb_fast(a->rgb.red);
+	b->rgb.green = color_linear_to_srgb_fast(a->rgb.green);
+	b->rgb.blue = color_linear_to_srgb_fast(a->rgb.blue);
+}
+
+void color_rgb_to_lab_d50_fast(const Color* a, Color* b)
+{
+	vector3 v;
+	v.x = color_srgb_to_linear_fast(a->rgb.red);
+	v.y = color_srgb_to_linear_fast(a->rgb.green);
+	v.z = color_srgb_to_linear_fast(a->rgb.blue);
+	vector3_multiply_matrix3x3(&v, &sRGB_to_d50_normalized_matrix, &v);
+	float X = lab_f_fast(v.x);
+	float Y = lab_f_fast(v.y);
+	float Z = lab_f_fast(v.z);
+	b->lab.L = (116 * Y) - 16;
+	b->lab.a = 500 * (X - Y);
+	b->lab.b = 200 * (Y - Z);
+}
+
+void color_rgb_to_lch_d50_fast(const Color* a, Color* b)
+{
+	Color c;
+	color_rgb_to_lab_d50_fast(a, &c);
+	color_lab_to_lch(&c, b);
+}
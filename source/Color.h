@@ -20,6 +20,7 @@
 #define GPICK_COLOR_H_
 
 #include "MathUtil.h"
+#include <stddef.h>
 
 /** \file source/Color.h
  * \brief Color structure and functions to convert colors from one color space to another.
@@ -336,6 +337,95 @@ void color_rgb_get_linear(const Color* a, Color* b);
  */
 void color_linear_get_rgb(const Color* a, Color* b);
 
+/**
+ * Transform sRGB channel value to linear value.
+ * @param[in] value Channel value in sRGB color space.
+ * @return Linear channel value.
+ */
+float color_srgb_to_linear(float value);
+
+/**
+ * Transform linear channel value to sRGB value.
+ * @param[in] value Linear channel value.
+ * @return Channel value in sRGB color space.
+ */
+float color_linear_to_srgb(float value);
+
+/**
+ * Lab companding function f(t) applied to XYZ values divided by reference white.
+ * @param[in] value XYZ component divided by the same reference white component.
+ * @return Companded value.
+ */
+float color_lab_f(float value);
+
+/**
+ * Lab companding function f(t) using color_cbrt_fast().
+ * @param[in] value XYZ component divided by the same reference white component.
+ * @return Companded value.
+ */
+float color_lab_f_fast(float value);
+
+/**
+ * Transform sRGB channel value to linear value using lookup tables built by color_init().
+ * Values obtained from 8-bit channel values (n / 255.0) are looked up in an exact table, other values
+ * in [0, 1] range are linearly interpolated with an absolute error below 2e-7. Values outside [0, 1]
+ * range are calculated exactly.
+ * @param[in] value Channel value in sRGB color space.
+ * @return Linear channel value.
+ */
+float color_srgb_to_linear_fast(float value);
+
+/**
+ * Transform linear channel value to sRGB value using lookup table built by color_init().
+ * Values in [0, 1] range are linearly interpolated with an absolute error below 3e-5. Values outside
+ * [0, 1] range are calculated exactly.
+ * @param[in] value Linear channel value.
+ * @return Channel value in sRGB color space.
+ */
+float color_linear_to_srgb_fast(float value);
+
+/**
+ * Calculate cube root of non-negative value.
+ * Initial approximation is made by dividing floating point exponent and refined by two Halley iterations,
+ * relative error is below 5e-7.
+ * @param[in] value Non-negative value.
+ * @return Cube root.
+ */
+float color_cbrt_fast(float value);
+
+/**
+ * Transform RGB color to linear RGB color using lookup tables.
+ * @param[in] a Color in RGB color space.
+ * @param[out] b Linear color in RGB color space.
+ * @see color_srgb_to_linear_fast.
+ */
+void color_rgb_get_linear_fast(const Color* a, Color* b);
+
+/**
+ * Transform linear RGB color to RGB color using lookup tables.
+ * @param[in] a Linear color in RGB color space.
+ * @param[out] b Color in RGB color space.
+ * @see color_linear_to_srgb_fast.
+ */
+void color_linear_get_rgb_fast(const Color* a, Color* b);
+
+/**
+ * Convert RGB color space to Lab color space with illuminant D50, observer 2, sRGB transformation matrix and D65-D50 adaptation matrix.
+ * Uses lookup tables for linearization and approximated cube root, Lab values differ from color_rgb_to_lab_d50() by less than 5e-4.
+ * @param[in] a Source color in RGB color space.
+ * @param[out] b Destination color in Lab color space.
+ */
+void color_rgb_to_lab_d50_fast(const Color* a, Color* b);
+
+/**
+ * Convert RGB color space to LCH color space with illuminant D50, observer 2, sRGB transformation matrix and D65-D50 adaptation matrix.
+ * Uses lookup tables for linearization and approximated cube root.
+ * @param[in] a Source color in RGB color space.
+ * @param[out] b Destination color in LCH color space.
+ * @see color_rgb_to_lab_d50_fast.
+ */
+void color_rgb_to_lch_d50_fast(const Color* a, Color* b);
+
 /**
  * Copy color.
  * @param[in] a Source color in any color space.
@@ -507,4 +597,115 @@ float color_distance_lch(const Color* a, const Color* b);
  */
 bool color_equal(const Color* a, const Color* b);
 
+/**
+ * Convert RGB color space to Lab color space for a number of colors stored as separate channel arrays.
+ * Results are identical to calling color_rgb_to_lab() on every color.
+ * Input and output arrays can be the same.
+ * @param[in] red Red channel values.
+ * @param[in] green Green channel values.
+ * @param[in] blue Blue channel values.
+ * @param[in] count Number of colors.
+ * @param[out] L Lightness channel values.
+ * @param[out] a A channel values.
+ * @param[out] b B channel values.
+ * @param[in] reference_white Reference white color values.
+ * @param[in] transformation Transformation matrix for RGB to XYZ conversion.
+ * @param[in] adaptation_matrix XYZ chromatic adaptation matrix.
+ */
+void color_rgb_to_lab_batch(const float *red, const float *green, const float *blue, size_t count, float *L, float *a, float *b, const vector3* reference_white, const matrix3x3* transformation, const matrix3x3* adaptation_matrix);
+
+/**
+ * Convert Lab color space to RGB color space for a number of colors stored as separate channel arrays.
+ * Results are identical to calling color_lab_to_rgb() on every color.
+ * Input and output arrays can be the same.
+ * @param[in] L Lightness channel values.
+ * @param[in] a A channel values.
+ * @param[in] b B channel values.
+ * @param[in] count Number of colors.
+ * @param[out] red Red channel values.
+ * @param[out] green Green channel values.
+ * @param[out] blue Blue channel values.
+ * @param[in] reference_white Reference white color values.
+ * @param[in] transformation_inverted Transformation matrix for XYZ to RGB conversion.
+ * @param[in] adaptation_matrix_inverted Inverted XYZ chromatic adaptation matrix.
+ */
+void color_lab_to_rgb_batch(const float *L, const float *a, const float *b, size_t count, float *red, float *green, float *blue, const vector3* reference_white, const matrix3x3* transformation_inverted, const matrix3x3* adaptation_matrix_inverted);
+
+/**
+ * Convert an array of colors from RGB color space to Lab color space with illuminant D50, observer 2, sRGB transformation matrix and D65-D50 adaptation matrix.
+ * Conversion is done by a fused pipeline from ColorPipeline.h, so results can differ from single color conversion in the last bits.
+ * @param[in] a Source colors in RGB color space.
+ * @param[out] b Destination colors in Lab color space. Can be the same as source.
+ * @param[in] count Number of colors.
+ */
+void color_rgb_to_lab_d50_batch(const Color* a, Color* b, size_t count);
+
+/**
+ * Convert an array of colors from Lab color space to RGB color space with illuminant D50, observer 2, inverted sRGB transformation matrix and D50-D65 adaptation matrix.
+ * Conversion is done by a fused pipeline from ColorPipeline.h, so results can differ from single color conversion in the last bits.
+ * @param[in] a Source colors in Lab color space.
+ * @param[out] b Destination colors in RGB color space. Can be the same as source.
+ * @param[in] count Number of colors.
+ */
+void color_lab_to_rgb_d50_batch(const Color* a, Color* b, size_t count);
+
+/**
+ * Convert an array of colors from RGB color space to LCH color space with illuminant D50, observer 2, sRGB transformation matrix and D65-D50 adaptation matrix.
+ * Conversion is done by a fused pipeline from ColorPipeline.h, so results can differ from single color conversion in the last bits.
+ * @param[in] a Source colors in RGB color space.
+ * @param[out] b Destination colors in LCH color space. Can be the same as source.
+ * @param[in] count Number of colors.
+ */
+void color_rgb_to_lch_d50_batch(const Color* a, Color* b, size_t count);
+
+/**
+ * Convert an array of colors from LCH color space to RGB color space with illuminant D50, observer 2, inverted sRGB transformation matrix and D50-D65 adaptation matrix.
+ * Conversion is done by a fused pipeline from ColorPipeline.h, so results can differ from single color conversion in the last bits.
+ * @param[in] a Source colors in LCH color space.
+ * @param[out] b Destination colors in RGB color space. Can be the same as source.
+ * @param[in] count Number of colors.
+ */
+void color_lch_to_rgb_d50_batch(const Color* a, Color* b, size_t count);
+
+/**
+ * Convert an array of colors from RGB color space to HSV color space.
+ * @param[in] a Source colors in RGB color space.
+ * @param[out] b Destination colors in HSV color space. Can be the same as source.
+ * @param[in] count Number of colors.
+ */
+void color_rgb_to_hsv_batch(const Color* a, Color* b, size_t count);
+
+/**
+ * Convert an array of colors from HSV color space to RGB color space.
+ * @param[in] a Source colors in HSV color space.
+ * @param[out] b Destination colors in RGB color space. Can be the same as source.
+ * @param[in] count Number of colors.
+ */
+void color_hsv_to_rgb_batch(const Color* a, Color* b, size_t count);
+
+/**
+ * Convert an array of colors from RGB color space to HSL color space.
+ * @param[in] a Source colors in RGB color space.
+ * @param[out] b Destination colors in HSL color space. Can be the same as source.
+ * @param[in] count Number of colors.
+ */
+void color_rgb_to_hsl_batch(const Color* a, Color* b, size_t count);
+
+/**
+ * Convert an array of colors from HSL color space to RGB color space.
+ * @param[in] a Source colors in HSL color space.
+ * @param[out] b Destination colors in RGB color space. Can be the same as source.
+ * @param[in] count Number of colors.
+ */
+void color_hsl_to_rgb_batch(const Color* a, Color* b, size_t count);
+
+/**
+ * Convert 8-bit RGB pixel data to RGB colors.
+ * @param[in] data Pixel data. First three bytes of each pixel are red, green and blue values.
+ * @param[in] channels Number of bytes in each pixel.
+ * @param[in] count Number of pixels.
+ * @param[out] b Destination colors in RGB color space.
+ */
+void color_rgb8_to_rgb_batch(const unsigned char *data, int channels, size_t count, Color* b);
+
 #endif /* GPICK_COLOR_H_ */
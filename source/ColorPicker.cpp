@@ -45,6 +45,8 @@
 #include "color_names/ColorNames.h"
 #include "ScreenReader.h"
 #include "Sampler.h"
+#include "RefreshScheduler.h"
+#include "PickerTimings.h"
 #include <gdk/gdkkeysyms.h>
 #include <math.h>
 #ifdef _MSC_VER
@@ -69,6 +71,7 @@ typedef struct ColorPickerArgs{
 	GtkWidget* expanderLAB;
 	GtkWidget* expanderLCH;
 	GtkWidget* expanderInfo;
+	GtkWidget* expanderStatistics;
 	GtkWidget* expanderMain;
 	GtkWidget* expanderSettings;
 	GtkWidget *swatch_display;
@@ -85,7 +88,11 @@ typedef struct ColorPickerArgs{
 	GtkWidget *contrastCheck;
 	GtkWidget *contrastCheckMsg;
 	GtkWidget *pick_button;
-	guint timeout_source_id;
+	GtkWidget *statistics;
+	guint statistics_timeout;
+	RefreshScheduler *refresh_scheduler;
+	GtkWidget *motion_window; /**< Top level window receiving pointer motion events, reset to nullptr when window is destroyed */
+	gulong motion_handler_id;
 	FloatingPicker floating_picker;
 	struct dynvSystem *params;
 	struct dynvSystem *global_params;
@@ -114,18 +121,18 @@ static void updateMainColorNow(ColorPickerArgs* args)
 	}
 }
 
-static gboolean updateMainColor( gpointer data ){
-	ColorPickerArgs* args=(ColorPickerArgs*)data;
+/** Sample color under pointer and update main swatch color and zoomed view.
+ * When only_if_changed is set, nothing is updated if pointer did not move and screen contents around it did not change.
+ * Returns true if pointer moved or screen contents changed.
+ */
+static bool updateMainColorSample(ColorPickerArgs* args, bool only_if_changed)
+{
+	PickerStageTimer timer(PickerStage::tick);
 	GdkScreen *screen;
-	GdkModifierType state;
-	int x, y;
-	gdk_display_get_pointer(gdk_display_get_default(), &screen, &x, &y, &state);
-	int monitor = gdk_screen_get_monitor_at_point(screen, x, y);
-	GdkRectangle monitor_geometry;
-	gdk_screen_get_monitor_geometry(screen, monitor, &monitor_geometry);
-	Vec2<int> pointer(x,y);
-	Rect2<int> screen_rect(monitor_geometry.x, monitor_geometry.y, monitor_geometry.x + monitor_geometry.width, monitor_geometry.y + monitor_geometry.height);
+	Vec2<int> pointer;
+	Rect2<int> screen_rect;
 	auto screen_reader = args->gs->getScreenReader();
+	screen_reader_get_pointer(screen_reader, &screen, pointer, screen_rect);
 	screen_reader_reset_rect(screen_reader);
 	Rect2<int> sampler_rect, zoomed_rect, final_rect;
 	sampler_get_screen_rect(args->gs->getSampler(), pointer, screen_rect, &sampler_rect);
@@ -135,27 +142,117 @@ static gboolean updateMainColor( gpointer data ){
 		gtk_zoomed_get_screen_rect(GTK_ZOOMED(args->zoomed_display), pointer, screen_rect, &zoomed_rect);
 		screen_reader_add_rect(screen_reader, screen, zoomed_rect);
 	}
-	screen_reader_update_surface(screen_reader, &final_rect);
+	ScreenReaderUpdate update = ScreenReaderUpdate::area_changed;
+	if (only_if_changed){
+		update = screen_reader_update_surface_if_changed(screen_reader, &final_rect);
+		if (update == ScreenReaderUpdate::skipped){
+			timer.discard();
+			return false;
+		}
+	}else{
+		screen_reader_update_surface(screen_reader, &final_rect);
+	}
 	Vec2<int> offset;
 	offset = Vec2<int>(sampler_rect.getX() - final_rect.getX(), sampler_rect.getY() - final_rect.getY());
 	Color c;
 	sampler_get_color_sample(args->gs->getSampler(), pointer, screen_rect, offset, &c);
-	string text = args->gs->converters().serialize(c, Converters::Type::display);
+	string text;
+	{
+		PickerStageTimer serialize_timer(PickerStage::serialize);
+		text = args->gs->converters().serialize(c, Converters::Type::display);
+	}
 	gtk_color_set_color(GTK_COLOR(args->color_code), &c, text.c_str());
 	gtk_swatch_set_main_color(GTK_SWATCH(args->swatch_display), &c);
 	if (zoomed_enabled){
 		offset = Vec2<int>(zoomed_rect.getX()-final_rect.getX(), zoomed_rect.getY()-final_rect.getY());
+		PickerStageTimer zoomed_timer(PickerStage::zoomed_update);
 		gtk_zoomed_update(GTK_ZOOMED(args->zoomed_display), pointer, screen_rect, offset, screen_reader_get_surface(screen_reader));
 	}
+	return update == ScreenReaderUpdate::area_changed || update == ScreenReaderUpdate::damaged;
+}
+static gboolean updateMainColor( gpointer data ){
+	updateMainColorSample((ColorPickerArgs*)data, false);
 	return TRUE;
 }
-static gboolean updateMainColorTimer(ColorPickerArgs* args)
+/** Restore full refresh rate when pointer moves over program window. Motion over other windows is noticed on the next scheduler tick. */
+static gboolean on_motion_notify(GtkWidget *widget, GdkEventMotion *event, ColorPickerArgs *args)
 {
-	updateMainColor(args);
-	return true;
+	if (args->refresh_scheduler) refresh_scheduler_wake(args->refresh_scheduler);
+	return FALSE;
+}
+static void startUpdateTimer(ColorPickerArgs* args)
+{
+	float refresh_rate = dynv_get_float_wd(args->global_params, "refresh_rate", 30);
+	args->refresh_scheduler = refresh_scheduler_new(refresh_rate, [args]() {
+		return updateMainColorSample(args, true);
+	});
+	GtkWidget *toplevel = gtk_widget_get_toplevel(args->main);
+	if (gtk_widget_is_toplevel(toplevel)){
+		gtk_widget_add_events(toplevel, GDK_POINTER_MOTION_MASK);
+		args->motion_window = toplevel;
+		g_object_add_weak_pointer(G_OBJECT(toplevel), (gpointer*)&args->motion_window);
+		args->motion_handler_id = g_signal_connect(G_OBJECT(toplevel), "motion-notify-event", G_CALLBACK(on_motion_notify), args);
+	}
+}
+static void stopUpdateTimer(ColorPickerArgs* args)
+{
+	if (args->refresh_scheduler){
+		refresh_scheduler_destroy(args->refresh_scheduler);
+		args->refresh_scheduler = nullptr;
+	}
+	if (args->motion_window){
+		g_signal_handler_disconnect(G_OBJECT(args->motion_window), args->motion_handler_id);
+		g_object_remove_weak_pointer(G_OBJECT(args->motion_window), (gpointer*)&args->motion_window);
+		args->motion_window = nullptr;
+	}
+}
+/** Show picker stage latencies, screen reader and refresh scheduler statistics in statistics panel */
+static void updateStatistics(ColorPickerArgs *args)
+{
+	stringstream ss;
+	ss.setf(ios::fixed, ios::floatfield);
+	ss << setprecision(1);
+	for (int i = 0; i < PickerStageCount; i++){
+		PickerStage stage = static_cast<PickerStage>(i);
+		PickerStageStatistics statistics = picker_timings_get(stage);
+		ss << setw(14) << left << picker_timings_get_stage_name(stage) << right << " p50 " << setw(8) << statistics.p50 << " us, p99 " << setw(8) << statistics.p99 << " us, " << statistics.count << "\n";
+	}
+	ScreenReaderStatistics screen_reader_statistics;
+	screen_reader_get_statistics(args->gs->getScreenReader(), &screen_reader_statistics);
+	ss << "captures " << screen_reader_statistics.updates << ", skipped " << screen_reader_statistics.skipped << (screen_reader_statistics.damage_tracking ? ", damage tracking" : "");
+	if (args->refresh_scheduler){
+		RefreshSchedulerStatistics scheduler_statistics;
+		refresh_scheduler_get_statistics(args->refresh_scheduler, &scheduler_statistics);
+		ss << "\nticks " << scheduler_statistics.ticks << ", idle " << scheduler_statistics.idle_ticks << ", interval " << scheduler_statistics.interval << " ms";
+	}
+	gchar *markup = g_markup_printf_escaped("<tt>%s</tt>", ss.str().c_str());
+	gtk_label_set_markup(GTK_LABEL(args->statistics), markup);
+	g_free(markup);
+}
+static gboolean on_statistics_timeout(ColorPickerArgs *args)
+{
+	updateStatistics(args);
+	return TRUE;
+}
+static void stopStatisticsTimer(ColorPickerArgs *args)
+{
+	if (args->statistics_timeout){
+		g_source_remove(args->statistics_timeout);
+		args->statistics_timeout = 0;
+	}
+}
+/** Statistics are refreshed every second only while statistics panel is expanded */
+static void on_statistics_expanded(GtkExpander *expander, GParamSpec *param_spec, ColorPickerArgs *args)
+{
+	stopStatisticsTimer(args);
+	if (gtk_expander_get_expanded(expander)){
+		updateStatistics(args);
+		args->statistics_timeout = g_timeout_add_seconds(1, (GSourceFunc)on_statistics_timeout, args);
+	}
 }
 static void updateComponentText(ColorPickerArgs *args, GtkColorComponent *component, const char *type)
 {
+	PickerStageTimer timer(PickerStage::serialize);
 	Color transformed_color;
 	gtk_color_component_get_transformed_color(component, &transformed_color);
 	lua::Script &script = args->gs->script();
@@ -187,15 +284,19 @@ static void updateDisplays(ColorPickerArgs *args, GtkWidget *except_widget)
 	updateComponentText(args, GTK_COLOR_COMPONENT(args->cmyk_control), "cmyk");
 	updateComponentText(args, GTK_COLOR_COMPONENT(args->lab_control), "lab");
 	updateComponentText(args, GTK_COLOR_COMPONENT(args->lch_control), "lch");
-	string color_name = color_names_get(args->gs->getColorNames(), &c, true);
+	string color_name;
+	{
+		PickerStageTimer timer(PickerStage::color_name);
+		color_name = color_names_get(args->gs->getColorNames(), &c, true);
+	}
 	gtk_entry_set_text(GTK_ENTRY(args->color_name), color_name.c_str());
 	gtk_color_get_color(GTK_COLOR(args->contrastCheck), &c2);
 	gtk_color_set_text_color(GTK_COLOR(args->contrastCheck), &c);
 	stringstream ss;
 	ss.setf(ios::fixed, ios::floatfield);
 	Color c_lab, c2_lab;
-	color_rgb_to_lab_d50(&c, &c_lab);
-	color_rgb_to_lab_d50(&c2, &c2_lab);
+	color_rgb_to_lab_d50_fast(&c, &c_lab);
+	color_rgb_to_lab_d50_fast(&c2, &c2_lab);
 	const ColorWheelType *wheel = &color_wheel_types_get()[0];
 	Color hsl1, hsl2;
 	double hue1, hue2;
@@ -662,10 +763,34 @@ static void on_oversample_falloff_changed(GtkWidget *widget, gpointer data) {
 
 		ColorPickerArgs* args = (ColorPickerArgs*)data;
 		sampler_set_falloff(args->gs->getSampler(), (SamplerFalloff) falloff_id);
+		if (args->refresh_scheduler) updateMainColor(args);
 
 	}
 }
 
+static void on_sampler_mode_changed(GtkWidget *widget, gpointer data) {
+	gint mode = gtk_combo_box_get_active(GTK_COMBO_BOX(widget));
+	if (mode < 0) return;
+	ColorPickerArgs* args = (ColorPickerArgs*)data;
+	sampler_set_mode(args->gs->getSampler(), (SamplerMode) mode);
+	if (args->refresh_scheduler) updateMainColor(args);
+}
+
+static GtkWidget* create_sampler_mode_list()
+{
+	GtkWidget *widget = gtk_combo_box_text_new();
+	const char *labels[] = {
+		_("Mean"),
+		_("Median"),
+		_("Trimmed mean"),
+		_("Dominant color"),
+	};
+	for (size_t i = 0; i < sizeof(labels) / sizeof(labels[0]); ++i){
+		gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(widget), labels[i]);
+	}
+	return widget;
+}
+
 static GtkWidget* create_falloff_type_list()
 {
 	GtkListStore *store = gtk_list_store_new(3, GDK_TYPE_PIXBUF, G_TYPE_STRING, G_TYPE_INT);
@@ -709,6 +834,8 @@ static GtkWidget* create_falloff_type_list()
 }
 static int source_destroy(ColorPickerArgs *args)
 {
+	stopUpdateTimer(args);
+	stopStatisticsTimer(args);
 	dynv_set_int32(args->params, "swatch.active_color", gtk_swatch_get_active_index(GTK_SWATCH(args->swatch_display)));
 	Color c;
 	char tmp[32];
@@ -720,6 +847,7 @@ static int source_destroy(ColorPickerArgs *args)
 
 	dynv_set_int32(args->params, "sampler.oversample", sampler_get_oversample(args->gs->getSampler()));
 	dynv_set_int32(args->params, "sampler.falloff", static_cast<int>(sampler_get_falloff(args->gs->getSampler())));
+	dynv_set_int32(args->params, "sampler.mode", static_cast<int>(sampler_get_mode(args->gs->getSampler())));
 
 	dynv_set_float(args->params, "zoom", gtk_zoomed_get_zoom(GTK_ZOOMED(args->zoomed_display)));
 	dynv_set_int32(args->params, "zoom_size", gtk_zoomed_get_size(GTK_ZOOMED(args->zoomed_display)));
@@ -732,6 +860,7 @@ static int source_destroy(ColorPickerArgs *args)
 	dynv_set_bool(args->params, "expander.lch", gtk_expander_get_expanded(GTK_EXPANDER(args->expanderLCH)));
 	dynv_set_bool(args->params, "expander.cmyk", gtk_expander_get_expanded(GTK_EXPANDER(args->expanderCMYK)));
 	dynv_set_bool(args->params, "expander.info", gtk_expander_get_expanded(GTK_EXPANDER(args->expanderInfo)));
+	dynv_set_bool(args->params, "expander.statistics", gtk_expander_get_expanded(GTK_EXPANDER(args->expanderStatistics)));
 
 	gtk_color_get_color(GTK_COLOR(args->contrastCheck), &c);
 	dynv_set_color(args->params, "contrast.color", &c);
@@ -782,10 +911,7 @@ static int source_set_color(ColorPickerArgs *args, ColorObject* color_object)
 }
 static int source_activate(ColorPickerArgs *args)
 {
-	if (args->timeout_source_id > 0) {
-		g_source_remove(args->timeout_source_id);
-		args->timeout_source_id = 0;
-	}
+	stopUpdateTimer(args);
 	struct{
 		GtkWidget *widget;
 		const char *setting;
@@ -823,8 +949,7 @@ static int source_activate(ColorPickerArgs *args)
 	gtk_color_set_transformation_chain(GTK_COLOR(args->contrastCheck), chain);
 
 	if (dynv_get_bool_wd(args->params, "zoomed_enabled", true)){
-		float refresh_rate = dynv_get_float_wd(args->global_params, "refresh_rate", 30);
-		args->timeout_source_id = g_timeout_add_full(G_PRIORITY_DEFAULT_IDLE, 1000/refresh_rate, (GSourceFunc)updateMainColorTimer, args, (GDestroyNotify)nullptr);
+		startUpdateTimer(args);
 	}
 
 	gtk_zoomed_set_size(GTK_ZOOMED(args->zoomed_display), dynv_get_int32_wd(args->params, "zoom_size", 150));
@@ -838,10 +963,7 @@ static int source_deactivate(ColorPickerArgs *args){
 
 	gtk_statusbar_pop(GTK_STATUSBAR(args->statusbar), gtk_statusbar_get_context_id(GTK_STATUSBAR(args->statusbar), "focus_swatch"));
 
-	if (args->timeout_source_id > 0){
-		g_source_remove(args->timeout_source_id);
-		args->timeout_source_id = 0;
-	}
+	stopUpdateTimer(args);
 	return 0;
 }
 
@@ -897,20 +1019,13 @@ static void on_zoomed_activate(GtkWidget *widget, ColorPickerArgs *args){
 		gtk_zoomed_set_fade(GTK_ZOOMED(args->zoomed_display), true);
 		dynv_set_bool(args->params, "zoomed_enabled", false);
 
-		if (args->timeout_source_id > 0){
-			g_source_remove(args->timeout_source_id);
-			args->timeout_source_id = 0;
-		}
+		stopUpdateTimer(args);
 	}else{
 		gtk_zoomed_set_fade(GTK_ZOOMED(args->zoomed_display), false);
 		dynv_set_bool(args->params, "zoomed_enabled", true);
 
-		if (args->timeout_source_id > 0){
-			g_source_remove(args->timeout_source_id);
-			args->timeout_source_id = 0;
-		}
-		float refresh_rate = dynv_get_float_wd(args->global_params, "refresh_rate", 30);
-		args->timeout_source_id = g_timeout_add_full(G_PRIORITY_DEFAULT_IDLE, 1000/refresh_rate, (GSourceFunc)updateMainColorTimer, args, (GDestroyNotify)nullptr);
+		stopUpdateTimer(args);
+		startUpdateTimer(args);
 	}
 	return;
 }
@@ -934,7 +1049,10 @@ static ColorSource* source_implement(ColorSource *source, GlobalState *gs, struc
 	args->source.deactivate = (int (*)(ColorSource *source))source_deactivate;
 
 	args->gs = gs;
-	args->timeout_source_id = 0;
+	args->refresh_scheduler = nullptr;
+	args->motion_window = nullptr;
+	args->motion_handler_id = 0;
+	args->statistics_timeout = 0;
 
 	GtkWidget *vbox, *widget, *expander, *table, *main_hbox, *scrolled;
 	int table_y;
@@ -1043,6 +1161,13 @@ static ColorSource* source_implement(ColorSource *source, GlobalState *gs, struc
 				gtk_table_attach(GTK_TABLE(table), widget,1,2,table_y,table_y+1,GtkAttachOptions(GTK_FILL | GTK_EXPAND),GTK_FILL,5,0);
 				table_y++;
 
+				gtk_table_attach(GTK_TABLE(table), gtk_label_aligned_new(_("Mode:"),0,0.5,0,0),0,1,table_y,table_y+1,GtkAttachOptions(GTK_FILL),GTK_FILL,5,5);
+				widget = create_sampler_mode_list();
+				g_signal_connect (G_OBJECT (widget), "changed", G_CALLBACK (on_sampler_mode_changed), args);
+				gtk_combo_box_set_active(GTK_COMBO_BOX(widget), dynv_get_int32_wd(args->params, "sampler.mode", static_cast<int>(SamplerMode::mean)));
+				gtk_table_attach(GTK_TABLE(table), widget,1,2,table_y,table_y+1,GtkAttachOptions(GTK_FILL | GTK_EXPAND),GTK_FILL,5,0);
+				table_y++;
+
 				gtk_table_attach(GTK_TABLE(table), gtk_label_aligned_new(_("Zoom:"),0,0.5,0,0),0,1,table_y,table_y+1,GtkAttachOptions(GTK_FILL),GTK_FILL,5,5);
 				widget = gtk_hscale_new_with_range (0, 100, 1);
 				g_signal_connect (G_OBJECT (widget), "value-changed", G_CALLBACK (on_zoom_value_changed), args);
@@ -1184,6 +1309,18 @@ static ColorSource* source_implement(ColorSource *source, GlobalState *gs, struc
 					gtk_table_attach(GTK_TABLE(table), args->contrastCheckMsg = gtk_label_new(""),2,3,table_y,table_y+1,GtkAttachOptions(GTK_FILL | GTK_EXPAND),GTK_FILL,5,5);
 
 					table_y++;
+
+			expander = gtk_expander_new(_("Statistics"));
+			args->expanderStatistics = expander;
+			gtk_box_pack_start(GTK_BOX(vbox), expander, FALSE, FALSE, 0);
+
+				widget = gtk_label_aligned_new("", 0, 0.5, 0, 0);
+				gtk_label_set_selectable(GTK_LABEL(widget), true);
+				gtk_container_add(GTK_CONTAINER(expander), widget);
+				args->statistics = widget;
+
+			g_signal_connect(G_OBJECT(expander), "notify::expanded", G_CALLBACK(on_statistics_expanded), args);
+			gtk_expander_set_expanded(GTK_EXPANDER(expander), dynv_get_bool_wd(args->params, "expander.statistics", false));
 	updateDisplays(args, 0);
 	args->main = main_hbox;
 	gtk_widget_show_all(main_hbox);
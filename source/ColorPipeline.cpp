@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ColorPipeline.h"
+#include <algorithm>
+
+/** Number of colors converted at once by batch operators. */
+const size_t ChunkSize = 256;
+const float Epsilon = 216.0 / 24389.0;
+const float Kappa = 24389.0 / 27.0;
+
+template<ColorPipelinePrecision precision>
+static inline float to_linear(float value)
+{
+	return precision == ColorPipelinePrecision::fast ? color_srgb_to_linear_fast(value) : color_srgb_to_linear(value);
+}
+
+template<ColorPipelinePrecision precision>
+static inline float from_linear(float value)
+{
+	return precision == ColorPipelinePrecision::fast ? color_linear_to_srgb_fast(value) : color_linear_to_srgb(value);
+}
+
+template<ColorPipelinePrecision precision>
+static inline float lab_f(float value)
+{
+	return precision == ColorPipelinePrecision::fast ? color_lab_f_fast(value) : color_lab_f(value);
+}
+
+static inline float lab_f_inverse(float value)
+{
+	float cube = value * value * value;
+	if (cube > Epsilon)
+		return cube;
+	return (116 * value - 16) / Kappa;
+}
+
+/** Compose transformation, adaptation and division by reference white into one matrix. */
+static void build_forward_matrix(const vector3* reference_white, const matrix3x3* transformation, const matrix3x3* adaptation_matrix, matrix3x3* result)
+{
+	matrix3x3_multiply(transformation, adaptation_matrix, result);
+	for (int i = 0; i < 3; i++){
+		result->m[i][0] /= reference_white->m[i];
+		result->m[i][1] /= reference_white->m[i];
+		result->m[i][2] /= reference_white->m[i];
+	}
+}
+
+/** Compose multiplication by reference white, inverted adaptation and inverted transformation into one matrix. */
+static void build_inverse_matrix(const vector3* reference_white, const matrix3x3* transformation_inverted, const matrix3x3* adaptation_matrix_inverted, matrix3x3* result)
+{
+	matrix3x3 scaled = *adaptation_matrix_inverted;
+	for (int i = 0; i < 3; i++){
+		scaled.m[i][0] *= reference_white->x;
+		scaled.m[i][1] *= reference_white->y;
+		scaled.m[i][2] *= reference_white->z;
+	}
+	matrix3x3_multiply(&scaled, transformation_inverted, result);
+}
+
+template<ColorPipelineSpace space, ColorPipelinePrecision precision>
+static inline void finish_lab(float x, float y, float z, Color* b)
+{
+	float X = lab_f<precision>(x);
+	float Y = lab_f<precision>(y);
+	float Z = lab_f<precision>(z);
+	Color c;
+	c.lab.L = (116 * Y) - 16;
+	c.lab.a = 500 * (X - Y);
+	c.lab.b = 200 * (Y - Z);
+	if (space == ColorPipelineSpace::lch)
+		color_lab_to_lch(&c, b);
+	else
+		*b = c;
+}
+
+template<ColorPipelineSpace space>
+static inline void start_lab(const Color* a, float *x, float *y, float *z)
+{
+	Color c;
+	if (space == ColorPipelineSpace::lch)
+		color_lch_to_lab(a, &c);
+	else
+		c = *a;
+	float fy = (c.lab.L + 16) / 116;
+	*x = lab_f_inverse(c.lab.a / 500 + fy);
+	*y = c.lab.L > Kappa * Epsilon ? fy * fy * fy : c.lab.L / Kappa;
+	*z = lab_f_inverse(fy - c.lab.b / 200);
+}
+
+template<ColorPipelineSpace space, ColorPipelinePrecision precision>
+ColorFromRgbPipeline<space, precision>::ColorFromRgbPipeline(ReferenceIlluminant illuminant, ReferenceObserver observer)
+{
+	const vector3 *reference_white = color_get_reference(illuminant, observer);
+	matrix3x3 adaptation_matrix;
+	color_get_chromatic_adaptation_matrix(color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2), reference_white, &adaptation_matrix);
+	build_forward_matrix(reference_white, color_get_sRGB_transformation_matrix(), &adaptation_matrix, &m_matrix);
+}
+
+template<ColorPipelineSpace space, ColorPipelinePrecision precision>
+ColorFromRgbPipeline<space, precision>::ColorFromRgbPipeline(const vector3* reference_white, const matrix3x3* transformation, const matrix3x3* adaptation_matrix)
+{
+	build_forward_matrix(reference_white, transformation, adaptation_matrix, &m_matrix);
+}
+
+template<ColorPipelineSpace space, ColorPipelinePrecision precision>
+void ColorFromRgbPipeline<space, precision>::operator()(const Color* a, Color* b) const
+{
+	vector3 v;
+	v.x = to_linear<precision>(a->rgb.red);
+	v.y = to_linear<precision>(a->rgb.green);
+	v.z = to_linear<precision>(a->rgb.blue);
+	vector3_multiply_matrix3x3(&v, &m_matrix, &v);
+	finish_lab<space, precision>(v.x, v.y, v.z, b);
+}
+
+template<ColorPipelineSpace space, ColorPipelinePrecision precision>
+void ColorFromRgbPipeline<space, precision>::operator()(const Color* a, Color* b, size_t count) const
+{
+	float x[ChunkSize], y[ChunkSize], z[ChunkSize];
+	for (size_t offset = 0; offset < count; offset += ChunkSize){
+		size_t n = std::min(ChunkSize, count - offset);
+		for (size_t i = 0; i < n; i++){
+			x[i] = to_linear<precision>(a[offset + i].rgb.red);
+			y[i] = to_linear<precision>(a[offset + i].rgb.green);
+			z[i] = to_linear<precision>(a[offset + i].rgb.blue);
+		}
+		vector3_multiply_matrix3x3_batch(x, y, z, n, &m_matrix, x, y, z);
+		for (size_t i = 0; i < n; i++){
+			finish_lab<space, precision>(x[i], y[i], z[i], &b[offset + i]);
+		}
+	}
+}
+
+template<ColorPipelineSpace space, ColorPipelinePrecision precision>
+ColorToRgbPipeline<space, precision>::ColorToRgbPipeline(ReferenceIlluminant illuminant, ReferenceObserver observer)
+{
+	const vector3 *reference_white = color_get_reference(illuminant, observer);
+	matrix3x3 adaptation_matrix;
+	color_get_chromatic_adaptation_matrix(reference_white, color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2), &adaptation_matrix);
+	build_inverse_matrix(reference_white, color_get_inverted_sRGB_transformation_matrix(), &adaptation_matrix, &m_matrix);
+}
+
+template<ColorPipelineSpace space, ColorPipelinePrecision precision>
+ColorToRgbPipeline<space, precision>::ColorToRgbPipeline(const vector3* reference_white, const matrix3x3* transformation_inverted, const matrix3x3* adaptation_matrix_inverted)
+{
+	build_inverse_matrix(reference_white, transformation_inverted, adaptation_matrix_inverted, &m_matrix);
+}
+
+template<ColorPipelineSpace space, ColorPipelinePrecision precision>
+void ColorToRgbPipeline<space, precision>::operator()(const Color* a, Color* b) const
+{
+	vector3 v;
+	start_lab<space>(a, &v.x, &v.y, &v.z);
+	vector3_multiply_matrix3x3(&v, &m_matrix, &v);
+	b->rgb.red = from_linear<precision>(v.x);
+	b->rgb.green = from_linear<precision>(v.y);
+	b->rgb.blue = from_linear<precision>(v.z);
+}
+
+template<ColorPipelineSpace space, ColorPipelinePrecision precision>
+void ColorToRgbPipeline<space, precision>::operator()(const Color* a, Color* b, size_t count) const
+{
+	float x[ChunkSize], y[ChunkSize], z[ChunkSize];
+	for (size_t offset = 0; offset < count; offset += ChunkSize){
+		size_t n = std::min(ChunkSize, count - offset);
+		for (size_t i = 0; i < n; i++){
+			start_lab<space>(&a[offset + i], &x[i], &y[i], &z[i]);
+		}
+		vector3_multiply_matrix3x3_batch(x, y, z, n, &m_matrix, x, y, z);
+		for (size_t i = 0; i < n; i++){
+			b[offset + i].rgb.red = from_linear<precision>(x[i]);
+			b[offset + i].rgb.green = from_linear<precision>(y[i]);
+			b[offset + i].rgb.blue = from_linear<precision>(z[i]);
+		}
+	}
+}
+
+template struct ColorFromRgbPipeline<ColorPipelineSpace::lab, ColorPipelinePrecision::exact>;
+template struct ColorFromRgbPipeline<ColorPipelineSpace::lch, ColorPipelinePrecision::exact>;
+template struct ColorFromRgbPipeline<ColorPipelineSpace::lab, ColorPipelinePrecision::fast>;
+template struct ColorFromRgbPipeline<ColorPipelineSpace::lch, ColorPipelinePrecision::fast>;
+template struct ColorToRgbPipeline<ColorPipelineSpace::lab, ColorPipelinePrecision::exact>;
+template struct ColorToRgbPipeline<ColorPipelineSpace::lch, ColorPipelinePrecision::exact>;
+template struct ColorToRgbPipeline<ColorPipelineSpace::lab, ColorPipelinePrecision::fast>;
+template struct ColorToRgbPipeline<ColorPipelineSpace::lch, ColorPipelinePrecision::fast>;
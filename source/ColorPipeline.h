@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_COLOR_PIPELINE_H_
+#define GPICK_COLOR_PIPELINE_H_
+
+#include "Color.h"
+#include <stddef.h>
+
+/** \file source/ColorPipeline.h
+ * \brief Conversion pipelines between RGB and Lab/LCH color spaces with precomputed fused matrices.
+ *
+ * Working space transformation, chromatic adaptation and division by reference white are composed into
+ * a single matrix when pipeline is constructed, so every conversion does one matrix multiplication.
+ * Pipelines are plain values and can be copied freely. They must be constructed after color_init().
+ */
+
+/** \enum ColorPipelineSpace
+ * \brief Color space on the non-RGB side of a pipeline.
+ */
+enum class ColorPipelineSpace
+{
+	lab,
+	lch,
+};
+
+/** \enum ColorPipelinePrecision
+ * \brief Selects exact or lookup table based conversion.
+ * Fast pipelines use color_srgb_to_linear_fast(), color_linear_to_srgb_fast() and color_lab_f_fast().
+ */
+enum class ColorPipelinePrecision
+{
+	exact,
+	fast,
+};
+
+/** \struct ColorFromRgbPipeline
+ * \brief Converts RGB colors to Lab or LCH color space.
+ */
+template<ColorPipelineSpace space, ColorPipelinePrecision precision>
+struct ColorFromRgbPipeline
+{
+	/**
+	 * Create pipeline using sRGB transformation matrix and adaptation from D65 to selected reference white.
+	 * @param[in] illuminant Destination illuminant.
+	 * @param[in] observer Destination observer.
+	 */
+	ColorFromRgbPipeline(ReferenceIlluminant illuminant = REFERENCE_ILLUMINANT_D50, ReferenceObserver observer = REFERENCE_OBSERVER_2);
+
+	/**
+	 * Create pipeline using custom matrices.
+	 * @param[in] reference_white Reference white.
+	 * @param[in] transformation Working space transformation matrix.
+	 * @param[in] adaptation_matrix Chromatic adaptation matrix.
+	 */
+	ColorFromRgbPipeline(const vector3* reference_white, const matrix3x3* transformation, const matrix3x3* adaptation_matrix);
+
+	/**
+	 * Convert single color.
+	 * @param[in] a Source color in RGB color space.
+	 * @param[out] b Destination color.
+	 */
+	void operator()(const Color* a, Color* b) const;
+
+	/**
+	 * Convert a number of colors. Source and destination can be the same array.
+	 * @param[in] a Source colors in RGB color space.
+	 * @param[out] b Destination colors.
+	 * @param[in] count Number of colors.
+	 */
+	void operator()(const Color* a, Color* b, size_t count) const;
+
+	private:
+	matrix3x3 m_matrix;
+};
+
+/** \struct ColorToRgbPipeline
+ * \brief Converts Lab or LCH colors to RGB color space.
+ */
+template<ColorPipelineSpace space, ColorPipelinePrecision precision>
+struct ColorToRgbPipeline
+{
+	/**
+	 * Create pipeline using inverted sRGB transformation matrix and adaptation from selected reference white to D65.
+	 * @param[in] illuminant Source illuminant.
+	 * @param[in] observer Source observer.
+	 */
+	ColorToRgbPipeline(ReferenceIlluminant illuminant = REFERENCE_ILLUMINANT_D50, ReferenceObserver observer = REFERENCE_OBSERVER_2);
+
+	/**
+	 * Create pipeline using custom matrices.
+	 * @param[in] reference_white Reference white.
+	 * @param[in] transformation_inverted Inverted working space transformation matrix.
+	 * @param[in] adaptation_matrix_inverted Inverted chromatic adaptation matrix.
+	 */
+	ColorToRgbPipeline(const vector3* reference_white, const matrix3x3* transformation_inverted, const matrix3x3* adaptation_matrix_inverted);
+
+	/**
+	 * Convert single color.
+	 * @param[in] a Source color.
+	 * @param[out] b Destination color in RGB color space.
+	 */
+	void operator()(const Color* a, Color* b) const;
+
+	/**
+	 * Convert a number of colors. Source and destination can be the same array.
+	 * @param[in] a Source colors.
+	 * @param[out] b Destination colors in RGB color space.
+	 * @param[in] count Number of colors.
+	 */
+	void operator()(const Color* a, Color* b, size_t count) const;
+
+	private:
+	matrix3x3 m_matrix;
+};
+
+typedef ColorFromRgbPipeline<ColorPipelineSpace::lab, ColorPipelinePrecision::exact> RgbToLabPipeline;
+typedef ColorFromRgbPipeline<ColorPipelineSpace::lch, ColorPipelinePrecision::exact> RgbToLchPipeline;
+typedef ColorFromRgbPipeline<ColorPipelineSpace::lab, ColorPipelinePrecision::fast> RgbToLabFastPipeline;
+typedef ColorFromRgbPipeline<ColorPipelineSpace::lch, ColorPipelinePrecision::fast> RgbToLchFastPipeline;
+typedef ColorToRgbPipeline<ColorPipelineSpace::lab, ColorPipelinePrecision::exact> LabToRgbPipeline;
+typedef ColorToRgbPipeline<ColorPipelineSpace::lch, ColorPipelinePrecision::exact> LchToRgbPipeline;
+typedef ColorToRgbPipeline<ColorPipelineSpace::lab, ColorPipelinePrecision::fast> LabToRgbFastPipeline;
+typedef ColorToRgbPipeline<ColorPipelineSpace::lch, ColorPipelinePrecision::fast> LchToRgbFastPipeline;
+
+#endif /* GPICK_COLOR_PIPELINE_H_ */
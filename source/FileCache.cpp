@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "FileCache.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+using namespace std;
+
+const size_t HashChunkSize = 64 * 1024;
+const uint64_t HashSeed = 14695981039346656037ULL;
+
+static uint64_t hash_data(uint64_t hash, const char *data, size_t size)
+{
+	// 64-bit FNV-1a
+	for (size_t i = 0; i < size; i++){
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+/**
+ * Hash data in 64-bit blocks. Only used to detect changed files, so multiply-rotate mixing is sufficient and several times faster than byte-at-a-time FNV.
+ * Chunks must be a multiple of 8 bytes long, except for the last one.
+ */
+static uint64_t hash_blocks(uint64_t hash, const char *data, size_t size)
+{
+	size_t blocks = size / 8;
+	for (size_t i = 0; i < blocks; i++){
+		uint64_t block;
+		memcpy(&block, data + i * 8, 8);
+		hash ^= block * 0x9e3779b97f4a7c15ULL;
+		hash = ((hash << 27) | (hash >> 37)) * 0xff51afd7ed558ccdULL;
+	}
+	return hash_data(hash, data + blocks * 8, size - blocks * 8);
+}
+void file_cache_header_init(FileCacheHeader &header, const char *magic, uint32_t version, const FileCacheSource &source)
+{
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, magic, sizeof(header.magic));
+	header.version = version;
+	header.byte_order = FileCacheByteOrder;
+	header.source_size = source.size;
+	header.source_modification_time = source.modification_time;
+	header.source_hash = source.hash;
+}
+bool file_cache_header_check(const FileCacheHeader &header, const char *magic, uint32_t version)
+{
+	return memcmp(header.magic, magic, sizeof(header.magic)) == 0 && header.version == version && header.byte_order == FileCacheByteOrder;
+}
+bool file_cache_source_stat(const char *filename, FileCacheSource &source)
+{
+	GStatBuf sb;
+	if (g_stat(filename, &sb) != 0) return false;
+	source.size = sb.st_size;
+	int64_t nanoseconds = 0;
+#if defined(__APPLE__)
+	nanoseconds = sb.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+	nanoseconds = sb.st_mtim.tv_nsec;
+#endif
+	source.modification_time = int64_t(sb.st_mtime) * 1000000000 + nanoseconds;
+	source.hash = 0;
+	return true;
+}
+uint64_t file_cache_hash(const char *data, size_t size)
+{
+	return hash_blocks(HashSeed, data, size);
+}
+bool file_cache_hash_file(const char *filename, uint64_t &hash)
+{
+	ifstream file(filename, ios::binary);
+	if (!file.is_open()) return false;
+	vector<char> buffer(HashChunkSize);
+	hash = HashSeed;
+	while (file.good()){
+		file.read(buffer.data(), buffer.size());
+		hash = hash_blocks(hash, buffer.data(), file.gcount());
+	}
+	return !file.bad();
+}
+string file_cache_name(const char *filename, const void *key, size_t key_size)
+{
+	gchar *absolute_path;
+	if (g_path_is_absolute(filename)){
+		absolute_path = g_strdup(filename);
+	}else{
+		gchar *current_dir = g_get_current_dir();
+		absolute_path = g_build_filename(current_dir, filename, nullptr);
+		g_free(current_dir);
+	}
+	uint64_t hash = hash_data(HashSeed, absolute_path, strlen(absolute_path));
+	hash = hash_data(hash, static_cast<const char*>(key), key_size);
+	g_free(absolute_path);
+	stringstream name;
+	name << hex << setw(16) << setfill('0') << hash;
+	return name.str();
+}
+bool file_cache_write(const char *cache_filename, const function<void(ostream &file)> &write)
+{
+	// unique temporary file name, so that concurrent saves of the same cache file do not write into the same file
+	string tmp_filename = string(cache_filename) + ".XXXXXX";
+	int fd = g_mkstemp(&tmp_filename[0]);
+	if (fd == -1) return false;
+	g_close(fd, nullptr);
+	ofstream file(tmp_filename.c_str(), ios::binary | ios::trunc);
+	if (!file.is_open()){
+		g_remove(tmp_filename.c_str());
+		return false;
+	}
+	write(file);
+	file.close();
+	if (!file.good()){
+		g_remove(tmp_filename.c_str());
+		return false;
+	}
+	if (g_rename(tmp_filename.c_str(), cache_filename) != 0){
+		// rename does not replace existing files on some platforms
+		g_remove(cache_filename);
+		if (g_rename(tmp_filename.c_str(), cache_filename) != 0){
+			g_remove(tmp_filename.c_str());
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_FILE_CACHE_H_
+#define GPICK_FILE_CACHE_H_
+#include <functional>
+#include <ostream>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+/** \file source/FileCache.h
+ * \brief Helpers shared by binary cache files built from source files.
+ *
+ * Each cache file starts with FileCacheHeader, which identifies cache format and the source file the cache was built from.
+ * Cache files are written under temporary name and renamed, so concurrently running instances never see partially written cache.
+ */
+
+/** Byte order marker. Cache is only valid on machines with the same byte order. */
+const uint32_t FileCacheByteOrder = 0x01020304;
+
+/** \struct FileCacheSource
+ * \brief Identification of a source file used to validate cache file.
+ */
+struct FileCacheSource
+{
+	uint64_t size;
+	int64_t modification_time; /**< Nanoseconds since epoch, sub-second part is zero where file system or platform does not provide it */
+	uint64_t hash; /**< Hash of file contents, zero if not calculated */
+};
+
+/** \struct FileCacheHeader
+ * \brief Common beginning of cache file header.
+ */
+struct FileCacheHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint64_t source_size;
+	int64_t source_modification_time;
+	uint64_t source_hash;
+};
+
+/**
+ * Fill cache file header.
+ * @param[out] header Cache file header.
+ * @param[in] magic Cache format identifier, 8 bytes.
+ * @param[in] version Cache format version.
+ * @param[in] source Source file information.
+ */
+void file_cache_header_init(FileCacheHeader &header, const char *magic, uint32_t version, const FileCacheSource &source);
+
+/**
+ * Check cache format identifier, version and byte order.
+ * @param[in] header Cache file header.
+ * @param[in] magic Cache format identifier, 8 bytes.
+ * @param[in] version Cache format version.
+ * @return True if cache file can be read by this build.
+ */
+bool file_cache_header_check(const FileCacheHeader &header, const char *magic, uint32_t version);
+
+/**
+ * Get size and modification time of a source file.
+ * @param[in] filename Source file name.
+ * @param[out] source Source information. Hash is set to zero.
+ * @return True on success.
+ */
+bool file_cache_source_stat(const char *filename, FileCacheSource &source);
+
+/**
+ * Calculate hash of source file contents.
+ * Only used to detect changed files, gives the same value as file_cache_hash_file for the same contents.
+ * @param[in] data Source file contents.
+ * @param[in] size Size of data.
+ * @return Hash value.
+ */
+uint64_t file_cache_hash(const char *data, size_t size);
+
+/**
+ * Calculate hash of source file contents without loading the whole file into memory.
+ * @param[in] filename Source file name.
+ * @param[out] hash Hash value.
+ * @return True on success.
+ */
+bool file_cache_hash_file(const char *filename, uint64_t &hash);
+
+/**
+ * Build cache file name part identifying a source file and cache parameters.
+ * @param[in] filename Source file name. Relative names are resolved against current directory.
+ * @param[in] key Additional data identifying cache contents, can be nullptr.
+ * @param[in] key_size Size of additional data.
+ * @return 16 hexadecimal digits.
+ */
+std::string file_cache_name(const char *filename, const void *key = nullptr, size_t key_size = 0);
+
+/**
+ * Write cache file atomically.
+ * Data is written into a unique temporary file, which then replaces cache file.
+ * @param[in] cache_filename Cache file name.
+ * @param[in] write Function writing cache file contents into a stream.
+ * @return True on success.
+ */
+bool file_cache_write(const char *cache_filename, const std::function<void(std::ostream &file)> &write);
+
+#endif /* GPICK_FILE_CACHE_H_ */
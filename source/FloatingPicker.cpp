@@ -31,7 +31,9 @@
 #include "DynvHelpers.h"
 #include "ToolColorNaming.h"
 #include "ScreenReader.h"
+#include "PickerTimings.h"
 #include "Sampler.h"
+#include "RefreshScheduler.h"
 #include "color_names/ColorNames.h"
 #include <gdk/gdkkeysyms.h>
 #include <string>
@@ -44,7 +46,7 @@ typedef struct FloatingPickerArgs
 	GtkWidget* window;
 	GtkWidget* zoomed;
 	GtkWidget* color_widget;
-	guint timeout_source_id;
+	RefreshScheduler *refresh_scheduler;
 	ColorSource *color_source;
 	Converter *converter;
 	GlobalState* gs;
@@ -77,18 +79,16 @@ struct PickerColorNameAssigner: public ToolColorNameAssigner
 			return m_stream.str();
 		}
 };
-static void get_color_sample(FloatingPickerArgs *args, bool update_widgets, Color* c)
+/** Sample color under pointer and optionally update zoomed view.
+ * When only_if_changed is set, nothing is sampled if pointer did not move and screen contents around it did not change.
+ */
+static ScreenReaderUpdate get_color_sample(FloatingPickerArgs *args, bool update_widgets, bool only_if_changed, Color* c)
 {
 	GdkScreen *screen;
-	GdkModifierType state;
-	int x, y;
-	gdk_display_get_pointer(gdk_display_get_default(), &screen, &x, &y, &state);
-	int monitor = gdk_screen_get_monitor_at_point(screen, x, y);
-	GdkRectangle monitor_geometry;
-	gdk_screen_get_monitor_geometry(screen, monitor, &monitor_geometry);
-	Vec2<int> pointer(x,y);
-	Rect2<int> screen_rect(monitor_geometry.x, monitor_geometry.y, monitor_geometry.x + monitor_geometry.width, monitor_geometry.y + monitor_geometry.height);
+	Vec2<int> pointer;
+	Rect2<int> screen_rect;
 	auto screen_reader = args->gs->getScreenReader();
+	screen_reader_get_pointer(screen_reader, &screen, pointer, screen_rect);
 	screen_reader_reset_rect(screen_reader);
 	Rect2<int> sampler_rect, zoomed_rect, final_rect;
 	sampler_get_screen_rect(args->gs->getSampler(), pointer, screen_rect, &sampler_rect);
@@ -97,17 +97,29 @@ static void get_color_sample(FloatingPickerArgs *args, bool update_widgets, Colo
 		gtk_zoomed_get_screen_rect(GTK_ZOOMED(args->zoomed), pointer, screen_rect, &zoomed_rect);
 		screen_reader_add_rect(screen_reader, screen, zoomed_rect);
 	}
-	screen_reader_update_surface(screen_reader, &final_rect);
+	ScreenReaderUpdate update = ScreenReaderUpdate::area_changed;
+	if (only_if_changed){
+		update = screen_reader_update_surface_if_changed(screen_reader, &final_rect);
+		if (update == ScreenReaderUpdate::skipped) return update;
+	}else{
+		screen_reader_update_surface(screen_reader, &final_rect);
+	}
 	Vec2<int> offset;
 	offset = Vec2<int>(sampler_rect.getX() - final_rect.getX(), sampler_rect.getY() - final_rect.getY());
 	sampler_get_color_sample(args->gs->getSampler(), pointer, screen_rect, offset, c);
 	if (update_widgets){
 		offset = Vec2<int>(zoomed_rect.getX() - final_rect.getX(), zoomed_rect.getY() - final_rect.getY());
+		PickerStageTimer timer(PickerStage::zoomed_update);
 		gtk_zoomed_update(GTK_ZOOMED(args->zoomed), pointer, screen_rect, offset, screen_reader_get_surface(screen_reader));
 	}
+	return update;
 }
-static gboolean update_display(FloatingPickerArgs *args)
+/** Move picker window next to pointer and update displayed color.
+ * Returns true if pointer moved or screen contents changed.
+ */
+static bool update_display(FloatingPickerArgs *args, bool only_if_changed)
 {
+	PickerStageTimer timer(PickerStage::tick);
 	GdkScreen *screen;
 	GdkModifierType state;
 	int x, y;
@@ -132,16 +144,22 @@ static gboolean update_display(FloatingPickerArgs *args)
 	}
 	gtk_window_move(GTK_WINDOW(args->window), x, y);
 	Color c;
-	get_color_sample(args, true, &c);
+	ScreenReaderUpdate update = get_color_sample(args, true, only_if_changed, &c);
+	if (update == ScreenReaderUpdate::skipped){
+		timer.discard();
+		return false;
+	}
 	string text;
 	auto converter = args->converter;
 	if (!converter){
 		converter = args->gs->converters().display();
 	}
-	if (converter)
+	if (converter){
+		PickerStageTimer serialize_timer(PickerStage::serialize);
 		text = converter->serialize(c);
+	}
 	gtk_color_set_color(GTK_COLOR(args->color_widget), &c, text.c_str());
-	return true;
+	return update == ScreenReaderUpdate::area_changed || update == ScreenReaderUpdate::damaged;
 }
 void floating_picker_activate(FloatingPickerArgs *args, bool hide_on_mouse_release, bool single_pick_mode, const char *converter_name)
 {
@@ -160,12 +178,15 @@ void floating_picker_activate(FloatingPickerArgs *args, bool hide_on_mouse_relea
 	else
 		cursor = gdk_cursor_new(GDK_TCROSS);
 	gtk_zoomed_set_zoom(GTK_ZOOMED(args->zoomed), dynv_get_float_wd(args->gs->getSettings(), "gpick.picker.zoom", 2));
-	update_display(args);
+	update_display(args, false);
 	gtk_widget_show(args->window);
 	gdk_pointer_grab(gtk_widget_get_window(args->window), false, GdkEventMask(GDK_POINTER_MOTION_MASK | GDK_BUTTON_RELEASE_MASK | GDK_BUTTON_PRESS_MASK), nullptr, cursor, GDK_CURRENT_TIME);
 	gdk_keyboard_grab(gtk_widget_get_window(args->window), false, GDK_CURRENT_TIME);
 	float refresh_rate = dynv_get_float_wd(args->gs->getSettings(), "gpick.picker.refresh_rate", 30);
-	args->timeout_source_id = g_timeout_add_full(G_PRIORITY_DEFAULT_IDLE, 1000 / refresh_rate, (GSourceFunc)update_display, args, (GDestroyNotify)nullptr);
+	if (args->refresh_scheduler) refresh_scheduler_destroy(args->refresh_scheduler);
+	args->refresh_scheduler = refresh_scheduler_new(refresh_rate, [args]() {
+		return update_display(args, true);
+	});
 #if GTK_MAJOR_VERSION >= 3
 	g_object_unref(cursor);
 #else
@@ -177,9 +198,9 @@ void floating_picker_deactivate(FloatingPickerArgs *args)
 {
 	gdk_pointer_ungrab(GDK_CURRENT_TIME);
 	gdk_keyboard_ungrab(GDK_CURRENT_TIME);
-	if (args->timeout_source_id > 0){
-		g_source_remove(args->timeout_source_id);
-		args->timeout_source_id = 0;
+	if (args->refresh_scheduler){
+		refresh_scheduler_destroy(args->refresh_scheduler);
+		args->refresh_scheduler = nullptr;
 	}
 	gtk_widget_hide(args->window);
 }
@@ -192,8 +213,14 @@ static gboolean scroll_event_cb(GtkWidget *widget, GdkEventScroll *event, Floati
 		zoom -= 1;
 	}
 	gtk_zoomed_set_zoom(GTK_ZOOMED(args->zoomed), zoom);
+	if (args->refresh_scheduler) refresh_scheduler_wake(args->refresh_scheduler);
 	return TRUE;
 }
+static gboolean motion_notify_cb(GtkWidget *widget, GdkEventMotion *event, FloatingPickerArgs *args)
+{
+	if (args->refresh_scheduler) refresh_scheduler_wake(args->refresh_scheduler);
+	return FALSE;
+}
 static void finish_picking(FloatingPickerArgs *args)
 {
 	floating_picker_deactivate(args);
@@ -205,7 +232,7 @@ static void complete_picking(FloatingPickerArgs *args)
 {
 	if (args->release_mode || args->click_mode){
 		Color c;
-		get_color_sample(args, false, &c);
+		get_color_sample(args, false, false, &c);
 		if (args->perform_custom_pick_action){
 			if (args->custom_pick_action)
 				args->custom_pick_action(args, c);
@@ -237,7 +264,7 @@ static void complete_picking(FloatingPickerArgs *args)
 static void show_copy_menu(int button, int event_time, FloatingPickerArgs *args)
 {
 	Color c;
-	get_color_sample(args, false, &c);
+	get_color_sample(args, false, false, &c);
 	GtkWidget *menu;
 	ColorList *color_list = color_list_new_with_one_color(args->gs->getColorList(), &c);
 	menu = CopyMenu::newMenu(*color_list->colors.begin(), args->gs);
@@ -337,6 +364,7 @@ static gboolean key_up_cb(GtkWidget *widget, GdkEventKey *event, FloatingPickerA
 }
 static void destroy_cb(GtkWidget *widget, FloatingPickerArgs *args)
 {
+	if (args->refresh_scheduler) refresh_scheduler_destroy(args->refresh_scheduler);
 	delete args;
 }
 FloatingPickerArgs* floating_picker_new(GlobalState *gs)
@@ -345,6 +373,7 @@ FloatingPickerArgs* floating_picker_new(GlobalState *gs)
 	args->gs = gs;
 	args->window = gtk_window_new(GTK_WINDOW_POPUP);
 	args->color_source = nullptr;
+	args->refresh_scheduler = nullptr;
 	args->perform_custom_pick_action = false;
 	args->menu_button_pressed = false;
 	gtk_window_set_skip_pager_hint(GTK_WINDOW(args->window), true);
@@ -364,6 +393,7 @@ FloatingPickerArgs* floating_picker_new(GlobalState *gs)
 	g_signal_connect(G_OBJECT(args->window), "button-press-event", G_CALLBACK(button_press_cb), args);
 	g_signal_connect(G_OBJECT(args->window), "button-release-event", G_CALLBACK(button_release_cb), args);
 	g_signal_connect(G_OBJECT(args->window), "key_press_event", G_CALLBACK(key_up_cb), args);
+	g_signal_connect(G_OBJECT(args->window), "motion-notify-event", G_CALLBACK(motion_notify_cb), args);
 	g_signal_connect(G_OBJECT(args->window), "destroy", G_CALLBACK(destroy_cb), args);
 	return args;
 }
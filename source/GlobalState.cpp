@@ -176,7 +176,7 @@ struct GlobalState::Impl
 		if (m_color_names != nullptr) return false;
 		m_color_names = color_names_new();
 		dynvSystem *params = dynv_get_dynv(m_settings, "gpick");
-		color_names_load(m_color_names, params);
+		color_names_load_async(m_color_names, params);
 		dynv_system_release(params);
 		return true;
 	}
@@ -301,6 +301,14 @@ struct GlobalState::Impl
 		m_transformation_chain = chain;
 		return true;
 	}
+	bool loadConvertersOnly()
+	{
+		checkConfigurationDirectory();
+		loadSettings();
+		initializeLua();
+		loadConverters();
+		return true;
+	}
 	bool loadAll()
 	{
 		checkConfigurationDirectory();
@@ -333,6 +341,10 @@ bool GlobalState::loadAll()
 {
 	return m_impl->loadAll();
 }
+bool GlobalState::loadConverters()
+{
+	return m_impl->loadConvertersOnly();
+}
 bool GlobalState::writeSettings()
 {
 	return m_impl->writeSettings();
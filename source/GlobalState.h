@@ -45,6 +45,8 @@ struct GlobalState
 	~GlobalState();
 	bool loadSettings();
 	bool loadAll();
+	/** Load only settings, scripts and converters, as needed by command line tools */
+	bool loadConverters();
 	bool writeSettings();
 	ColorNames *getColorNames();
 	Sampler *getSampler();
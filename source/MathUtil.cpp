@@ -19,6 +19,37 @@
 #include "MathUtil.h"
 #include <math.h>
 #include <string.h>
+#include <atomic>
+#ifdef GPICK_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+static std::atomic<int> simd_max_level(static_cast<int>(SimdLevel::avx2));
+
+static SimdLevel simd_detect_level()
+{
+#ifdef GPICK_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return SimdLevel::avx2;
+#if defined(__x86_64__) || defined(__SSE2__)
+	return SimdLevel::sse2;
+#else
+	if (__builtin_cpu_supports("sse2")) return SimdLevel::sse2;
+#endif
+#endif
+	return SimdLevel::scalar;
+}
+
+SimdLevel simd_get_level()
+{
+	static SimdLevel supported = simd_detect_level();
+	return static_cast<SimdLevel>(min_int(static_cast<int>(supported), simd_max_level.load(std::memory_order_relaxed)));
+}
+
+void simd_set_max_level(SimdLevel level)
+{
+	simd_max_level = static_cast<int>(level);
+}
 
 float max_float_3(float a, float b, float c) {
 	if (a > b){
@@ -270,3 +301,93 @@ void vector3_clamp(vector3* vector, float a, float b){
 	vector->y = clamp_float(vector->y, a, b);
 	vector->z = clamp_float(vector->z, a, b);
 }
+
+static void multiply_batch_scalar(const float *x, const float *y, const float *z, size_t count, const matrix3x3 *matrix, float *out_x, float *out_y, float *out_z)
+{
+	for (size_t i = 0; i < count; i++){
+		float vx = x[i], vy = y[i], vz = z[i];
+		out_x[i] = vx * matrix->m[0][0] + vy * matrix->m[0][1] + vz * matrix->m[0][2];
+		out_y[i] = vx * matrix->m[1][0] + vy * matrix->m[1][1] + vz * matrix->m[1][2];
+		out_z[i] = vx * matrix->m[2][0] + vy * matrix->m[2][1] + vz * matrix->m[2][2];
+	}
+}
+
+#ifdef GPICK_X86_KERNELS
+/* SIMD kernels use double precision arithmetic and the same operation order as vector3_multiply_matrix3x3,
+ * so results are bit-identical to the scalar path. FMA is deliberately not enabled, as contracted multiply-add
+ * would round differently.
+ */
+GPICK_TARGET("sse2")
+static void multiply_batch_sse2(const float *x, const float *y, const float *z, size_t count, const matrix3x3 *matrix, float *out_x, float *out_y, float *out_z)
+{
+	__m128d m[3][3];
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			m[i][j] = _mm_set1_pd(matrix->m[i][j]);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4){
+		__m128 fx = _mm_loadu_ps(x + i), fy = _mm_loadu_ps(y + i), fz = _mm_loadu_ps(z + i);
+		__m128d vx[2] = {_mm_cvtps_pd(fx), _mm_cvtps_pd(_mm_movehl_ps(fx, fx))};
+		__m128d vy[2] = {_mm_cvtps_pd(fy), _mm_cvtps_pd(_mm_movehl_ps(fy, fy))};
+		__m128d vz[2] = {_mm_cvtps_pd(fz), _mm_cvtps_pd(_mm_movehl_ps(fz, fz))};
+		__m128 r[3];
+		for (int j = 0; j < 3; j++){
+			__m128d low = _mm_add_pd(_mm_add_pd(_mm_mul_pd(vx[0], m[j][0]), _mm_mul_pd(vy[0], m[j][1])), _mm_mul_pd(vz[0], m[j][2]));
+			__m128d high = _mm_add_pd(_mm_add_pd(_mm_mul_pd(vx[1], m[j][0]), _mm_mul_pd(vy[1], m[j][1])), _mm_mul_pd(vz[1], m[j][2]));
+			r[j] = _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+		}
+		_mm_storeu_ps(out_x + i, r[0]);
+		_mm_storeu_ps(out_y + i, r[1]);
+		_mm_storeu_ps(out_z + i, r[2]);
+	}
+	multiply_batch_scalar(x + i, y + i, z + i, count - i, matrix, out_x + i, out_y + i, out_z + i);
+}
+
+GPICK_TARGET("avx2")
+static void multiply_batch_avx2(const float *x, const float *y, const float *z, size_t count, const matrix3x3 *matrix, float *out_x, float *out_y, float *out_z)
+{
+	__m256d m[3][3];
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			m[i][j] = _mm256_set1_pd(matrix->m[i][j]);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8){
+		__m256 fx = _mm256_loadu_ps(x + i), fy = _mm256_loadu_ps(y + i), fz = _mm256_loadu_ps(z + i);
+		__m256d vx[2] = {_mm256_cvtps_pd(_mm256_castps256_ps128(fx)), _mm256_cvtps_pd(_mm256_extractf128_ps(fx, 1))};
+		__m256d vy[2] = {_mm256_cvtps_pd(_mm256_castps256_ps128(fy)), _mm256_cvtps_pd(_mm256_extractf128_ps(fy, 1))};
+		__m256d vz[2] = {_mm256_cvtps_pd(_mm256_castps256_ps128(fz)), _mm256_cvtps_pd(_mm256_extractf128_ps(fz, 1))};
+		__m256 r[3];
+		for (int j = 0; j < 3; j++){
+			__m256d low = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(vx[0], m[j][0]), _mm256_mul_pd(vy[0], m[j][1])), _mm256_mul_pd(vz[0], m[j][2]));
+			__m256d high = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(vx[1], m[j][0]), _mm256_mul_pd(vy[1], m[j][1])), _mm256_mul_pd(vz[1], m[j][2]));
+			r[j] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(low)), _mm256_cvtpd_ps(high), 1);
+		}
+		_mm256_storeu_ps(out_x + i, r[0]);
+		_mm256_storeu_ps(out_y + i, r[1]);
+		_mm256_storeu_ps(out_z + i, r[2]);
+	}
+	multiply_batch_sse2(x + i, y + i, z + i, count - i, matrix, out_x + i, out_y + i, out_z + i);
+}
+#endif
+
+typedef void (*MultiplyBatchKernel)(const float *x, const float *y, const float *z, size_t count, const matrix3x3 *matrix, float *out_x, float *out_y, float *out_z);
+static MultiplyBatchKernel multiply_batch = multiply_batch_scalar;
+static const char *multiply_batch_name = "scalar";
+
+void matrix3x3_init_batch_kernels()
+{
+	// Kernels of all levels are compiled on x86, elsewhere level is always scalar
+	SimdLevel level = simd_get_level();
+	multiply_batch = simd_select<MultiplyBatchKernel>(multiply_batch_scalar, GPICK_KERNEL(multiply_batch_sse2), GPICK_KERNEL(multiply_batch_avx2));
+	multiply_batch_name = level == SimdLevel::avx2 ? "avx2" : (level == SimdLevel::sse2 ? "sse2" : "scalar");
+}
+
+const char *matrix3x3_get_batch_kernel_name()
+{
+	return multiply_batch_name;
+}
+
+void vector3_multiply_matrix3x3_batch(const float *x, const float *y, const float *z, size_t count, const matrix3x3* matrix, float *out_x, float *out_y, float *out_z)
+{
+	multiply_batch(x, y, z, count, matrix, out_x, out_y, out_z);
+}
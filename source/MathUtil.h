@@ -19,8 +19,53 @@
 #ifndef GPICK_MATH_UTIL_H_
 #define GPICK_MATH_UTIL_H_
 
+#include <stddef.h>
+
 #define PI 3.14159265
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+/** SIMD kernels for x86 processors are compiled. Files defining kernels include <immintrin.h> and mark each kernel with GPICK_TARGET. */
+#define GPICK_X86_KERNELS
+#define GPICK_TARGET(instruction_set) __attribute__((target(instruction_set)))
+/** Kernel passed to simd_select(), or nullptr on platforms where it is not compiled */
+#define GPICK_KERNEL(kernel) kernel
+#else
+#define GPICK_KERNEL(kernel) nullptr
+#endif
+
+/** Instruction sets used by SIMD kernels, in increasing order */
+enum class SimdLevel: int
+{
+	scalar = 0,
+	sse2 = 1,
+	avx2 = 2,
+};
+
+/**
+ * Get the highest instruction set supported by CPU and allowed by simd_set_max_level(). SSE2 is always available on x86_64.
+ */
+SimdLevel simd_get_level();
+
+/**
+ * Limit instruction sets used by SIMD kernels, so that kernels can be compared against scalar code.
+ */
+void simd_set_max_level(SimdLevel level);
+
+/**
+ * Select kernel for the highest usable instruction set.
+ * @param[in] scalar Portable kernel.
+ * @param[in] sse2 SSE2 kernel, nullptr if not available.
+ * @param[in] avx2 AVX2 kernel, nullptr if not available.
+ */
+template<typename Kernel>
+Kernel simd_select(Kernel scalar, Kernel sse2, Kernel avx2 = nullptr)
+{
+	SimdLevel level = simd_get_level();
+	if (avx2 && level >= SimdLevel::avx2) return avx2;
+	if (sse2 && level >= SimdLevel::sse2) return sse2;
+	return scalar;
+}
+
 float min_float_3(float a, float b, float c);
 
 float max_float_3(float a, float b, float c);
@@ -88,6 +133,23 @@ float vector3_length(const vector3* vector);
 
 void vector3_multiply_matrix3x3(const vector3* vector, const matrix3x3* matrix, vector3* result );
 
+/**
+ * Multiply a number of vectors stored as separate component arrays by matrix.
+ * Results are identical to calling vector3_multiply_matrix3x3() on every vector. Input and output arrays can be the same.
+ */
+void vector3_multiply_matrix3x3_batch(const float *x, const float *y, const float *z, size_t count, const matrix3x3* matrix, float *out_x, float *out_y, float *out_z);
+
+/**
+ * Select fastest vector3_multiply_matrix3x3_batch() implementation allowed by simd_get_level().
+ */
+void matrix3x3_init_batch_kernels();
+
+/**
+ * Get the name of selected vector3_multiply_matrix3x3_batch() implementation.
+ * @return Kernel name: "avx2", "sse2" or "scalar".
+ */
+const char *matrix3x3_get_batch_kernel_name();
+
 void vector3_clamp(vector3* vector, float a, float b);
 
 #endif /* GPICK_MATH_UTIL_H_ */
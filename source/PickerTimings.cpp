@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PickerTimings.h"
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <vector>
+using namespace std;
+
+/** Rolling window of the latest measurements of one stage */
+struct PickerStageHistory
+{
+	float samples[PickerTimingsWindow];
+	size_t next;
+	size_t size;
+	uint64_t count;
+};
+static mutex timings_mutex;
+static PickerStageHistory timings[PickerStageCount];
+static const char *stage_names[PickerStageCount] = {
+	"capture",
+	"sample",
+	"color_name",
+	"serialize",
+	"zoomed_update",
+	"tick",
+};
+const char *picker_timings_get_stage_name(PickerStage stage)
+{
+	return stage_names[static_cast<int>(stage)];
+}
+void picker_timings_add(PickerStage stage, double microseconds)
+{
+	lock_guard<mutex> lock(timings_mutex);
+	PickerStageHistory &history = timings[static_cast<int>(stage)];
+	history.samples[history.next] = static_cast<float>(microseconds);
+	history.next = (history.next + 1) % PickerTimingsWindow;
+	if (history.size < PickerTimingsWindow) history.size++;
+	history.count++;
+}
+static double percentile(vector<float> &samples, size_t permille)
+{
+	auto nth = samples.begin() + min(samples.size() - 1, samples.size() * permille / 1000);
+	nth_element(samples.begin(), nth, samples.end());
+	return *nth;
+}
+PickerStageStatistics picker_timings_get(PickerStage stage)
+{
+	vector<float> samples;
+	PickerStageStatistics statistics;
+	{
+		lock_guard<mutex> lock(timings_mutex);
+		const PickerStageHistory &history = timings[static_cast<int>(stage)];
+		samples.assign(history.samples, history.samples + history.size);
+		statistics.count = history.count;
+	}
+	statistics.window = samples.size();
+	if (samples.empty()){
+		statistics.p50 = statistics.p99 = statistics.max = 0;
+		return statistics;
+	}
+	statistics.max = *max_element(samples.begin(), samples.end());
+	statistics.p99 = percentile(samples, 990);
+	statistics.p50 = percentile(samples, 500);
+	return statistics;
+}
+void picker_timings_reset()
+{
+	lock_guard<mutex> lock(timings_mutex);
+	for (auto &history: timings){
+		history.next = 0;
+		history.size = 0;
+		history.count = 0;
+	}
+}
+string picker_timings_to_json()
+{
+	stringstream result;
+	result << setprecision(6) << "{";
+	for (int i = 0; i < PickerStageCount; i++){
+		PickerStage stage = static_cast<PickerStage>(i);
+		PickerStageStatistics statistics = picker_timings_get(stage);
+		result << (i ? ", " : "") << "\"" << picker_timings_get_stage_name(stage) << "\": {\"count\": " << statistics.count << ", \"window\": " << statistics.window << ", \"p50_us\": " << statistics.p50 << ", \"p99_us\": " << statistics.p99 << ", \"max_us\": " << statistics.max << "}";
+	}
+	result << "}";
+	return result.str();
+}
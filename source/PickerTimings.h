@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_PICKER_TIMINGS_H_
+#define GPICK_PICKER_TIMINGS_H_
+
+#include <chrono>
+#include <string>
+#include <stdint.h>
+
+/** Stages of a single color picker update */
+enum class PickerStage: int
+{
+	capture = 0, /**< Screen capture in screen_reader_update_surface() */
+	sample = 1, /**< Color sampling in sampler_get_color_sample() */
+	color_name = 2, /**< Color name lookup */
+	serialize = 3, /**< Color text serialization for color code and color space components */
+	zoomed_update = 4, /**< Zoomed view update */
+	tick = 5, /**< Whole picker update, updates skipped because nothing changed are not included */
+};
+const int PickerStageCount = 6;
+/** Latency statistics of one stage over the last PickerTimingsWindow measurements */
+struct PickerStageStatistics
+{
+	uint64_t count; /**< Number of measurements since start or reset */
+	size_t window; /**< Number of measurements used for percentiles */
+	double p50; /**< Median latency in microseconds */
+	double p99; /**< 99th percentile latency in microseconds */
+	double max; /**< Maximal latency in microseconds */
+};
+const size_t PickerTimingsWindow = 512;
+const char *picker_timings_get_stage_name(PickerStage stage);
+void picker_timings_add(PickerStage stage, double microseconds);
+PickerStageStatistics picker_timings_get(PickerStage stage);
+void picker_timings_reset();
+/** Get statistics of all stages as JSON object */
+std::string picker_timings_to_json();
+
+/** \struct PickerStageTimer
+ * \brief Measures time until the end of scope and adds it to the statistics of a stage.
+ */
+struct PickerStageTimer
+{
+	PickerStageTimer(PickerStage stage):
+		m_stage(stage),
+		m_discarded(false),
+		m_start(std::chrono::steady_clock::now())
+	{
+	}
+	~PickerStageTimer()
+	{
+		if (m_discarded) return;
+		picker_timings_add(m_stage, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_start).count());
+	}
+	/** Do not add measurement, used when stage ends without doing any work */
+	void discard()
+	{
+		m_discarded = true;
+	}
+	private:
+	PickerStage m_stage;
+	bool m_discarded;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+#endif /* GPICK_PICKER_TIMINGS_H_ */
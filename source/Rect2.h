@@ -50,6 +50,7 @@ struct Rect2
 		if (rect.empty) return *this;
 		if (empty) return rect;
 		Rect2 r;
+		r.empty = false;
 		if (x1 < rect.x1) r.x1 = x1;
 		else r.x1 = rect.x1;
 		if (y1 < rect.y1) r.y1 = y1;
@@ -89,6 +90,22 @@ struct Rect2
 		if (y1 < r.y1 || y2 > r.y2) return false;
 		return true;
 	}
+	bool intersects(const Rect2 &r) const
+	{
+		if (empty || r.empty) return false;
+		if (x2 <= r.x1 || r.x2 <= x1) return false;
+		if (y2 <= r.y1 || r.y2 <= y1) return false;
+		return true;
+	}
+	bool operator==(const Rect2 &r) const
+	{
+		if (empty || r.empty) return empty == r.empty;
+		return x1 == r.x1 && y1 == r.y1 && x2 == r.x2 && y2 == r.y2;
+	}
+	bool operator!=(const Rect2 &r) const
+	{
+		return !(*this == r);
+	}
 	Rect2 positionInside(const Rect2& rect) const
 	{
 		Rect2 r;
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "RefreshScheduler.h"
+#include <glib.h>
+#include <algorithm>
+
+/** Number of consecutive idle ticks before interval starts growing */
+const int IdleTicksBeforeBackOff = 15;
+/** Longest tick interval in milliseconds. Limits delay before pointer motion is noticed when no motion events are received. */
+const unsigned int MaxIdleInterval = 250;
+
+struct RefreshScheduler
+{
+	RefreshSchedulerCallback callback;
+	guint timeout_source_id;
+	unsigned int min_interval;
+	unsigned int interval;
+	int consecutive_idle_ticks;
+	RefreshSchedulerStatistics statistics;
+};
+static gboolean on_timeout(RefreshScheduler *scheduler);
+static void start_timeout(RefreshScheduler *scheduler, unsigned int interval)
+{
+	if (scheduler->timeout_source_id > 0)
+		g_source_remove(scheduler->timeout_source_id);
+	scheduler->interval = interval;
+	scheduler->statistics.interval = interval;
+	scheduler->timeout_source_id = g_timeout_add_full(G_PRIORITY_DEFAULT_IDLE, interval, (GSourceFunc)on_timeout, scheduler, (GDestroyNotify)nullptr);
+}
+static gboolean on_timeout(RefreshScheduler *scheduler)
+{
+	scheduler->statistics.ticks++;
+	unsigned int interval;
+	if (scheduler->callback()){
+		scheduler->consecutive_idle_ticks = 0;
+		interval = scheduler->min_interval;
+	}else{
+		scheduler->statistics.idle_ticks++;
+		scheduler->consecutive_idle_ticks++;
+		interval = scheduler->interval;
+		if (scheduler->consecutive_idle_ticks > IdleTicksBeforeBackOff)
+			interval = std::max(scheduler->min_interval, std::min(interval * 2, MaxIdleInterval));
+	}
+	if (interval == scheduler->interval) return TRUE;
+	scheduler->timeout_source_id = 0;
+	start_timeout(scheduler, interval);
+	return FALSE;
+}
+RefreshScheduler* refresh_scheduler_new(float refresh_rate, RefreshSchedulerCallback callback)
+{
+	RefreshScheduler *scheduler = new RefreshScheduler;
+	scheduler->callback = callback;
+	scheduler->timeout_source_id = 0;
+	scheduler->min_interval = static_cast<unsigned int>(1000 / std::max(refresh_rate, 1.0f));
+	scheduler->consecutive_idle_ticks = 0;
+	scheduler->statistics.ticks = 0;
+	scheduler->statistics.idle_ticks = 0;
+	start_timeout(scheduler, scheduler->min_interval);
+	return scheduler;
+}
+void refresh_scheduler_destroy(RefreshScheduler *scheduler)
+{
+	if (scheduler->timeout_source_id > 0)
+		g_source_remove(scheduler->timeout_source_id);
+	delete scheduler;
+}
+void refresh_scheduler_wake(RefreshScheduler *scheduler)
+{
+	scheduler->consecutive_idle_ticks = 0;
+	if (scheduler->interval != scheduler->min_interval)
+		start_timeout(scheduler, scheduler->min_interval);
+}
+void refresh_scheduler_get_statistics(RefreshScheduler *scheduler, RefreshSchedulerStatistics *statistics)
+{
+	*statistics = scheduler->statistics;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_REFRESH_SCHEDULER_H_
+#define GPICK_REFRESH_SCHEDULER_H_
+
+#include <functional>
+#include <stdint.h>
+struct RefreshScheduler;
+/** Tick callback. Returns true when picker state changed (pointer moved, screen contents changed), false when the tick was idle. */
+typedef std::function<bool()> RefreshSchedulerCallback;
+/** Create scheduler calling callback refresh_rate times per second.
+ * After a number of idle ticks the interval is doubled on each further idle tick until it reaches the idle limit. First active tick or a wake up restores the full rate.
+ */
+RefreshScheduler* refresh_scheduler_new(float refresh_rate, RefreshSchedulerCallback callback);
+void refresh_scheduler_destroy(RefreshScheduler *scheduler);
+/** Restore full refresh rate immediately, for example after pointer motion event */
+void refresh_scheduler_wake(RefreshScheduler *scheduler);
+struct RefreshSchedulerStatistics
+{
+	uint64_t ticks;
+	uint64_t idle_ticks;
+	unsigned int interval; /**< Current tick interval in milliseconds */
+};
+void refresh_scheduler_get_statistics(RefreshScheduler *scheduler, RefreshSchedulerStatistics *statistics);
+
+#endif /* GPICK_REFRESH_SCHEDULER_H_ */
@@ -18,17 +18,49 @@
 
 #include "Sampler.h"
 #include "ScreenReader.h"
+#include "PickerTimings.h"
 #include "MathUtil.h"
 #include <math.h>
+#include <stdint.h>
+#include <vector>
 #include <gdk/gdk.h>
+#ifdef GPICK_X86_KERNELS
+#include <immintrin.h>
+#endif
 using namespace math;
 
+/** Weight kernel values are fixed point numbers with this many fractional bits.
+ * Weight fits into signed 16-bit integer and a weighted row of 33 pixels fits into 32-bit accumulators. */
+const int KernelWeightBits = 14;
+/** Dominant color is searched among colors with this many bits per channel */
+const int ColorBinBits = 5;
+/** Maximum width and height of a screen area read for a group of sample points */
+const int MaxSampleGroupSize = 512;
+
+struct SamplerColorBin
+{
+	uint32_t weight;
+	uint64_t sum[3]; /**< Weighted sums of blue, green and red channels */
+};
+
+struct SampleGroup
+{
+	Rect2<int> rect; /**< Union of screen areas of all points or regions in the group */
+	std::vector<size_t> points;
+};
 struct Sampler
 {
 	int oversample;
 	SamplerFalloff falloff;
 	float (*falloff_fnc)(float distance);
 	ScreenReader* screen_reader;
+	std::vector<uint16_t> kernel; /**< Falloff weights of (2 * oversample + 1)^2 window, row by row */
+	int kernel_oversample; /**< Oversample value kernel was built for, -1 if kernel is not built */
+	SamplerFalloff kernel_falloff;
+	SamplerMode mode;
+	std::vector<uint32_t> channel_histogram; /**< Weights of 256 values of blue, green and red channels */
+	std::vector<SamplerColorBin> color_bins; /**< Weights of colors with 5 bits per channel */
+	std::vector<uint16_t> used_color_bins;
 };
 static float sampler_falloff_none(float distance)
 {
@@ -54,6 +86,9 @@ struct Sampler* sampler_new(ScreenReader* screen_reader)
 {
 	Sampler* sampler = new Sampler;
 	sampler->oversample = 0;
+	sampler->kernel_oversample = -1;
+	sampler->kernel_falloff = SamplerFalloff::none;
+	sampler->mode = SamplerMode::mean;
 	sampler_set_falloff(sampler, SamplerFalloff::none);
 	sampler->screen_reader = screen_reader;
 	return sampler;
@@ -89,51 +124,227 @@ void sampler_set_oversample(Sampler *sampler, int oversample)
 {
 	sampler->oversample = oversample;
 }
-static void get_pixel(unsigned char *data, int stride, int x, int y, Color* color)
+void sampler_set_mode(Sampler *sampler, SamplerMode mode)
+{
+	sampler->mode = mode;
+}
+SamplerMode sampler_get_mode(Sampler *sampler)
+{
+	return sampler->mode;
+}
+/**
+ * Build fixed point falloff weights for current oversample and falloff, if they are not built already.
+ */
+static void update_kernel(Sampler *sampler)
+{
+	if (sampler->kernel_oversample == sampler->oversample && sampler->kernel_falloff == sampler->falloff) return;
+	int oversample = sampler->oversample;
+	int size = 2 * oversample + 1;
+	sampler->kernel.resize(size * size);
+	float max_distance = oversample ? 1 / sqrt(2 * pow((double)oversample, 2)) : 0;
+	for (int y = -oversample; y <= oversample; ++y){
+		for (int x = -oversample; x <= oversample; ++x){
+			float f;
+			if (oversample && sampler->falloff_fnc){
+				f = sampler->falloff_fnc(sqrt((double)(x * x + y * y)) * max_distance);
+			}else{
+				f = 1;
+			}
+			sampler->kernel[(y + oversample) * size + x + oversample] = static_cast<uint16_t>(clamp_int(int(f * (1 << KernelWeightBits) + 0.5f), 0, 1 << KernelWeightBits));
+		}
+	}
+	sampler->kernel_oversample = oversample;
+	sampler->kernel_falloff = sampler->falloff;
+}
+/**
+ * Accumulate weighted BGRA pixels of one row.
+ * @param[in] row First pixel.
+ * @param[in] weights Weight of each pixel.
+ * @param[in] count Number of pixels.
+ * @param[in,out] sum Weighted sums of blue, green and red channels.
+ * @return Sum of weights.
+ */
+static uint32_t accumulate_row_scalar(const unsigned char *row, const uint16_t *weights, int count, uint32_t sum[3])
+{
+	uint32_t weight_sum = 0;
+	for (int i = 0; i < count; i++){
+		uint32_t w = weights[i];
+		sum[0] += w * row[0];
+		sum[1] += w * row[1];
+		sum[2] += w * row[2];
+		weight_sum += w;
+		row += 4;
+	}
+	return weight_sum;
+}
+#ifdef GPICK_X86_KERNELS
+GPICK_TARGET("sse2")
+static uint32_t accumulate_row_sse2(const unsigned char *row, const uint16_t *weights, int count, uint32_t sum[3])
 {
-	unsigned char *p;
-	p = data + y * stride + x * 4;
-	color->rgb.red = p[2] * (1 / 255.0);
-	color->rgb.green = p[1] * (1 / 255.0);
-	color->rgb.blue = p[0] * (1 / 255.0);
+	__m128i zero = _mm_setzero_si128();
+	__m128i accumulator = zero;
+	uint32_t weight_sum = 0;
+	int i = 0;
+	for (; i + 2 <= count; i += 2){
+		// Two BGRA pixels widened to 16 bits are multiplied by their weights, high and low halves of products give 32-bit results
+		__m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + i * 4)), zero);
+		__m128i w = _mm_unpacklo_epi64(_mm_set1_epi16(weights[i]), _mm_set1_epi16(weights[i + 1]));
+		__m128i low = _mm_mullo_epi16(pixels, w);
+		__m128i high = _mm_mulhi_epu16(pixels, w);
+		accumulator = _mm_add_epi32(accumulator, _mm_unpacklo_epi16(low, high));
+		accumulator = _mm_add_epi32(accumulator, _mm_unpackhi_epi16(low, high));
+		weight_sum += weights[i] + weights[i + 1];
+	}
+	uint32_t lanes[4];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), accumulator);
+	sum[0] += lanes[0];
+	sum[1] += lanes[1];
+	sum[2] += lanes[2];
+	return weight_sum + accumulate_row_scalar(row + i * 4, weights + i, count - i, sum);
+}
+#endif
+typedef uint32_t (*AccumulateRowKernel)(const unsigned char *row, const uint16_t *weights, int count, uint32_t sum[3]);
+/**
+ * Find weighted median of channel histogram.
+ */
+static int histogram_median(const uint32_t *histogram, uint32_t total)
+{
+	uint32_t half = (total + 1) / 2, cumulative = 0;
+	for (int value = 0; value < 256; value++){
+		cumulative += histogram[value];
+		if (cumulative >= half) return value;
+	}
+	return 255;
+}
+/**
+ * Find weighted mean of channel histogram, ignoring lowest and highest quarter of total weight.
+ */
+static double histogram_trimmed_mean(const uint32_t *histogram, uint32_t total)
+{
+	uint32_t low = total / 4, high = total - total / 4, cumulative = 0;
+	if (high <= low) return histogram_median(histogram, total);
+	uint64_t sum = 0;
+	for (int value = 0; value < 256 && cumulative < high; value++){
+		uint32_t begin = max_int(cumulative, low);
+		uint32_t end = min_int(cumulative + histogram[value], high);
+		if (end > begin) sum += uint64_t(end - begin) * value;
+		cumulative += histogram[value];
+	}
+	return double(sum) / (high - low);
+}
+/**
+ * Combine window pixels using histograms. Every pixel is added in constant time and statistics are
+ * extracted from fixed size histograms, so cost grows only with the number of pixels in window.
+ */
+static void sample_histogram(Sampler *sampler, const unsigned char *data, int stride, int rows, int columns, const uint16_t *weights, int weights_stride, Color *color)
+{
+	bool dominant = sampler->mode == SamplerMode::dominant;
+	if (dominant){
+		if (sampler->color_bins.empty()) sampler->color_bins.resize(1 << (ColorBinBits * 3));
+	}else{
+		sampler->channel_histogram.assign(256 * 3, 0);
+	}
+	uint32_t *histogram = sampler->channel_histogram.data();
+	uint32_t total = 0;
+	for (int y = 0; y < rows; y++){
+		const unsigned char *pixel = data + y * stride;
+		const uint16_t *row_weights = weights + y * weights_stride;
+		for (int x = 0; x < columns; x++, pixel += 4){
+			uint32_t w = row_weights[x];
+			if (w == 0) continue;
+			total += w;
+			if (dominant){
+				int bin = ((pixel[2] >> (8 - ColorBinBits)) << (ColorBinBits * 2)) | ((pixel[1] >> (8 - ColorBinBits)) << ColorBinBits) | (pixel[0] >> (8 - ColorBinBits));
+				SamplerColorBin &color_bin = sampler->color_bins[bin];
+				if (color_bin.weight == 0) sampler->used_color_bins.push_back(bin);
+				color_bin.weight += w;
+				for (int i = 0; i < 3; i++){
+					color_bin.sum[i] += uint64_t(w) * pixel[i];
+				}
+			}else{
+				histogram[pixel[0]] += w;
+				histogram[256 + pixel[1]] += w;
+				histogram[512 + pixel[2]] += w;
+			}
+		}
+	}
+	color_zero(color);
+	if (total == 0) return;
+	double values[3];
+	if (dominant){
+		const SamplerColorBin *best = nullptr;
+		for (auto bin: sampler->used_color_bins){
+			if (!best || sampler->color_bins[bin].weight > best->weight) best = &sampler->color_bins[bin];
+		}
+		for (int i = 0; i < 3; i++){
+			values[i] = double(best->sum[i]) / best->weight;
+		}
+		for (auto bin: sampler->used_color_bins){
+			SamplerColorBin &color_bin = sampler->color_bins[bin];
+			color_bin.weight = 0;
+			color_bin.sum[0] = color_bin.sum[1] = color_bin.sum[2] = 0;
+		}
+		sampler->used_color_bins.clear();
+	}else{
+		for (int i = 0; i < 3; i++){
+			if (sampler->mode == SamplerMode::median)
+				values[i] = histogram_median(histogram + 256 * i, total);
+			else
+				values[i] = histogram_trimmed_mean(histogram + 256 * i, total);
+		}
+	}
+	color->rgb.red = values[2] / 255.0;
+	color->rgb.green = values[1] / 255.0;
+	color->rgb.blue = values[0] / 255.0;
 }
 int sampler_get_color_sample(Sampler *sampler, Vec2<int>& pointer, Rect2<int>& screen_rect, Vec2<int>& offset, Color* color)
 {
-	Color sample, result;
-	float divider = 0;
-	color_zero(&result);
+	AccumulateRowKernel accumulate_row = simd_select<AccumulateRowKernel>(accumulate_row_scalar, GPICK_KERNEL(accumulate_row_sse2));
+	PickerStageTimer timer(PickerStage::sample);
+	update_kernel(sampler);
 	cairo_surface_t *surface = screen_reader_get_surface(sampler->screen_reader);
 	int x = pointer.x, y = pointer.y;
+	int oversample = sampler->oversample;
+	int size = 2 * oversample + 1;
 	int left, right, top, bottom;
-	left = max_int(screen_rect.getLeft(), x - sampler->oversample);
-	right = min_int(screen_rect.getRight(), x + sampler->oversample + 1);
-	top = max_int(screen_rect.getTop(), y - sampler->oversample);
-	bottom = min_int(screen_rect.getBottom(), y + sampler->oversample + 1);
-	int width = right - left;
-	int height = bottom - top;
-	int center_x = x - left;
-	int center_y = y - top;
-	float max_distance = 1 / sqrt(2 * pow((double)sampler->oversample, 2));
+	left = max_int(screen_rect.getLeft(), x - oversample);
+	right = min_int(screen_rect.getRight(), x + oversample + 1);
+	top = max_int(screen_rect.getTop(), y - oversample);
+	bottom = min_int(screen_rect.getBottom(), y + oversample + 1);
 	unsigned char *data = cairo_image_surface_get_data(surface);
 	int stride = cairo_image_surface_get_stride(surface);
-	for (int x=-sampler->oversample; x <= sampler->oversample; ++x){
-		for (int y=-sampler->oversample; y <= sampler->oversample; ++y){
-			if ((center_x + x < 0) || (center_y + y < 0)) continue;
-			if ((center_x + x >= width) || (center_y + y >= height)) continue;
-			get_pixel(data, stride, offset.x + center_x + x, offset.y + center_y + y, &sample);
-			float f;
-			if (sampler->oversample){
-				f = sampler->falloff_fnc(sqrt((double)(x * x + y * y)) * max_distance);
-			}else{
-				f = 1;
+	if (sampler->mode != SamplerMode::mean){
+		Color result;
+		color_zero(&result);
+		if (right > left && bottom > top){
+			const unsigned char *window = data + offset.y * stride + offset.x * 4;
+			const uint16_t *weights = &sampler->kernel[(top - y + oversample) * size + left - x + oversample];
+			sample_histogram(sampler, window, stride, bottom - top, right - left, weights, size, &result);
+		}
+		color_copy(&result, color);
+		return 0;
+	}
+	uint64_t sum[3] = {0, 0, 0};
+	uint64_t divider = 0;
+	if (right > left){
+		for (int row_y = top; row_y < bottom; ++row_y){
+			uint32_t row_sum[3] = {0, 0, 0};
+			const unsigned char *row = data + (offset.y + row_y - top) * stride + offset.x * 4;
+			const uint16_t *weights = &sampler->kernel[(row_y - y + oversample) * size + left - x + oversample];
+			divider += accumulate_row(row, weights, right - left, row_sum);
+			for (int i = 0; i < 3; i++){
+				sum[i] += row_sum[i];
 			}
-			color_multiply(&sample, f);
-			color_add(&result, &sample);
-			divider += f;
 		}
 	}
-	if (divider > 0)
-		color_multiply(&result, 1 / divider);
+	Color result;
+	color_zero(&result);
+	if (divider > 0){
+		double scale = 1 / (255.0 * divider);
+		result.rgb.red = sum[2] * scale;
+		result.rgb.green = sum[1] * scale;
+		result.rgb.blue = sum[0] * scale;
+	}
 	color_copy(&result, color);
 	return 0;
 }
@@ -154,3 +365,113 @@ void sampler_get_screen_rect(Sampler *sampler, math::Vec2<int>& pointer, math::R
 	bottom = min_int(screen_rect.getBottom(), pointer.y + sampler->oversample + 1);
 	*rect = math::Rect2<int>(left, top, right, bottom);
 }
+/**
+ * Add screen area to the first group which stays within size limit after adding it, or to a new group.
+ */
+static void add_to_sample_groups(std::vector<SampleGroup> &groups, const Rect2<int> &rect, size_t index)
+{
+	for (auto &group: groups){
+		Rect2<int> union_rect = group.rect + rect;
+		if (union_rect.getWidth() <= MaxSampleGroupSize && union_rect.getHeight() <= MaxSampleGroupSize){
+			group.rect = union_rect;
+			group.points.push_back(index);
+			return;
+		}
+	}
+	SampleGroup group;
+	group.rect = rect;
+	group.points.push_back(index);
+	groups.push_back(std::move(group));
+}
+size_t sampler_get_color_samples(Sampler *sampler, GdkScreen *screen, const Vec2<int> *points, size_t count, Color *colors)
+{
+	Rect2<int> screen_rect = screen_reader_get_screen_rect(sampler->screen_reader, screen);
+	std::vector<Rect2<int>> rects(count);
+	std::vector<SampleGroup> groups;
+	size_t sampled = 0;
+	for (size_t i = 0; i < count; i++){
+		Vec2<int> point = points[i];
+		if (point.x < screen_rect.getLeft() || point.x >= screen_rect.getRight() || point.y < screen_rect.getTop() || point.y >= screen_rect.getBottom()){
+			color_zero(&colors[i]);
+			continue;
+		}
+		sampler_get_screen_rect(sampler, point, screen_rect, &rects[i]);
+		add_to_sample_groups(groups, rects[i], i);
+		sampled++;
+	}
+	ScreenReader *screen_reader = sampler->screen_reader;
+	for (auto &group: groups){
+		screen_reader_reset_rect(screen_reader);
+		screen_reader_add_rect(screen_reader, screen, group.rect);
+		Rect2<int> final_rect = group.rect;
+		screen_reader_update_surface(screen_reader, &final_rect);
+		for (auto i: group.points){
+			Vec2<int> point = points[i];
+			Vec2<int> offset(rects[i].getX() - final_rect.getX(), rects[i].getY() - final_rect.getY());
+			sampler_get_color_sample(sampler, point, screen_rect, offset, &colors[i]);
+		}
+	}
+	return sampled;
+}
+size_t sampler_get_region_colors(Sampler *sampler, GdkScreen *screen, const Rect2<int> *regions, size_t count, Color *colors)
+{
+	AccumulateRowKernel accumulate_row = simd_select<AccumulateRowKernel>(accumulate_row_scalar, GPICK_KERNEL(accumulate_row_sse2));
+	Rect2<int> screen_rect = screen_reader_get_screen_rect(sampler->screen_reader, screen);
+	std::vector<Rect2<int>> rects(count);
+	std::vector<SampleGroup> groups;
+	size_t sampled = 0;
+	int max_width = 0;
+	for (size_t i = 0; i < count; i++){
+		const Rect2<int> &region = regions[i];
+		int left = max_int(screen_rect.getLeft(), region.getLeft());
+		int right = min_int(screen_rect.getRight(), region.getRight());
+		int top = max_int(screen_rect.getTop(), region.getTop());
+		int bottom = min_int(screen_rect.getBottom(), region.getBottom());
+		color_zero(&colors[i]);
+		if (region.isEmpty() || right <= left || bottom <= top)
+			continue;
+		rects[i] = Rect2<int>(left, top, right, bottom);
+		max_width = max_int(max_width, right - left);
+		add_to_sample_groups(groups, rects[i], i);
+		sampled++;
+	}
+	std::vector<uint16_t> weights(max_width, 1);
+	ScreenReader *screen_reader = sampler->screen_reader;
+	for (auto &group: groups){
+		screen_reader_reset_rect(screen_reader);
+		screen_reader_add_rect(screen_reader, screen, group.rect);
+		Rect2<int> final_rect = group.rect;
+		screen_reader_update_surface(screen_reader, &final_rect);
+		PickerStageTimer timer(PickerStage::sample);
+		cairo_surface_t *surface = screen_reader_get_surface(screen_reader);
+		unsigned char *data = cairo_image_surface_get_data(surface);
+		int stride = cairo_image_surface_get_stride(surface);
+		for (auto i: group.points){
+			const Rect2<int> &rect = rects[i];
+			uint64_t sum[3] = {0, 0, 0};
+			uint64_t divider = 0;
+			for (int y = rect.getTop(); y < rect.getBottom(); y++){
+				uint32_t row_sum[3] = {0, 0, 0};
+				const unsigned char *row = data + (y - final_rect.getY()) * stride + (rect.getX() - final_rect.getX()) * 4;
+				divider += accumulate_row(row, weights.data(), rect.getWidth(), row_sum);
+				for (int j = 0; j < 3; j++)
+					sum[j] += row_sum[j];
+			}
+			double scale = 1 / (255.0 * divider);
+			colors[i].rgb.red = sum[2] * scale;
+			colors[i].rgb.green = sum[1] * scale;
+			colors[i].rgb.blue = sum[0] * scale;
+		}
+	}
+	return sampled;
+}
+void sampler_get_grid_points(const Rect2<int> &area, int columns, int rows, Vec2<int> *points)
+{
+	for (int row = 0; row < rows; row++){
+		int y = area.getY() + int((2 * int64_t(row) + 1) * area.getHeight() / (2 * rows));
+		for (int column = 0; column < columns; column++){
+			int x = area.getX() + int((2 * int64_t(column) + 1) * area.getWidth() / (2 * columns));
+			points[row * columns + column] = Vec2<int>(x, y);
+		}
+	}
+}
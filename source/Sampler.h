@@ -22,6 +22,8 @@
 #include "Color.h"
 #include "Rect2.h"
 #include "Vector2.h"
+#include <gdk/gdk.h>
+#include <stddef.h>
 struct Sampler;
 struct ScreenReader;
 enum class SamplerFalloff: int
@@ -32,13 +34,39 @@ enum class SamplerFalloff: int
 	cubic = 3,
 	exponential = 4,
 };
+/** Statistic used to combine pixels of oversample window, falloff is used as pixel weight */
+enum class SamplerMode: int
+{
+	mean = 0,
+	median = 1, /**< Median of each channel */
+	trimmed_mean = 2, /**< Mean of each channel without lowest and highest quarter */
+	dominant = 3, /**< Average of the most common color group */
+};
 Sampler* sampler_new(ScreenReader* screen_reader);
 void sampler_set_falloff(Sampler *sampler, SamplerFalloff falloff);
 void sampler_set_oversample(Sampler *sampler, int oversample);
+void sampler_set_mode(Sampler *sampler, SamplerMode mode);
+SamplerMode sampler_get_mode(Sampler *sampler);
 SamplerFalloff sampler_get_falloff(Sampler *sampler);
 int sampler_get_oversample(Sampler *sampler);
 void sampler_destroy(Sampler *sampler);
 int sampler_get_color_sample(Sampler *sampler, math::Vec2<int>& pointer, math::Rect2<int>& screen_rect, math::Vec2<int>& offset, Color* color);
 void sampler_get_screen_rect(Sampler *sampler, math::Vec2<int>& pointer, math::Rect2<int>& screen_rect, math::Rect2<int> *rect);
+/** Sample colors at multiple screen points using as few screen captures as possible.
+ * Nearby points are grouped and each group is read from the screen once. Points far apart are placed into separate groups, so that large unused screen areas are not read.
+ * Colors of points outside of the screen are set to zero.
+ * Returns number of points inside the screen.
+ */
+size_t sampler_get_color_samples(Sampler *sampler, GdkScreen *screen, const math::Vec2<int> *points, size_t count, Color *colors);
+/** Get mean color of each screen region, regardless of sampler falloff and mode.
+ * Regions are clipped to the screen and nearby regions are read from the screen together, as in sampler_get_color_samples.
+ * Colors of empty regions and regions outside of the screen are set to zero.
+ * Returns number of regions at least partially inside the screen.
+ */
+size_t sampler_get_region_colors(Sampler *sampler, GdkScreen *screen, const math::Rect2<int> *regions, size_t count, Color *colors);
+/** Get centers of grid cells covering the area, row by row.
+ * Points array must have space for columns * rows points.
+ */
+void sampler_get_grid_points(const math::Rect2<int> &area, int columns, int rows, math::Vec2<int> *points);
 
 #endif /* GPICK_SAMPLER_H_ */
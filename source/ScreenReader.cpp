@@ -17,33 +17,58 @@
  */
 
 #include "ScreenReader.h"
+#include "ScreenSource.h"
+#include "PickerTimings.h"
 #include "Rect2.h"
-#include <gtk/gtk.h>
 #include <algorithm>
-#include <iostream>
 using namespace math;
 using namespace std;
 
 struct ScreenReader
 {
-	cairo_surface_t *surface;
+	ScreenSource *source;
+	cairo_surface_t *current_surface; /**< Surface containing last read area, owned by screen source */
 	int max_size;
 	GdkScreen *screen;
 	Rect2<int> read_area;
+	GdkScreen *updated_screen; /**< Screen of the last successful surface update */
+	Rect2<int> updated_area; /**< Read area of the last successful surface update */
+	ScreenReaderStatistics statistics;
 };
 struct ScreenReader* screen_reader_new()
 {
 	ScreenReader* screen = new ScreenReader;
+	screen->source = screen_source_new_display();
 	screen->max_size = 0;
-	screen->surface = 0;
+	screen->current_surface = 0;
 	screen->screen = 0;
+	screen->updated_screen = 0;
+	screen->statistics.updates = 0;
+	screen->statistics.skipped = 0;
+	screen->statistics.damage_tracking = false;
 	return screen;
 }
 void screen_reader_destroy(ScreenReader *screen)
 {
-	if (screen->surface) cairo_surface_destroy(screen->surface);
+	delete screen->source;
 	delete screen;
 }
+void screen_reader_set_source(ScreenReader *screen, ScreenSource *source)
+{
+	delete screen->source;
+	screen->source = source;
+	screen->current_surface = 0;
+	screen->updated_screen = 0;
+	screen->updated_area = Rect2<int>();
+}
+void screen_reader_get_pointer(ScreenReader *screen, GdkScreen **gdk_screen, Vec2<int> &pointer, Rect2<int> &monitor_rect)
+{
+	screen->source->getPointer(gdk_screen, pointer, monitor_rect);
+}
+Rect2<int> screen_reader_get_screen_rect(ScreenReader *screen, GdkScreen *gdk_screen)
+{
+	return screen->source->getScreenRect(gdk_screen);
+}
 void screen_reader_add_rect(ScreenReader *screen, GdkScreen *gdk_screen, Rect2<int>& rect)
 {
 	if (screen->screen && (screen->screen == gdk_screen)){
@@ -60,34 +85,44 @@ void screen_reader_reset_rect(ScreenReader *screen)
 }
 void screen_reader_update_surface(ScreenReader *screen, Rect2<int>* update_rect)
 {
-	if (!screen->screen) return;
-	int left = screen->read_area.getX();
-	int top = screen->read_area.getY();
+	if (screen->read_area.isEmpty()) return;
+	PickerStageTimer timer(PickerStage::capture);
 	int width = screen->read_area.getWidth();
 	int height = screen->read_area.getHeight();
 	if (width > screen->max_size || height > screen->max_size){
-		if (screen->surface) cairo_surface_destroy(screen->surface);
 		screen->max_size = (std::max(width, height) / 150 + 1) * 150;
-		screen->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, screen->max_size, screen->max_size);
 	}
-	GdkWindow* root_window = gdk_screen_get_root_window(screen->screen);
-	cairo_t *root_cr = gdk_cairo_create(root_window);
-	cairo_surface_t *root_surface = cairo_get_target(root_cr);
-	if (cairo_surface_status(root_surface) != CAIRO_STATUS_SUCCESS){
-		cerr << "can not get root window surface" << endl;
-		return;
-	}
-	cairo_t *cr = cairo_create(screen->surface);
-	cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
-	cairo_set_source_surface(cr, root_surface, -left, -top);
-	cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
-	cairo_rectangle(cr, 0, 0, width, height);
-	cairo_fill(cr);
-	cairo_destroy(cr);
-	cairo_destroy(root_cr);
+	cairo_surface_t *surface = screen->source->read(screen->screen, screen->read_area, screen->max_size);
+	if (!surface) return;
+	screen->current_surface = surface;
+	screen->updated_screen = screen->screen;
+	screen->updated_area = screen->read_area;
+	screen->statistics.updates++;
 	*update_rect = screen->read_area;
 }
+ScreenReaderUpdate screen_reader_update_surface_if_changed(ScreenReader *screen, Rect2<int>* update_rect)
+{
+	if (screen->read_area.isEmpty()) return ScreenReaderUpdate::skipped;
+	ScreenSourceChange change = screen->source->getChange(screen->screen, screen->read_area);
+	screen->statistics.damage_tracking = change != ScreenSourceChange::unknown;
+	ScreenReaderUpdate result = ScreenReaderUpdate::unconditional;
+	if (!screen->current_surface || screen->updated_screen != screen->screen || screen->updated_area != screen->read_area){
+		result = ScreenReaderUpdate::area_changed;
+	}else if (change == ScreenSourceChange::unchanged){
+		screen->statistics.skipped++;
+		*update_rect = screen->read_area;
+		return ScreenReaderUpdate::skipped;
+	}else if (change == ScreenSourceChange::changed){
+		result = ScreenReaderUpdate::damaged;
+	}
+	screen_reader_update_surface(screen, update_rect);
+	return result;
+}
+void screen_reader_get_statistics(ScreenReader *screen, ScreenReaderStatistics *statistics)
+{
+	*statistics = screen->statistics;
+}
 cairo_surface_t* screen_reader_get_surface(ScreenReader *screen)
 {
-	return screen->surface;
+	return screen->current_surface;
 }
@@ -22,12 +22,39 @@
 #include <gdk/gdk.h>
 #include <cairo/cairo.h>
 #include "Rect2.h"
+#include "Vector2.h"
+#include <stdint.h>
 
 struct ScreenReader;
+struct ScreenSource;
 ScreenReader* screen_reader_new();
+/** Replace screen source used to read screen pixels and pointer position. Screen reader takes ownership of the source. */
+void screen_reader_set_source(ScreenReader *screen, ScreenSource *source);
+/** Get pointer position, screen containing it and geometry of the monitor under pointer from the screen source */
+void screen_reader_get_pointer(ScreenReader *screen, GdkScreen **gdk_screen, math::Vec2<int> &pointer, math::Rect2<int> &monitor_rect);
+/** Get geometry of the whole screen from the screen source */
+math::Rect2<int> screen_reader_get_screen_rect(ScreenReader *screen, GdkScreen *gdk_screen);
 void screen_reader_reset_rect(ScreenReader *screen);
 void screen_reader_add_rect(ScreenReader *screen, GdkScreen *gdk_screen, math::Rect2<int>& rect);
 void screen_reader_update_surface(ScreenReader *screen, math::Rect2<int>* update_rect);
+enum class ScreenReaderUpdate
+{
+	skipped, /**< Read area and screen contents inside it are unchanged, surface was not updated */
+	area_changed, /**< Read area differs from the previous update */
+	damaged, /**< Screen contents inside read area changed since the previous update */
+	unconditional, /**< Screen changes are not tracked, surface was updated anyway */
+};
+/** Update surface only when read area or screen contents inside it changed since the previous update.
+ * Screen contents are tracked by the screen source (X Damage extension for display source) when possible, otherwise surface is updated when read area is unchanged too.
+ */
+ScreenReaderUpdate screen_reader_update_surface_if_changed(ScreenReader *screen, math::Rect2<int>* update_rect);
+struct ScreenReaderStatistics
+{
+	uint64_t updates; /**< Number of surface updates */
+	uint64_t skipped; /**< Number of surface updates skipped because nothing changed */
+	bool damage_tracking; /**< Screen contents are tracked by the screen source, for example with X Damage extension */
+};
+void screen_reader_get_statistics(ScreenReader *screen, ScreenReaderStatistics *statistics);
 cairo_surface_t* screen_reader_get_surface(ScreenReader *screen);
 void screen_reader_destroy(ScreenReader *screen);
 
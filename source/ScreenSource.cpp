@@ -0,0 +1,458 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ScreenSource.h"
+#include <gtk/gtk.h>
+#if defined(GDK_WINDOWING_X11) && (defined(ENABLE_XSHM) || defined(ENABLE_XDAMAGE))
+#define GPICK_SCREEN_SOURCE_X11
+#include <gdk/gdkx.h>
+#include <X11/Xlib.h>
+#endif
+#if defined(GPICK_SCREEN_SOURCE_X11) && defined(ENABLE_XSHM)
+#define GPICK_SCREEN_SOURCE_XSHM
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#endif
+#if defined(GPICK_SCREEN_SOURCE_X11) && defined(ENABLE_XDAMAGE)
+#define GPICK_SCREEN_SOURCE_XDAMAGE
+#include <X11/extensions/Xdamage.h>
+#endif
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+using namespace math;
+using namespace std;
+
+ScreenSource::~ScreenSource()
+{
+}
+#ifdef GPICK_SCREEN_SOURCE_XSHM
+/** MIT-SHM capture state.
+ * X server copies root window pixels straight into a shared memory segment, which is wrapped into a cairo surface without any additional copying.
+ */
+struct ScreenSourceShm
+{
+	enum class State
+	{
+		unknown,
+		available,
+		unavailable,
+	};
+	State state;
+	Display *display;
+	GdkScreen *screen;
+	XShmSegmentInfo info;
+	XImage *image;
+	int size;
+	cairo_surface_t *surface;
+};
+#endif
+#ifdef GPICK_SCREEN_SOURCE_XDAMAGE
+/** X Damage tracking state.
+ * Damage reported on the root window is accumulated into a bounding rectangle, which is cleared after each read.
+ */
+struct ScreenSourceDamage
+{
+	bool initialized;
+	Display *display;
+	GdkScreen *screen;
+	Damage damage;
+	int event_base;
+	Rect2<int> area;
+};
+#endif
+#ifdef GPICK_SCREEN_SOURCE_X11
+static Display* get_x_display(GdkScreen *gdk_screen)
+{
+	GdkDisplay *display = gdk_screen_get_display(gdk_screen);
+#if GTK_MAJOR_VERSION >= 3
+	if (!GDK_IS_X11_DISPLAY(display)) return nullptr;
+#endif
+	return GDK_DISPLAY_XDISPLAY(display);
+}
+#endif
+#ifdef GPICK_SCREEN_SOURCE_XSHM
+static void shm_release(ScreenSourceShm *shm)
+{
+	if (shm->surface){
+		cairo_surface_destroy(shm->surface);
+		shm->surface = nullptr;
+	}
+	if (shm->image){
+		gdk_error_trap_push();
+		XShmDetach(shm->display, &shm->info);
+		XSync(shm->display, False);
+		gdk_error_trap_pop();
+		XDestroyImage(shm->image);
+		shmdt(shm->info.shmaddr);
+		shm->image = nullptr;
+	}
+	shm->size = 0;
+}
+static bool shm_check(ScreenSourceShm *shm, GdkScreen *screen)
+{
+	shm->display = get_x_display(screen);
+	if (!shm->display) return false;
+	return XShmQueryExtension(shm->display);
+}
+/** Create shared memory image big enough to hold max_size x max_size area.
+ * Only 32-bit visuals with the same pixel layout as cairo RGB24 format are used, so that no pixel conversion is needed.
+ */
+static bool shm_allocate(ScreenSourceShm *shm, GdkScreen *screen, int max_size)
+{
+	Screen *x_screen = GDK_SCREEN_XSCREEN(screen);
+	XImage *image = XShmCreateImage(shm->display, DefaultVisualOfScreen(x_screen), DefaultDepthOfScreen(x_screen), ZPixmap, nullptr, &shm->info, max_size, max_size);
+	if (!image) return false;
+	int native_byte_order = (G_BYTE_ORDER == G_LITTLE_ENDIAN) ? LSBFirst : MSBFirst;
+	if (image->bits_per_pixel != 32 || image->red_mask != 0xff0000 || image->green_mask != 0xff00 || image->blue_mask != 0xff || image->byte_order != native_byte_order){
+		XDestroyImage(image);
+		return false;
+	}
+	shm->info.shmid = shmget(IPC_PRIVATE, image->bytes_per_line * image->height, IPC_CREAT | 0600);
+	if (shm->info.shmid == -1){
+		XDestroyImage(image);
+		return false;
+	}
+	shm->info.shmaddr = image->data = reinterpret_cast<char*>(shmat(shm->info.shmid, nullptr, 0));
+	shm->info.readOnly = False;
+	if (shm->info.shmaddr == reinterpret_cast<char*>(-1)){
+		shmctl(shm->info.shmid, IPC_RMID, nullptr);
+		XDestroyImage(image);
+		return false;
+	}
+	gdk_error_trap_push();
+	XShmAttach(shm->display, &shm->info);
+	XSync(shm->display, False);
+	bool attached = gdk_error_trap_pop() == 0;
+	/* Segment is removed when both gpick and X server detach from it */
+	shmctl(shm->info.shmid, IPC_RMID, nullptr);
+	if (!attached){
+		shmdt(shm->info.shmaddr);
+		XDestroyImage(image);
+		return false;
+	}
+	shm->image = image;
+	shm->size = max_size;
+	shm->screen = screen;
+	return true;
+}
+static cairo_surface_t* shm_read(ScreenSourceShm *shm, GdkScreen *screen, const Rect2<int> &area, int max_size)
+{
+	int width = area.getWidth(), height = area.getHeight();
+	if (shm->state == ScreenSourceShm::State::unavailable || width <= 0 || height <= 0) return nullptr;
+	if (shm->state == ScreenSourceShm::State::unknown){
+		shm->state = shm_check(shm, screen) ? ScreenSourceShm::State::available : ScreenSourceShm::State::unavailable;
+		if (shm->state == ScreenSourceShm::State::unavailable) return nullptr;
+	}
+	if (!shm->image || shm->size < max_size || shm->screen != screen){
+		shm_release(shm);
+		if (!shm_allocate(shm, screen, max_size)){
+			cerr << "MIT-SHM screen capture is not available, falling back to slower capture method" << endl;
+			shm->state = ScreenSourceShm::State::unavailable;
+			return nullptr;
+		}
+	}
+	/* X server writes tightly packed rows of requested width into the segment */
+	XImage *image = shm->image;
+	image->width = width;
+	image->height = height;
+	image->bytes_per_line = width * 4;
+	gdk_error_trap_push();
+	Status status = XShmGetImage(shm->display, GDK_WINDOW_XID(gdk_screen_get_root_window(screen)), image, area.getX(), area.getY(), AllPlanes);
+	if (gdk_error_trap_pop() != 0 || !status) return nullptr;
+	if (!shm->surface || cairo_image_surface_get_width(shm->surface) != width || cairo_image_surface_get_height(shm->surface) != height){
+		if (shm->surface) cairo_surface_destroy(shm->surface);
+		shm->surface = cairo_image_surface_create_for_data(reinterpret_cast<unsigned char*>(image->data), CAIRO_FORMAT_RGB24, width, height, width * 4);
+	}else{
+		cairo_surface_mark_dirty(shm->surface);
+	}
+	return shm->surface;
+}
+#endif
+#ifdef GPICK_SCREEN_SOURCE_XDAMAGE
+static GdkFilterReturn damage_filter(GdkXEvent *gdk_xevent, GdkEvent *event, ScreenSourceDamage *damage)
+{
+	XEvent *xevent = reinterpret_cast<XEvent*>(gdk_xevent);
+	if (xevent->type != damage->event_base + XDamageNotify) return GDK_FILTER_CONTINUE;
+	XDamageNotifyEvent *notify = reinterpret_cast<XDamageNotifyEvent*>(xevent);
+	if (notify->damage != damage->damage) return GDK_FILTER_CONTINUE;
+	damage->area += Rect2<int>(notify->area.x, notify->area.y, notify->area.x + notify->area.width, notify->area.y + notify->area.height);
+	/* Subtracting all damage rearms non-empty damage reporting, so the next change is reported with a new event */
+	XDamageSubtract(damage->display, damage->damage, None, None);
+	return GDK_FILTER_REMOVE;
+}
+static void damage_release(ScreenSourceDamage *damage)
+{
+	if (!damage->initialized) return;
+	if (damage->damage){
+		gdk_window_remove_filter(nullptr, (GdkFilterFunc)damage_filter, damage);
+		gdk_error_trap_push();
+		XDamageDestroy(damage->display, damage->damage);
+		XSync(damage->display, False);
+		gdk_error_trap_pop();
+		damage->damage = 0;
+	}
+	damage->initialized = false;
+}
+/** Start tracking root window damage. Returns false when X Damage extension is not available. */
+static bool damage_check(ScreenSourceDamage *damage, GdkScreen *screen)
+{
+	if (damage->initialized && damage->screen == screen) return damage->damage != 0;
+	damage_release(damage);
+	damage->initialized = true;
+	damage->screen = screen;
+	damage->area = Rect2<int>();
+	damage->display = get_x_display(screen);
+	if (!damage->display) return false;
+	int error_base, major = 1, minor = 1;
+	if (!XDamageQueryExtension(damage->display, &damage->event_base, &error_base)) return false;
+	if (!XDamageQueryVersion(damage->display, &major, &minor)) return false;
+	gdk_error_trap_push();
+	damage->damage = XDamageCreate(damage->display, GDK_WINDOW_XID(gdk_screen_get_root_window(screen)), XDamageReportNonEmpty);
+	XSync(damage->display, False);
+	if (gdk_error_trap_pop() != 0){
+		damage->damage = 0;
+		return false;
+	}
+	gdk_window_add_filter(nullptr, (GdkFilterFunc)damage_filter, damage);
+	return true;
+}
+#endif
+struct DisplayScreenSource: public ScreenSource
+{
+	cairo_surface_t *m_surface;
+#ifdef GPICK_SCREEN_SOURCE_XSHM
+	ScreenSourceShm m_shm;
+#endif
+#ifdef GPICK_SCREEN_SOURCE_XDAMAGE
+	ScreenSourceDamage m_damage;
+#endif
+	DisplayScreenSource(bool allow_shm):
+		m_surface(nullptr)
+	{
+#ifdef GPICK_SCREEN_SOURCE_XSHM
+		m_shm.state = allow_shm ? ScreenSourceShm::State::unknown : ScreenSourceShm::State::unavailable;
+		m_shm.display = nullptr;
+		m_shm.screen = nullptr;
+		m_shm.image = nullptr;
+		m_shm.size = 0;
+		m_shm.surface = nullptr;
+#endif
+#ifdef GPICK_SCREEN_SOURCE_XDAMAGE
+		m_damage.initialized = false;
+		m_damage.display = nullptr;
+		m_damage.screen = nullptr;
+		m_damage.damage = 0;
+#endif
+	}
+	virtual ~DisplayScreenSource()
+	{
+#ifdef GPICK_SCREEN_SOURCE_XSHM
+		shm_release(&m_shm);
+#endif
+#ifdef GPICK_SCREEN_SOURCE_XDAMAGE
+		damage_release(&m_damage);
+#endif
+		if (m_surface) cairo_surface_destroy(m_surface);
+	}
+	virtual void getPointer(GdkScreen **screen, Vec2<int> &pointer, Rect2<int> &monitor_rect)
+	{
+		GdkModifierType state;
+		int x, y;
+		gdk_display_get_pointer(gdk_display_get_default(), screen, &x, &y, &state);
+		int monitor = gdk_screen_get_monitor_at_point(*screen, x, y);
+		GdkRectangle monitor_geometry;
+		gdk_screen_get_monitor_geometry(*screen, monitor, &monitor_geometry);
+		pointer = Vec2<int>(x, y);
+		monitor_rect = Rect2<int>(monitor_geometry.x, monitor_geometry.y, monitor_geometry.x + monitor_geometry.width, monitor_geometry.y + monitor_geometry.height);
+	}
+	virtual Rect2<int> getScreenRect(GdkScreen *screen)
+	{
+		return Rect2<int>(0, 0, gdk_screen_get_width(screen), gdk_screen_get_height(screen));
+	}
+	virtual cairo_surface_t *read(GdkScreen *screen, const Rect2<int> &area, int max_size)
+	{
+#ifdef GPICK_SCREEN_SOURCE_XDAMAGE
+		m_damage.area = Rect2<int>();
+#endif
+#ifdef GPICK_SCREEN_SOURCE_XSHM
+		cairo_surface_t *shm_surface = shm_read(&m_shm, screen, area, max_size);
+		if (shm_surface) return shm_surface;
+#endif
+		if (!m_surface || cairo_image_surface_get_width(m_surface) < max_size){
+			if (m_surface) cairo_surface_destroy(m_surface);
+			m_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, max_size, max_size);
+		}
+		GdkWindow* root_window = gdk_screen_get_root_window(screen);
+		cairo_t *root_cr = gdk_cairo_create(root_window);
+		cairo_surface_t *root_surface = cairo_get_target(root_cr);
+		if (cairo_surface_status(root_surface) != CAIRO_STATUS_SUCCESS){
+			cerr << "can not get root window surface" << endl;
+			cairo_destroy(root_cr);
+			return nullptr;
+		}
+		cairo_t *cr = cairo_create(m_surface);
+		cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+		cairo_set_source_surface(cr, root_surface, -area.getX(), -area.getY());
+		cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
+		cairo_rectangle(cr, 0, 0, area.getWidth(), area.getHeight());
+		cairo_fill(cr);
+		cairo_destroy(cr);
+		cairo_destroy(root_cr);
+		return m_surface;
+	}
+	virtual ScreenSourceChange getChange(GdkScreen *screen, const Rect2<int> &area)
+	{
+#ifdef GPICK_SCREEN_SOURCE_XDAMAGE
+		if (damage_check(&m_damage, screen))
+			return m_damage.area.intersects(area) ? ScreenSourceChange::changed : ScreenSourceChange::unchanged;
+#endif
+		return ScreenSourceChange::unknown;
+	}
+};
+struct SurfaceScreenSource: public ScreenSource
+{
+	cairo_surface_t *m_surface;
+	cairo_surface_t *m_area_surface;
+	vector<Vec2<int>> m_pointer_path;
+	size_t m_pointer_index;
+	bool m_changed;
+	SurfaceScreenSource(cairo_surface_t *surface):
+		m_surface(cairo_surface_reference(surface)),
+		m_area_surface(nullptr),
+		m_pointer_index(0),
+		m_changed(true)
+	{
+	}
+	virtual ~SurfaceScreenSource()
+	{
+		if (m_area_surface) cairo_surface_destroy(m_area_surface);
+		cairo_surface_destroy(m_surface);
+	}
+	void setSurface(cairo_surface_t *surface)
+	{
+		cairo_surface_reference(surface);
+		cairo_surface_destroy(m_surface);
+		m_surface = surface;
+		m_changed = true;
+	}
+	void setPointerPath(const vector<Vec2<int>> &path)
+	{
+		m_pointer_path = path;
+		m_pointer_index = 0;
+	}
+	virtual void getPointer(GdkScreen **screen, Vec2<int> &pointer, Rect2<int> &monitor_rect)
+	{
+		*screen = nullptr;
+		monitor_rect = getScreenRect(nullptr);
+		if (m_pointer_path.empty()){
+			pointer = Vec2<int>(monitor_rect.getCenterX(), monitor_rect.getCenterY());
+			return;
+		}
+		pointer = m_pointer_path[m_pointer_index];
+		m_pointer_index = (m_pointer_index + 1) % m_pointer_path.size();
+	}
+	virtual Rect2<int> getScreenRect(GdkScreen *screen)
+	{
+		return Rect2<int>(0, 0, cairo_image_surface_get_width(m_surface), cairo_image_surface_get_height(m_surface));
+	}
+	virtual cairo_surface_t *read(GdkScreen *screen, const Rect2<int> &area, int max_size)
+	{
+		m_changed = false;
+		if (!m_area_surface || cairo_image_surface_get_width(m_area_surface) < max_size){
+			if (m_area_surface) cairo_surface_destroy(m_area_surface);
+			m_area_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, max_size, max_size);
+		}
+		cairo_t *cr = cairo_create(m_area_surface);
+		cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+		cairo_set_source_surface(cr, m_surface, -area.getX(), -area.getY());
+		cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
+		cairo_rectangle(cr, 0, 0, area.getWidth(), area.getHeight());
+		cairo_fill(cr);
+		cairo_destroy(cr);
+		return m_area_surface;
+	}
+	virtual ScreenSourceChange getChange(GdkScreen *screen, const Rect2<int> &area)
+	{
+		return m_changed ? ScreenSourceChange::changed : ScreenSourceChange::unchanged;
+	}
+};
+ScreenSource* screen_source_new_display(bool allow_shm)
+{
+	return new DisplayScreenSource(allow_shm);
+}
+ScreenSource* screen_source_new_surface(cairo_surface_t *surface)
+{
+	return new SurfaceScreenSource(surface);
+}
+ScreenSource* screen_source_new_image(const char *filename, std::string &error)
+{
+	GError *gerror = nullptr;
+	GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file(filename, &gerror);
+	if (!pixbuf){
+		error = gerror->message;
+		g_error_free(gerror);
+		return nullptr;
+	}
+	cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf));
+	cairo_t *cr = cairo_create(surface);
+	gdk_cairo_set_source_pixbuf(cr, pixbuf, 0, 0);
+	cairo_paint(cr);
+	cairo_destroy(cr);
+	g_object_unref(pixbuf);
+	ScreenSource *source = new SurfaceScreenSource(surface);
+	cairo_surface_destroy(surface);
+	return source;
+}
+void screen_source_set_surface(ScreenSource *source, cairo_surface_t *surface)
+{
+	SurfaceScreenSource *surface_source = dynamic_cast<SurfaceScreenSource*>(source);
+	if (surface_source) surface_source->setSurface(surface);
+}
+void screen_source_set_pointer_path(ScreenSource *source, const std::vector<math::Vec2<int>> &path)
+{
+	SurfaceScreenSource *surface_source = dynamic_cast<SurfaceScreenSource*>(source);
+	if (surface_source) surface_source->setPointerPath(path);
+}
+bool screen_source_uses_shm(ScreenSource *source)
+{
+#ifdef GPICK_SCREEN_SOURCE_XSHM
+	DisplayScreenSource *display_source = dynamic_cast<DisplayScreenSource*>(source);
+	return display_source && display_source->m_shm.state == ScreenSourceShm::State::available;
+#else
+	return false;
+#endif
+}
+std::vector<math::Vec2<int>> screen_source_build_pointer_path(const std::vector<math::Vec2<int>> &points, int step)
+{
+	vector<Vec2<int>> path;
+	if (points.empty()) return path;
+	step = std::max(step, 1);
+	path.push_back(points.front());
+	for (size_t i = 1; i < points.size(); i++){
+		const Vec2<int> &from = points[i - 1], &to = points[i];
+		int dx = to.x - from.x, dy = to.y - from.y;
+		int steps = std::max(1, static_cast<int>(std::ceil(std::sqrt(double(dx) * dx + double(dy) * dy) / step)));
+		for (int j = 1; j <= steps; j++){
+			path.push_back(Vec2<int>(from.x + dx * j / steps, from.y + dy * j / steps));
+		}
+	}
+	return path;
+}
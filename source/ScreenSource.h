@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_SCREEN_SOURCE_H_
+#define GPICK_SCREEN_SOURCE_H_
+
+#include <gdk/gdk.h>
+#include <cairo/cairo.h>
+#include "Rect2.h"
+#include "Vector2.h"
+#include <string>
+#include <vector>
+
+enum class ScreenSourceChange
+{
+	unchanged, /**< Screen contents inside area did not change since the last read */
+	changed, /**< Screen contents inside area changed since the last read */
+	unknown, /**< Source does not track screen changes */
+};
+/** \struct ScreenSource
+ * \brief Source of screen pixels and pointer position used by screen reader and pickers.
+ *
+ * Display source reads root window of a GDK screen. Surface source serves pixels from a cairo surface and moves pointer along a scripted path, so that picking can be exercised without a display.
+ */
+struct ScreenSource
+{
+	virtual ~ScreenSource();
+	/** Get pointer position, screen containing it and geometry of the monitor under pointer */
+	virtual void getPointer(GdkScreen **screen, math::Vec2<int> &pointer, math::Rect2<int> &monitor_rect) = 0;
+	/** Get geometry of the whole screen */
+	virtual math::Rect2<int> getScreenRect(GdkScreen *screen) = 0;
+	/** Read area of the screen.
+	 * @param[in] screen Screen returned by getPointer().
+	 * @param[in] area Area to read.
+	 * @param[in] max_size Area width and height limit, sources can use it to allocate surfaces once.
+	 * @return Surface owned by the source with area pixels starting at 0,0, or nullptr on failure. Surface stays valid until the next read.
+	 */
+	virtual cairo_surface_t *read(GdkScreen *screen, const math::Rect2<int> &area, int max_size) = 0;
+	/** Check whether screen contents inside area changed since the last read */
+	virtual ScreenSourceChange getChange(GdkScreen *screen, const math::Rect2<int> &area) = 0;
+};
+/** Create source reading root window of GDK screens. MIT-SHM and X Damage extensions are used when available.
+ * @param[in] allow_shm Use MIT-SHM capture. When disabled, screen is always read through cairo, which allows comparing both capture methods.
+ */
+ScreenSource* screen_source_new_display(bool allow_shm = true);
+/** Create source serving pixels from a cairo image surface. Surface reference is taken.
+ * Pointer stays at the center of the surface until pointer path is set.
+ */
+ScreenSource* screen_source_new_surface(cairo_surface_t *surface);
+/** Create source serving pixels of an image file.
+ * @return Source or nullptr if image can not be loaded.
+ */
+ScreenSource* screen_source_new_image(const char *filename, std::string &error);
+/** Replace surface of surface source. All areas are reported as changed after replacement. */
+void screen_source_set_surface(ScreenSource *source, cairo_surface_t *surface);
+/** Set pointer path of surface source. Each getPointer() call returns the next point, path is repeated after the last point. */
+void screen_source_set_pointer_path(ScreenSource *source, const std::vector<math::Vec2<int>> &path);
+/** Check whether display source reads the screen through MIT-SHM. Result is known only after the first read, other sources always return false */
+bool screen_source_uses_shm(ScreenSource *source);
+/** Build pointer path moving along straight line segments between points with given step in pixels */
+std::vector<math::Vec2<int>> screen_source_build_pointer_path(const std::vector<math::Vec2<int>> &points, int step);
+
+#endif /* GPICK_SCREEN_SOURCE_H_ */
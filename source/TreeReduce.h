@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_TREE_REDUCE_H_
+#define GPICK_TREE_REDUCE_H_
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+/** \file source/TreeReduce.h
+ * \brief Reduction of space partitioning trees by merging nodes with the smallest color distances.
+ */
+
+/**
+ * Merge node and its subtree into the parent of node. Root node keeps values of its children instead.
+ * @return Number of nodes with values removed from the tree
+ */
+template<typename Node, typename IsLeaf, typename Merge>
+uint32_t tree_reduce_merge_subtree(std::vector<Node> &nodes, uint32_t index, IsLeaf &is_leaf, Merge &merge, std::vector<bool> &merged)
+{
+	const size_t child_count = std::extent<decltype(Node::child)>::value;
+	Node &node = nodes[index];
+	bool was_leaf = is_leaf(node);
+	uint32_t removed = 0;
+	for (size_t i = 0; i < child_count; i++){
+		if (node.child[i]){
+			removed += tree_reduce_merge_subtree(nodes, node.child[i], is_leaf, merge, merged);
+			node.child[i] = 0;
+		}
+	}
+	if (index != 0){
+		merge(nodes[node.parent], node);
+		merged[index] = true;
+		if (was_leaf) removed++;
+	}
+	return removed;
+}
+
+/**
+ * Merge nodes with the smallest distances into their parents.
+ * All nodes with distance not larger than threshold are merged first, then nodes are merged in order of increasing distance until no more than max_leafs nodes contain values.
+ * Nodes with equal distance are always merged together, and a merged node takes its whole subtree with it.
+ * This gives the same result as repeatedly sweeping the whole tree with an increasing distance threshold, but each node is visited only a constant number of times.
+ * Tree is stored in a node array with root at index 0. Node type must have child index array child (0 if there is no child), parent index parent and distance.
+ * Merged nodes are unlinked from the tree, but stay in the node array.
+ * @param[in,out] nodes Node array
+ * @param[in] threshold Distance threshold for the first pass, use negative value to skip it
+ * @param[in] max_leafs Maximum number of nodes with values
+ * @param[in] is_leaf Function returning true if node contains values
+ * @param[in] merge Function adding values of node (second argument) to its parent (first argument)
+ */
+template<typename Node, typename IsLeaf, typename Merge>
+void tree_reduce(std::vector<Node> &nodes, double threshold, uint32_t max_leafs, IsLeaf is_leaf, Merge merge)
+{
+	if (nodes.empty()) return;
+	const size_t child_count = std::extent<decltype(Node::child)>::value;
+	struct Item{
+		double distance;
+		uint32_t order; /**< Tree traversal order, nodes with equal distance are merged in the same order as in a tree sweep */
+		uint32_t index;
+		bool operator<(const Item &item) const {
+			if (distance != item.distance) return distance > item.distance;
+			return order > item.order;
+		}
+	};
+	std::vector<Item> heap;
+	uint32_t leafs = 0;
+	std::vector<uint32_t> stack;
+	stack.push_back(0);
+	while (!stack.empty()){
+		uint32_t index = stack.back();
+		stack.pop_back();
+		const Node &node = nodes[index];
+		Item item = {static_cast<double>(node.distance), static_cast<uint32_t>(heap.size()), index};
+		heap.push_back(item);
+		if (is_leaf(node)) leafs++;
+		for (size_t i = child_count; i > 0; i--){
+			if (node.child[i - 1]) stack.push_back(node.child[i - 1]);
+		}
+	}
+	std::make_heap(heap.begin(), heap.end());
+	std::vector<bool> merged(nodes.size(), false);
+	auto merge_group = [&](double limit){
+		while (!heap.empty() && heap.front().distance <= limit){
+			uint32_t index = heap.front().index;
+			std::pop_heap(heap.begin(), heap.end());
+			heap.pop_back();
+			if (merged[index]) continue;
+			uint32_t parent_index = index == 0 ? 0 : nodes[index].parent;
+			Node &parent = nodes[parent_index];
+			bool parent_was_leaf = is_leaf(parent);
+			if (index != 0){
+				for (size_t i = 0; i < child_count; i++){
+					if (parent.child[i] == index) parent.child[i] = 0;
+				}
+			}
+			leafs -= tree_reduce_merge_subtree(nodes, index, is_leaf, merge, merged);
+			if (!parent_was_leaf && is_leaf(parent)) leafs++;
+			if (index == 0){
+				heap.clear();
+				return;
+			}
+		}
+	};
+	merge_group(threshold);
+	while (leafs > max_leafs && !heap.empty()){
+		merge_group(heap.front().distance);
+	}
+}
+#endif /* GPICK_TREE_REDUCE_H_ */
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Benchmark.h"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string.h>
+#include <stdlib.h>
+using namespace std;
+
+namespace bench
+{
+	static string json_escape(const string &value)
+	{
+		stringstream result;
+		for (auto c: value){
+			switch (c){
+				case '"': result << "\\\""; break;
+				case '\\': result << "\\\\"; break;
+				case '\n': result << "\\n"; break;
+				case '\t': result << "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20)
+						result << "\\u" << hex << setw(4) << setfill('0') << int(c) << dec;
+					else
+						result << c;
+			}
+		}
+		return result.str();
+	}
+	Runner::Runner(const char *suite, int argc, char **argv):
+		m_suite(suite),
+		m_min_time(0.5)
+	{
+		for (int i = 1; i < argc; i++){
+			if (strncmp(argv[i], "--filter=", 9) == 0){
+				m_filter = argv[i] + 9;
+			}else if (strncmp(argv[i], "--min-time=", 11) == 0){
+				m_min_time = atof(argv[i] + 11);
+			}else{
+				m_arguments.push_back(argv[i]);
+			}
+		}
+	}
+	void Runner::run(const string &name, size_t items, function<void()> function)
+	{
+		if (!m_filter.empty() && name.find(m_filter) == string::npos) return;
+		typedef chrono::steady_clock Clock;
+		uint64_t iterations = 1;
+		double elapsed = 0;
+		for (;;){
+			auto start = Clock::now();
+			for (uint64_t i = 0; i < iterations; i++)
+				function();
+			elapsed = chrono::duration<double>(Clock::now() - start).count();
+			if (elapsed >= m_min_time) break;
+			uint64_t next = (elapsed > 0) ? uint64_t(iterations * (m_min_time * 1.2 / elapsed)) : iterations * 10;
+			iterations = max(iterations * 2, min(next, iterations * 100));
+		}
+		Result result;
+		result.name = name;
+		result.iterations = iterations;
+		result.items = items;
+		result.ns_per_op = elapsed * 1e9 / (iterations * double(items));
+		result.items_per_second = items * iterations / elapsed;
+		m_results.push_back(result);
+		cerr << name << ": " << result.ns_per_op << " ns/op, " << result.items_per_second << " items/s" << endl;
+	}
+	void Runner::setProperty(const string &name, const string &value)
+	{
+		m_properties.push_back(make_pair(name, value));
+	}
+	const char *Runner::getArgument(size_t index) const
+	{
+		if (index >= m_arguments.size()) return nullptr;
+		return m_arguments[index].c_str();
+	}
+	int Runner::finish()
+	{
+		cout << "{\n\t\"suite\": \"" << json_escape(m_suite) << "\",\n";
+		for (auto &property: m_properties){
+			cout << "\t\"" << json_escape(property.first) << "\": \"" << json_escape(property.second) << "\",\n";
+		}
+		cout << "\t\"results\": [";
+		cout << setprecision(6);
+		for (size_t i = 0; i < m_results.size(); i++){
+			const Result &result = m_results[i];
+			cout << (i ? ",\n" : "\n") << "\t\t{\"name\": \"" << json_escape(result.name) << "\", \"iterations\": " << result.iterations << ", \"items\": " << result.items << ", \"ns_per_op\": " << result.ns_per_op << ", \"items_per_second\": " << result.items_per_second << "}";
+		}
+		cout << "\n\t]\n}" << endl;
+		return 0;
+	}
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_BENCH_BENCHMARK_H_
+#define GPICK_BENCH_BENCHMARK_H_
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdint.h>
+#include <stddef.h>
+
+/** \file source/bench/Benchmark.h
+ * \brief Minimal microbenchmark runner producing JSON results.
+ */
+
+namespace bench
+{
+	/** \struct Result
+	 * \brief Timing of a single benchmark.
+	 */
+	struct Result
+	{
+		std::string name;
+		uint64_t iterations; /**< Number of times benchmark function was called */
+		size_t items; /**< Number of items processed by one call */
+		double ns_per_op; /**< Nanoseconds per processed item */
+		double items_per_second;
+	};
+
+	/** \struct Runner
+	 * \brief Runs benchmark functions until minimum time elapses and collects results.
+	 *
+	 * Recognized command line arguments: "--filter=<substring>" runs only benchmarks with matching names,
+	 * "--min-time=<seconds>" sets minimum measurement time for each benchmark.
+	 */
+	struct Runner
+	{
+		Runner(const char *suite, int argc, char **argv);
+		/**
+		 * Measure function.
+		 * @param[in] name Benchmark name.
+		 * @param[in] items Number of items processed by one call of function, used to calculate items per second.
+		 * @param[in] function Function to measure.
+		 */
+		void run(const std::string &name, size_t items, std::function<void()> function);
+		/**
+		 * Add free form information to JSON output.
+		 */
+		void setProperty(const std::string &name, const std::string &value);
+		/**
+		 * Get positional command line argument.
+		 * @return Argument or nullptr if there are not enough arguments.
+		 */
+		const char *getArgument(size_t index) const;
+		/**
+		 * Write results as JSON to standard output.
+		 * @return Process exit code.
+		 */
+		int finish();
+		private:
+		std::string m_suite;
+		std::string m_filter;
+		double m_min_time;
+		std::vector<std::string> m_arguments;
+		std::vector<std::pair<std::string, std::string>> m_properties;
+		std::vector<Result> m_results;
+	};
+
+	/**
+	 * Prevent compiler from optimizing away computation of value.
+	 */
+	template<typename T> inline void keep(const T &value)
+	{
+#if defined(__GNUC__)
+		asm volatile("" : : "g"(&value) : "memory");
+#else
+		static const void * volatile sink;
+		sink = &value;
+#endif
+	}
+}
+#endif /* GPICK_BENCH_BENCHMARK_H_ */
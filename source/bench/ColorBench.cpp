@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench/Benchmark.h"
+#include "Color.h"
+#include "ColorPipeline.h"
+#include <vector>
+using namespace std;
+
+const size_t ColorCount = 4096;
+
+static vector<Color> build_rgb_colors()
+{
+	vector<Color> colors(ColorCount);
+	uint32_t seed = 1;
+	for (auto &color: colors){
+		for (int i = 0; i < 3; i++){
+			seed = seed * 1664525 + 1013904223;
+			color.ma[i] = (seed >> 8) / float(1 << 24);
+		}
+		color.ma[3] = 0;
+	}
+	return colors;
+}
+static vector<Color> convert(const vector<Color> &colors, void (*function)(const Color*, Color*))
+{
+	vector<Color> result(colors.size());
+	for (size_t i = 0; i < colors.size(); i++)
+		function(&colors[i], &result[i]);
+	return result;
+}
+int main(int argc, char **argv)
+{
+	color_init();
+	bench::Runner runner("color", argc, argv);
+	runner.setProperty("batch_kernel", matrix3x3_get_batch_kernel_name());
+	auto rgb = build_rgb_colors();
+	auto hsv = convert(rgb, color_rgb_to_hsv);
+	auto hsl = convert(rgb, color_rgb_to_hsl);
+	auto lab = convert(rgb, color_rgb_to_lab_d50);
+	auto lch = convert(rgb, color_rgb_to_lch_d50);
+	auto cmy = convert(rgb, color_rgb_to_cmy);
+	auto cmyk = convert(rgb, color_rgb_to_cmyk);
+	auto linear = convert(rgb, color_rgb_get_linear);
+	vector<Color> xyz(ColorCount);
+	for (size_t i = 0; i < ColorCount; i++)
+		color_rgb_to_xyz(&rgb[i], &xyz[i], color_get_sRGB_transformation_matrix());
+	vector<Color> output(ColorCount);
+	auto single = [&](const char *name, const vector<Color> &input, void (*function)(const Color*, Color*)){
+		runner.run(name, ColorCount, [&](){
+			for (size_t i = 0; i < ColorCount; i++)
+				function(&input[i], &output[i]);
+			bench::keep(output);
+		});
+	};
+	auto batch = [&](const char *name, const vector<Color> &input, void (*function)(const Color*, Color*, size_t)){
+		runner.run(name, ColorCount, [&](){
+			function(input.data(), output.data(), ColorCount);
+			bench::keep(output);
+		});
+	};
+	single("rgb_to_hsv", rgb, color_rgb_to_hsv);
+	single("hsv_to_rgb", hsv, color_hsv_to_rgb);
+	single("rgb_to_hsl", rgb, color_rgb_to_hsl);
+	single("hsl_to_rgb", hsl, color_hsl_to_rgb);
+	single("hsl_to_hsv", hsl, color_hsl_to_hsv);
+	single("hsv_to_hsl", hsv, color_hsv_to_hsl);
+	single("rgb_to_cmy", rgb, color_rgb_to_cmy);
+	single("cmy_to_rgb", cmy, color_cmy_to_rgb);
+	single("cmy_to_cmyk", cmy, color_cmy_to_cmyk);
+	single("cmyk_to_cmy", cmyk, color_cmyk_to_cmy);
+	single("rgb_to_cmyk", rgb, color_rgb_to_cmyk);
+	single("cmyk_to_rgb", cmyk, color_cmyk_to_rgb);
+	single("rgb_get_linear", rgb, color_rgb_get_linear);
+	single("linear_get_rgb", linear, color_linear_get_rgb);
+	single("rgb_get_linear_fast", rgb, color_rgb_get_linear_fast);
+	single("linear_get_rgb_fast", linear, color_linear_get_rgb_fast);
+	single("lab_to_lch", lab, color_lab_to_lch);
+	single("lch_to_lab", lch, color_lch_to_lab);
+	single("rgb_to_lab_d50", rgb, color_rgb_to_lab_d50);
+	single("lab_to_rgb_d50", lab, color_lab_to_rgb_d50);
+	single("rgb_to_lch_d50", rgb, color_rgb_to_lch_d50);
+	single("lch_to_rgb_d50", lch, color_lch_to_rgb_d50);
+	single("rgb_to_lab_d50_fast", rgb, color_rgb_to_lab_d50_fast);
+	single("rgb_to_lch_d50_fast", rgb, color_rgb_to_lch_d50_fast);
+	runner.run("rgb_to_xyz", ColorCount, [&](){
+		for (size_t i = 0; i < ColorCount; i++)
+			color_rgb_to_xyz(&rgb[i], &output[i], color_get_sRGB_transformation_matrix());
+		bench::keep(output);
+	});
+	runner.run("xyz_to_rgb", ColorCount, [&](){
+		for (size_t i = 0; i < ColorCount; i++)
+			color_xyz_to_rgb(&xyz[i], &output[i], color_get_inverted_sRGB_transformation_matrix());
+		bench::keep(output);
+	});
+	const vector3 *d65 = color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2);
+	runner.run("xyz_to_lab", ColorCount, [&](){
+		for (size_t i = 0; i < ColorCount; i++)
+			color_xyz_to_lab(&xyz[i], &output[i], d65);
+		bench::keep(output);
+	});
+	runner.run("lab_to_xyz", ColorCount, [&](){
+		for (size_t i = 0; i < ColorCount; i++)
+			color_lab_to_xyz(&lab[i], &output[i], d65);
+		bench::keep(output);
+	});
+	batch("rgb_to_lab_d50_batch", rgb, color_rgb_to_lab_d50_batch);
+	batch("lab_to_rgb_d50_batch", lab, color_lab_to_rgb_d50_batch);
+	batch("rgb_to_lch_d50_batch", rgb, color_rgb_to_lch_d50_batch);
+	batch("lch_to_rgb_d50_batch", lch, color_lch_to_rgb_d50_batch);
+	batch("rgb_to_hsv_batch", rgb, color_rgb_to_hsv_batch);
+	batch("hsv_to_rgb_batch", hsv, color_hsv_to_rgb_batch);
+	batch("rgb_to_hsl_batch", rgb, color_rgb_to_hsl_batch);
+	batch("hsl_to_rgb_batch", hsl, color_hsl_to_rgb_batch);
+	vector<unsigned char> rgb8(ColorCount * 3);
+	for (size_t i = 0; i < rgb8.size(); i++)
+		rgb8[i] = static_cast<unsigned char>(rgb[i / 3].ma[i % 3] * 255);
+	runner.run("rgb8_to_rgb_batch", ColorCount, [&](){
+		color_rgb8_to_rgb_batch(rgb8.data(), 3, ColorCount, output.data());
+		bench::keep(output);
+	});
+	RgbToLabPipeline rgb_to_lab;
+	RgbToLabFastPipeline rgb_to_lab_fast;
+	LabToRgbPipeline lab_to_rgb;
+	runner.run("pipeline_rgb_to_lab", ColorCount, [&](){
+		for (size_t i = 0; i < ColorCount; i++)
+			rgb_to_lab(&rgb[i], &output[i]);
+		bench::keep(output);
+	});
+	runner.run("pipeline_rgb_to_lab_batch", ColorCount, [&](){
+		rgb_to_lab(rgb.data(), output.data(), ColorCount);
+		bench::keep(output);
+	});
+	runner.run("pipeline_rgb_to_lab_fast_batch", ColorCount, [&](){
+		rgb_to_lab_fast(rgb.data(), output.data(), ColorCount);
+		bench::keep(output);
+	});
+	runner.run("pipeline_lab_to_rgb_batch", ColorCount, [&](){
+		lab_to_rgb(lab.data(), output.data(), ColorCount);
+		bench::keep(output);
+	});
+	vector<float> distances(ColorCount);
+	runner.run("distance", ColorCount, [&](){
+		for (size_t i = 0; i < ColorCount; i++)
+			distances[i] = color_distance(&lab[i], &lab[ColorCount - 1 - i]);
+		bench::keep(distances);
+	});
+	runner.run("distance_lch", ColorCount, [&](){
+		for (size_t i = 0; i < ColorCount; i++)
+			distances[i] = color_distance_lch(&lab[i], &lab[ColorCount - 1 - i]);
+		bench::keep(distances);
+	});
+	return runner.finish();
+}
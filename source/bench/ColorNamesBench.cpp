@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench/Benchmark.h"
+#include "color_names/ColorNames.h"
+#include "Color.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <vector>
+#include <sstream>
+using namespace std;
+
+const size_t QueryCount = 1024;
+const size_t SyntheticDictionarySize = 32768;
+
+static vector<Color> build_queries()
+{
+	vector<Color> colors(QueryCount);
+	uint32_t seed = 7;
+	for (auto &color: colors){
+		for (int i = 0; i < 3; i++){
+			seed = seed * 1664525 + 1013904223;
+			color.ma[i] = (seed >> 8) / float(1 << 24);
+		}
+		color.ma[3] = 0;
+	}
+	return colors;
+}
+static string write_synthetic_dictionary(size_t size)
+{
+	gchar *filename = nullptr;
+	gint fd = g_file_open_tmp("gpick_bench_XXXXXX.txt", &filename, nullptr);
+	if (fd < 0) return string();
+	stringstream data;
+	uint32_t seed = 11;
+	for (size_t i = 0; i < size; i++){
+		seed = seed * 1664525 + 1013904223;
+		data << ((seed >> 8) & 0xff) << " " << ((seed >> 16) & 0xff) << " " << ((seed >> 24) & 0xff) << " Color " << i << "\n";
+	}
+	string content = data.str();
+	FILE *file = fdopen(fd, "w");
+	fwrite(content.data(), 1, content.size(), file);
+	fclose(file);
+	string result = filename;
+	g_free(filename);
+	return result;
+}
+static void run_dictionary(bench::Runner &runner, const string &prefix, const char *filename, const vector<Color> &queries)
+{
+	runner.run(prefix + "load", 1, [&](){
+		ColorNames *color_names = color_names_new();
+		color_names_load_from_file(color_names, filename);
+		color_names_destroy(color_names);
+	});
+	ColorNames *color_names = color_names_new();
+	color_names_load_from_file(color_names, filename);
+	runner.run(prefix + "get", QueryCount, [&](){
+		for (auto &query: queries){
+			string name = color_names_get(color_names, &query, true);
+			bench::keep(name);
+		}
+	});
+	ColorNamesCacheStatistics statistics = color_names_get_cache_statistics(color_names);
+	runner.setProperty(prefix + "get_cache_hits", to_string(statistics.hits));
+	runner.setProperty(prefix + "get_cache_misses", to_string(statistics.misses));
+	vector<pair<const char*, Color>> nearest;
+	runner.run(prefix + "find_nearest_10", QueryCount, [&](){
+		for (auto &query: queries){
+			color_names_find_nearest(color_names, query, 10, nearest);
+			bench::keep(nearest);
+		}
+	});
+	color_names_destroy(color_names);
+}
+int main(int argc, char **argv)
+{
+	color_init();
+	bench::Runner runner("color_names", argc, argv);
+	auto queries = build_queries();
+	const char *dictionary = runner.getArgument(0);
+	if (!dictionary) dictionary = "share/gpick/color_dictionary_0.txt";
+	runner.setProperty("dictionary", dictionary);
+	run_dictionary(runner, "", dictionary, queries);
+	string synthetic = write_synthetic_dictionary(SyntheticDictionarySize);
+	if (!synthetic.empty()){
+		run_dictionary(runner, "synthetic_32k_", synthetic.c_str(), queries);
+		g_remove(synthetic.c_str());
+	}
+	return runner.finish();
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench/Benchmark.h"
+#include "FileFormat.h"
+#include "ColorList.h"
+#include "ColorObject.h"
+#include "Color.h"
+#include "dynv/DynvSystem.h"
+#include "dynv/DynvVarString.h"
+#include "dynv/DynvVarInt32.h"
+#include "dynv/DynvVarColor.h"
+#include "dynv/DynvVarFloat.h"
+#include "dynv/DynvVarDynv.h"
+#include "dynv/DynvVarBool.h"
+#include "dynv/DynvVarPtr.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <sstream>
+using namespace std;
+
+const size_t PaletteSize = 4096;
+
+static dynvHandlerMap* build_handler_map()
+{
+	auto handler_map = dynv_handler_map_create();
+	dynv_handler_map_add_handler(handler_map, dynv_var_string_new());
+	dynv_handler_map_add_handler(handler_map, dynv_var_int32_new());
+	dynv_handler_map_add_handler(handler_map, dynv_var_color_new());
+	dynv_handler_map_add_handler(handler_map, dynv_var_ptr_new());
+	dynv_handler_map_add_handler(handler_map, dynv_var_float_new());
+	dynv_handler_map_add_handler(handler_map, dynv_var_dynv_new());
+	dynv_handler_map_add_handler(handler_map, dynv_var_bool_new());
+	return handler_map;
+}
+int main(int argc, char **argv)
+{
+	color_init();
+	bench::Runner runner("file_format", argc, argv);
+	gchar *filename = nullptr;
+	gint fd = g_file_open_tmp("gpick_bench_XXXXXX.gpa", &filename, nullptr);
+	if (fd < 0) return 1;
+	fclose(fdopen(fd, "wb"));
+	auto handler_map = build_handler_map();
+	ColorList *color_list = color_list_new(handler_map);
+	uint32_t seed = 9;
+	for (size_t i = 0; i < PaletteSize; i++){
+		Color color;
+		for (int j = 0; j < 3; j++){
+			seed = seed * 1664525 + 1013904223;
+			color.ma[j] = (seed >> 8) / float(1 << 24);
+		}
+		color.ma[3] = 0;
+		stringstream name;
+		name << "Color " << i;
+		ColorObject *color_object = new ColorObject(name.str(), color);
+		color_list_add_color_object(color_list, color_object, true);
+		color_object->release();
+	}
+	runner.run("palette_file_save", PaletteSize, [&](){
+		palette_file_save(filename, color_list);
+	});
+	runner.run("palette_file_load", PaletteSize, [&](){
+		ColorList *loaded = color_list_new(handler_map);
+		palette_file_load(filename, loaded);
+		color_list_destroy(loaded);
+	});
+	color_list_destroy(color_list);
+	dynv_handler_map_release(handler_map);
+	g_remove(filename);
+	g_free(filename);
+	return runner.finish();
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench/Benchmark.h"
+#include "tools/Octree.h"
+#include "tools/Quantizer.h"
+#include "Color.h"
+#include <vector>
+#include <math.h>
+using namespace std;
+
+const int ImageWidth = 1024;
+const int ImageHeight = 768;
+const int ImageChannels = 4;
+
+/** Build image with smooth gradients and some noise, which results in a realistically populated tree */
+static vector<unsigned char> build_image()
+{
+	vector<unsigned char> image(ImageWidth * ImageHeight * ImageChannels);
+	uint32_t seed = 3;
+	for (int y = 0; y < ImageHeight; y++){
+		for (int x = 0; x < ImageWidth; x++){
+			unsigned char *pixel = &image[(y * ImageWidth + x) * ImageChannels];
+			seed = seed * 1664525 + 1013904223;
+			int noise = int((seed >> 24) & 0x1f) - 16;
+			pixel[0] = static_cast<unsigned char>(clamp_int(x * 255 / ImageWidth + noise, 0, 255));
+			pixel[1] = static_cast<unsigned char>(clamp_int(y * 255 / ImageHeight + noise, 0, 255));
+			pixel[2] = static_cast<unsigned char>(clamp_int(int(127 + 127 * sin(x * 0.01 + y * 0.02)) + noise, 0, 255));
+			pixel[3] = 0xff;
+		}
+	}
+	return image;
+}
+/** Build image which looks like user interface screenshot: flat rectangles with antialiased edges */
+static vector<unsigned char> build_flat_image()
+{
+	vector<unsigned char> image(ImageWidth * ImageHeight * ImageChannels);
+	const unsigned char palette[][3] = {{240, 240, 240}, {52, 101, 164}, {255, 255, 255}, {46, 52, 54}, {204, 0, 0}, {115, 210, 22}};
+	for (int y = 0; y < ImageHeight; y++){
+		for (int x = 0; x < ImageWidth; x++){
+			unsigned char *pixel = &image[(y * ImageWidth + x) * ImageChannels];
+			int cell = ((x / 96) * 7 + (y / 64) * 3) % 6;
+			bool edge = x % 96 == 0 || y % 64 == 0;
+			for (int i = 0; i < 3; i++){
+				pixel[i] = edge ? (palette[cell][i] + palette[(cell + 1) % 6][i]) / 2 : palette[cell][i];
+			}
+			pixel[3] = 0xff;
+		}
+	}
+	return image;
+}
+int main(int argc, char **argv)
+{
+	color_init();
+	bench::Runner runner("palette_from_image", argc, argv);
+	auto image = build_image();
+	const size_t pixels = ImageWidth * ImageHeight;
+	runner.run("octree_build", pixels, [&](){
+		Octree *tree = octree_new();
+		octree_add_rgb8(tree, image.data(), ImageChannels, ImageWidth, ImageHeight, ImageWidth * ImageChannels, 5);
+		octree_delete(tree);
+	});
+	runner.run("octree_build_parallel", pixels, [&](){
+		Octree *tree = octree_new();
+		octree_add_rgb8_parallel(tree, image.data(), ImageChannels, ImageWidth, ImageHeight, ImageWidth * ImageChannels, 5, 0, nullptr);
+		octree_delete(tree);
+	});
+	Octree *tree = octree_new();
+	octree_add_rgb8(tree, image.data(), ImageChannels, ImageWidth, ImageHeight, ImageWidth * ImageChannels, 5);
+	uint32_t leafs = octree_count_leafs(tree);
+	runner.run("octree_copy", leafs, [&](){
+		octree_delete(octree_copy(tree));
+	});
+	runner.run("octree_reduce_200", leafs, [&](){
+		Octree *copy = octree_copy(tree);
+		octree_reduce(copy, 200);
+		octree_delete(copy);
+	});
+	runner.run("octree_reduce_16", leafs, [&](){
+		Octree *copy = octree_copy(tree);
+		octree_reduce(copy, 16);
+		octree_delete(copy);
+	});
+	// Preview updates start from a compacted tree which was already reduced to 200 colors
+	Octree *reduced = octree_copy(tree);
+	octree_reduce(reduced, 200);
+	octree_compact(reduced);
+	runner.run("octree_preview_16", 1, [&](){
+		Octree *copy = octree_copy(reduced);
+		octree_reduce(copy, 16);
+		octree_delete(copy);
+	});
+	octree_delete(reduced);
+	octree_delete(tree);
+	vector<QuantizerColor> histogram;
+	runner.run("histogram_build", pixels, [&](){
+		quantizer_histogram_rgb8(image.data(), ImageChannels, ImageWidth, ImageHeight, ImageWidth * ImageChannels, histogram);
+	});
+	runner.run("histogram_build_parallel", pixels, [&](){
+		vector<QuantizerColor> colors;
+		QuantizerHistogram *builder = quantizer_histogram_new();
+		quantizer_histogram_add_rgb8_parallel(builder, image.data(), ImageChannels, ImageWidth, ImageHeight, ImageWidth * ImageChannels, 0);
+		quantizer_histogram_get_colors(builder, colors);
+		quantizer_histogram_destroy(builder);
+	});
+	runner.run("octree_build_from_histogram", histogram.size(), [&](){
+		Octree *tree = octree_new();
+		for (auto &color: histogram){
+			octree_add_color(tree, &color.color, color.weight, 5);
+		}
+		octree_delete(tree);
+	});
+	runner.run("octree_build_from_histogram_parallel", histogram.size(), [&](){
+		Octree *tree = octree_new();
+		octree_add_colors_parallel(tree, histogram.data(), histogram.size(), 5, 0, nullptr);
+		octree_delete(tree);
+	});
+	// Flat artwork has large areas of few colors
+	auto flat_image = build_flat_image();
+	runner.run("octree_build_flat", pixels, [&](){
+		Octree *tree = octree_new();
+		octree_add_rgb8(tree, flat_image.data(), ImageChannels, ImageWidth, ImageHeight, ImageWidth * ImageChannels, 5);
+		octree_delete(tree);
+	});
+	runner.run("histogram_build_flat", pixels, [&](){
+		vector<QuantizerColor> flat_histogram;
+		quantizer_histogram_rgb8(flat_image.data(), ImageChannels, ImageWidth, ImageHeight, ImageWidth * ImageChannels, flat_histogram);
+		Octree *tree = octree_new();
+		for (auto &color: flat_histogram){
+			octree_add_color(tree, &color.color, color.weight, 5);
+		}
+		octree_delete(tree);
+	});
+	for (uint32_t i = 0; i < quantizers_get_n(); i++){
+		const Quantizer &quantizer = quantizers_get()[i];
+		runner.run(string("quantize_") + quantizer.name + "_16", histogram.size(), [&](){
+			vector<Color> palette;
+			quantizer.quantize(histogram.data(), histogram.size(), 16, palette);
+		});
+	}
+	return runner.finish();
+}
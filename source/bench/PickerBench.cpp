@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench/Benchmark.h"
+#include "ScreenReader.h"
+#include "ScreenSource.h"
+#include "Sampler.h"
+#include "PickerTimings.h"
+#include "color_names/ColorNames.h"
+#include "Color.h"
+#include <cairo/cairo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <string>
+using namespace math;
+using namespace std;
+
+const int ScreenWidth = 1920;
+const int ScreenHeight = 1080;
+const int ZoomedSize = 150; /**< Zoomed view size in pixels, same as default picker zoomed view */
+const int ZoomedArea = 30; /**< Screen area shown in zoomed view, corresponds to 5x zoom */
+const size_t LatencyTicks = 2000;
+const int DisplayCheckSize = 512; /**< Largest screen area compared between MIT-SHM and cairo captures */
+
+/** Build frame with smooth gradients and a grid of solid rectangles, so that sampling sees both flat and changing areas */
+static cairo_surface_t *build_frame(uint32_t seed)
+{
+	cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, ScreenWidth, ScreenHeight);
+	cairo_surface_flush(surface);
+	unsigned char *data = cairo_image_surface_get_data(surface);
+	int stride = cairo_image_surface_get_stride(surface);
+	for (int y = 0; y < ScreenHeight; y++){
+		uint32_t *row = reinterpret_cast<uint32_t*>(data + y * stride);
+		for (int x = 0; x < ScreenWidth; x++){
+			uint32_t r = (x * 255 / ScreenWidth + seed) & 0xff, g = (y * 255 / ScreenHeight) & 0xff, b = ((x / 64 + y / 64) * 37 + seed) & 0xff;
+			row[x] = (r << 16) | (g << 8) | b;
+		}
+	}
+	cairo_surface_mark_dirty(surface);
+	return surface;
+}
+/** State of a single headless picker, mirroring main color picker update */
+struct PickerTick
+{
+	ScreenReader *m_screen_reader;
+	Sampler *m_sampler;
+	ColorNames *m_color_names;
+	cairo_surface_t *m_zoomed;
+	uint64_t m_skipped;
+	PickerTick(ScreenSource *source, ColorNames *color_names):
+		m_screen_reader(screen_reader_new()),
+		m_color_names(color_names),
+		m_zoomed(cairo_image_surface_create(CAIRO_FORMAT_RGB24, ZoomedSize, ZoomedSize)),
+		m_skipped(0)
+	{
+		screen_reader_set_source(m_screen_reader, source);
+		m_sampler = sampler_new(m_screen_reader);
+		sampler_set_oversample(m_sampler, 2);
+		sampler_set_falloff(m_sampler, SamplerFalloff::quadratic);
+	}
+	~PickerTick()
+	{
+		sampler_destroy(m_sampler);
+		screen_reader_destroy(m_screen_reader);
+		cairo_surface_destroy(m_zoomed);
+	}
+	static Rect2<int> getZoomedRect(const Vec2<int> &pointer, const Rect2<int> &screen_rect)
+	{
+		int left = std::min(std::max(pointer.x - ZoomedArea / 2, screen_rect.getLeft()), screen_rect.getRight() - ZoomedArea);
+		int top = std::min(std::max(pointer.y - ZoomedArea / 2, screen_rect.getTop()), screen_rect.getBottom() - ZoomedArea);
+		return Rect2<int>(left, top, left + ZoomedArea, top + ZoomedArea);
+	}
+	void operator()(bool only_if_changed)
+	{
+		GdkScreen *screen;
+		Vec2<int> pointer;
+		Rect2<int> screen_rect, sampler_rect, zoomed_rect, final_rect;
+		screen_reader_get_pointer(m_screen_reader, &screen, pointer, screen_rect);
+		screen_reader_reset_rect(m_screen_reader);
+		sampler_get_screen_rect(m_sampler, pointer, screen_rect, &sampler_rect);
+		screen_reader_add_rect(m_screen_reader, screen, sampler_rect);
+		zoomed_rect = getZoomedRect(pointer, screen_rect);
+		screen_reader_add_rect(m_screen_reader, screen, zoomed_rect);
+		if (only_if_changed){
+			if (screen_reader_update_surface_if_changed(m_screen_reader, &final_rect) == ScreenReaderUpdate::skipped){
+				m_skipped++;
+				return;
+			}
+		}else{
+			screen_reader_update_surface(m_screen_reader, &final_rect);
+		}
+		Vec2<int> offset(sampler_rect.getX() - final_rect.getX(), sampler_rect.getY() - final_rect.getY());
+		Color c;
+		sampler_get_color_sample(m_sampler, pointer, screen_rect, offset, &c);
+		string name = color_names_get(m_color_names, &c, true);
+		char text[8];
+		snprintf(text, sizeof(text), "#%02x%02x%02x", int(c.rgb.red * 255 + 0.5), int(c.rgb.green * 255 + 0.5), int(c.rgb.blue * 255 + 0.5));
+		bench::keep(name);
+		bench::keep(text);
+		cairo_t *cr = cairo_create(m_zoomed);
+		cairo_scale(cr, double(ZoomedSize) / ZoomedArea, double(ZoomedSize) / ZoomedArea);
+		cairo_set_source_surface(cr, screen_reader_get_surface(m_screen_reader), final_rect.getX() - zoomed_rect.getX(), final_rect.getY() - zoomed_rect.getY());
+		cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
+		cairo_paint(cr);
+		cairo_destroy(cr);
+	}
+};
+/** Time each tick separately and report median and 99th percentile latency as properties */
+static void measure_latency(bench::Runner &runner, const string &name, function<void()> tick)
+{
+	typedef chrono::steady_clock Clock;
+	vector<double> latencies(LatencyTicks);
+	for (auto &latency: latencies){
+		auto start = Clock::now();
+		tick();
+		latency = chrono::duration<double, micro>(Clock::now() - start).count();
+	}
+	sort(latencies.begin(), latencies.end());
+	runner.setProperty(name + "_p50_us", to_string(latencies[latencies.size() / 2]));
+	runner.setProperty(name + "_p99_us", to_string(latencies[latencies.size() * 99 / 100]));
+}
+/** Report stage latencies measured by picker timers during latency measurement */
+static void add_stage_properties(bench::Runner &runner, const string &name)
+{
+	for (auto stage: {PickerStage::capture, PickerStage::sample}){
+		PickerStageStatistics statistics = picker_timings_get(stage);
+		if (!statistics.count) continue;
+		runner.setProperty(name + "_" + picker_timings_get_stage_name(stage) + "_p50_us", to_string(statistics.p50));
+		runner.setProperty(name + "_" + picker_timings_get_stage_name(stage) + "_p99_us", to_string(statistics.p99));
+	}
+}
+static void run_case(bench::Runner &runner, const string &name, ScreenSource *source, ColorNames *color_names, bool only_if_changed, function<void()> before_tick)
+{
+	PickerTick tick(source, color_names);
+	auto function = [&](){
+		if (before_tick) before_tick();
+		tick(only_if_changed);
+	};
+	runner.run(name, 1, function);
+	picker_timings_reset();
+	measure_latency(runner, name, function);
+	add_stage_properties(runner, name);
+	runner.setProperty(name + "_skipped", to_string(tick.m_skipped));
+}
+/** Copy RGB values of area read by source, alpha or padding byte is ignored */
+static bool read_display_area(ScreenSource *source, GdkScreen *screen, const Rect2<int> &area, vector<uint32_t> &pixels)
+{
+	cairo_surface_t *surface = source->read(screen, area, DisplayCheckSize);
+	if (!surface) return false;
+	cairo_surface_flush(surface);
+	const unsigned char *data = cairo_image_surface_get_data(surface);
+	int stride = cairo_image_surface_get_stride(surface);
+	pixels.resize(area.getWidth() * area.getHeight());
+	for (int y = 0; y < area.getHeight(); y++){
+		const uint32_t *row = reinterpret_cast<const uint32_t*>(data + y * stride);
+		for (int x = 0; x < area.getWidth(); x++)
+			pixels[y * area.getWidth() + x] = row[x] & 0xffffff;
+	}
+	return true;
+}
+/** Compare MIT-SHM captures with cairo captures of the same screen areas.
+ * Each area is read through MIT-SHM, cairo and MIT-SHM again. Areas where both MIT-SHM reads differ changed during the check and are skipped.
+ * Meant to be run under Xvfb, where the screen does not change.
+ * @return Number of pixels which differ between capture methods.
+ */
+static size_t check_display_capture(bench::Runner &runner)
+{
+	GdkScreen *screen = gdk_screen_get_default();
+	ScreenSource *shm_source = screen_source_new_display(true);
+	ScreenSource *cairo_source = screen_source_new_display(false);
+	Rect2<int> screen_rect = shm_source->getScreenRect(screen);
+	int width = screen_rect.getWidth(), height = screen_rect.getHeight();
+	int size = std::min(DisplayCheckSize, std::min(width, height));
+	const Rect2<int> areas[] = {
+		Rect2<int>(0, 0, size, size),
+		Rect2<int>(width / 2 - 7, height / 2 - 5, width / 2 + 24, height / 2 + 14),
+		Rect2<int>(width - 33, height - 17, width, height),
+	};
+	size_t compared = 0, changed = 0, mismatches = 0;
+	vector<uint32_t> shm_pixels, cairo_pixels, shm_pixels_after;
+	for (auto &area: areas){
+		if (!read_display_area(shm_source, screen, area, shm_pixels) || !read_display_area(cairo_source, screen, area, cairo_pixels) || !read_display_area(shm_source, screen, area, shm_pixels_after))
+			continue;
+		if (shm_pixels != shm_pixels_after){
+			changed++;
+			continue;
+		}
+		for (size_t i = 0; i < shm_pixels.size(); i++){
+			if (shm_pixels[i] != cairo_pixels[i]){
+				if (!mismatches)
+					fprintf(stderr, "MIT-SHM and cairo captures differ at %d, %d: %06x != %06x\n", area.getX() + int(i) % area.getWidth(), area.getY() + int(i) / area.getWidth(), shm_pixels[i], cairo_pixels[i]);
+				mismatches++;
+			}
+		}
+		compared++;
+	}
+	runner.setProperty("display_shm", screen_source_uses_shm(shm_source) ? "true" : "false");
+	runner.setProperty("display_compared_areas", to_string(compared));
+	runner.setProperty("display_changed_areas", to_string(changed));
+	runner.setProperty("display_mismatched_pixels", to_string(mismatches));
+	delete shm_source;
+	delete cairo_source;
+	return mismatches;
+}
+int main(int argc, char **argv)
+{
+	color_init();
+	/* Display capture is checked and measured only when X display is available, for example under xvfb-run */
+	bool display = getenv("DISPLAY") && gdk_init_check(&argc, &argv);
+	bench::Runner runner("picker", argc, argv);
+	const char *dictionary = runner.getArgument(0);
+	if (!dictionary) dictionary = "share/gpick/color_dictionary_0.txt";
+	runner.setProperty("dictionary", dictionary);
+	ColorNames *color_names = color_names_new();
+	color_names_load_from_file(color_names, dictionary);
+	cairo_surface_t *frames[2] = { build_frame(0), build_frame(64) };
+	const char *image = runner.getArgument(1);
+	if (image){
+		string error;
+		ScreenSource *source = screen_source_new_image(image, error);
+		if (!source){
+			fprintf(stderr, "can not load image \"%s\": %s\n", image, error.c_str());
+			return 1;
+		}
+		runner.setProperty("image", image);
+		Rect2<int> image_rect = source->getScreenRect(nullptr);
+		screen_source_set_pointer_path(source, screen_source_build_pointer_path({{image_rect.getLeft(), image_rect.getTop()}, {image_rect.getRight() - 1, image_rect.getBottom() - 1}}, 3));
+		run_case(runner, "image_moving", source, color_names, true, nullptr);
+	}
+	vector<Vec2<int>> path = screen_source_build_pointer_path({{100, 100}, {1800, 200}, {900, 1000}, {100, 100}}, 3);
+	ScreenSource *source = screen_source_new_surface(frames[0]);
+	screen_source_set_pointer_path(source, path);
+	run_case(runner, "tick_moving", source, color_names, true, nullptr);
+	source = screen_source_new_surface(frames[0]);
+	run_case(runner, "tick_still", source, color_names, true, nullptr);
+	source = screen_source_new_surface(frames[0]);
+	run_case(runner, "tick_still_unconditional", source, color_names, false, nullptr);
+	source = screen_source_new_surface(frames[0]);
+	size_t frame = 0;
+	run_case(runner, "tick_still_changing_frame", source, color_names, true, [&](){
+		screen_source_set_surface(source, frames[++frame & 1]);
+	});
+	size_t display_mismatches = 0;
+	if (display){
+		display_mismatches = check_display_capture(runner);
+		run_case(runner, "display_shm", screen_source_new_display(true), color_names, false, nullptr);
+		run_case(runner, "display_cairo", screen_source_new_display(false), color_names, false, nullptr);
+	}
+	cairo_surface_destroy(frames[0]);
+	cairo_surface_destroy(frames[1]);
+	color_names_destroy(color_names);
+	int result = runner.finish();
+	return display_mismatches ? 1 : result;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench/Benchmark.h"
+#include "parser/TextFile.h"
+#include "Color.h"
+#include <string.h>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+using namespace std;
+
+const size_t LineCount = 16384;
+
+struct TextFile: public text_file_parser::TextFile
+{
+	const string &m_data;
+	size_t m_position;
+	size_t m_colors;
+	TextFile(const string &data):
+		m_data(data),
+		m_position(0),
+		m_colors(0)
+	{
+	}
+	virtual ~TextFile()
+	{
+	}
+	virtual void outOfMemory()
+	{
+	}
+	virtual void syntaxError(size_t start_line, size_t start_column, size_t end_line, size_t end_colunn)
+	{
+	}
+	virtual size_t read(char *buffer, size_t length)
+	{
+		size_t bytes = min(length, m_data.size() - m_position);
+		memcpy(buffer, m_data.data() + m_position, bytes);
+		m_position += bytes;
+		return bytes;
+	}
+	virtual void addColor(const Color &color)
+	{
+		m_colors++;
+	}
+};
+static string build_text()
+{
+	stringstream text;
+	uint32_t seed = 5;
+	for (size_t i = 0; i < LineCount; i++){
+		seed = seed * 1664525 + 1013904223;
+		int r = (seed >> 8) & 0xff, g = (seed >> 16) & 0xff, b = (seed >> 24) & 0xff;
+		switch (i % 4){
+			case 0:
+				text << "color" << i << " = #" << hex << setfill('0') << setw(6) << (r << 16 | g << 8 | b) << dec << setfill(' ') << ";\n";
+				break;
+			case 1:
+				text << "rgb(" << r << ", " << g << ", " << b << ") // comment\n";
+				break;
+			case 2:
+				text << "rgba(" << r << ", " << g << ", " << b << ", 0.5)\n";
+				break;
+			case 3:
+				text << r / 255.0 << " " << g / 255.0 << " " << b / 255.0 << "\n";
+				break;
+		}
+	}
+	return text.str();
+}
+int main(int argc, char **argv)
+{
+	bench::Runner runner("text_file", argc, argv);
+	string text = build_text();
+	runner.setProperty("bytes", to_string(text.size()));
+	text_file_parser::Configuration configuration;
+	runner.run("parse", LineCount, [&](){
+		TextFile text_file(text);
+		text_file.parse(configuration);
+		bench::keep(text_file.m_colors);
+	});
+	return runner.finish();
+}
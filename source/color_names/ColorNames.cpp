@@ -17,57 +17,140 @@
  */
 
 #include "ColorNames.h"
+#include "Dictionary.h"
 #include "../Color.h"
+#include "../MathUtil.h"
 #include "../Paths.h"
 #include <string.h>
 #include <sstream>
 #include <fstream>
 #include <functional>
-#include <list>
 #include <algorithm>
+#include <limits>
+#include <math.h>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
 using namespace std;
 
-struct ColorNameEntry
+const uint32_t IndexLeafSize = 8;
+const size_t NameCacheSize = 4096;
+/** Name cache entries hold RGB value in bits 0-23, dictionary index in bits 24-31 and entry index plus one in bits 32-63, zero for empty entries */
+const size_t NameCacheMaxDictionaries = 256;
+/** \struct ColorDictionarySet
+ * \brief Immutable list of dictionaries used for lookups, with its own name cache.
+ * Sets are replaced as a whole when dictionaries change, so lookups running in other threads keep using a consistent set.
+ */
+struct ColorDictionarySet
 {
-	std::string name;
+	std::vector<std::shared_ptr<ColorDictionary>> dictionaries;
+	mutable std::vector<std::atomic<uint64_t>> cache; /**< Remembered color_names_get results, read and written without locking */
+	ColorDictionarySet();
 };
-struct ColorEntry
+ColorDictionarySet::ColorDictionarySet():
+	cache(NameCacheSize)
 {
-	Color color;
-	Color original_color;
-	ColorNameEntry* name;
-};
-const int SpaceDivisions = 8;
+}
 struct ColorNames
 {
-	std::list<ColorNameEntry*> names;
-	std::vector<ColorEntry*> colors[SpaceDivisions][SpaceDivisions][SpaceDivisions];
+	std::atomic<const ColorDictionarySet*> current; /**< Set used by lookups, published once per dictionary change and read without locking */
+	std::atomic<uint32_t> readers; /**< Number of lookups in progress */
+	std::shared_ptr<const ColorDictionarySet> dictionaries; /**< Owner of current set */
+	std::shared_ptr<const ColorDictionarySet> previous_dictionaries; /**< Keeps names returned by color_names_find_nearest valid for one more swap */
+	std::vector<std::shared_ptr<const ColorDictionarySet>> retired; /**< Older sets, kept until a swap finds no lookups in progress */
 	void (*color_space_convert)(const Color* a, Color* b);
 	float (*color_space_distance)(const Color* a, const Color* b);
+	std::mutex data_mutex; /**< Guards set ownership, taken only when dictionaries change */
+	std::atomic<uint64_t> cache_hits, cache_misses;
+	std::mutex loader_mutex; /**< Guards loader state below and dictionary changes made on behalf of a load request */
+	std::thread loader;
+	bool loader_running; /**< Loader thread is running and will check for pending requests before exiting */
+	bool load_pending;
+	std::vector<std::string> pending_filenames;
+	std::atomic<uint32_t> load_request; /**< Incremented by every load request and synchronous change, loader drops results of older requests */
+	std::vector<std::promise<void>> load_waiting; /**< Promises of color_names_load_async calls, fulfilled when their or newer dictionaries are in use */
 };
+/** \class ColorNamesReader
+ * \brief Current dictionary set used by a lookup. The set is not released while the reader exists.
+ */
+class ColorNamesReader
+{
+public:
+	ColorNamesReader(ColorNames *color_names):
+		m_color_names(color_names)
+	{
+		// counter is incremented before the set is loaded, so a swap which sees no readers knows that later lookups use the new set
+		m_color_names->readers++;
+		m_dictionaries = m_color_names->current;
+	}
+	~ColorNamesReader()
+	{
+		m_color_names->readers--;
+	}
+	const ColorDictionarySet &operator*() const
+	{
+		return *m_dictionaries;
+	}
+private:
+	ColorNames *m_color_names;
+	const ColorDictionarySet *m_dictionaries;
+};
+static void color_names_set_dictionaries(ColorNames *color_names, const shared_ptr<const ColorDictionarySet> &dictionaries)
+{
+	lock_guard<mutex> lock(color_names->data_mutex);
+	if (color_names->previous_dictionaries)
+		color_names->retired.push_back(color_names->previous_dictionaries);
+	color_names->previous_dictionaries = color_names->dictionaries;
+	color_names->dictionaries = dictionaries;
+	color_names->current = dictionaries.get();
+	if (color_names->readers == 0)
+		color_names->retired.clear();
+}
+static shared_ptr<const ColorDictionarySet> color_names_get_dictionaries(ColorNames *color_names)
+{
+	lock_guard<mutex> lock(color_names->data_mutex);
+	return color_names->dictionaries;
+}
+/**
+ * Drop pending and in-flight background loads. Must be called with loader_mutex held before dictionaries are changed from the calling thread, otherwise loader result would overwrite the change.
+ */
+static void color_names_cancel_loading(ColorNames *color_names)
+{
+	color_names->load_request++;
+	color_names->load_pending = false;
+	color_names->pending_filenames.clear();
+}
+/**
+ * Notify color_names_load_async callers that dictionaries were replaced. Must be called with loader_mutex held.
+ */
+static void color_names_notify_loaded(ColorNames *color_names)
+{
+	for (auto &done: color_names->load_waiting)
+		done.set_value();
+	color_names->load_waiting.clear();
+}
 ColorNames* color_names_new()
 {
 	ColorNames* color_names = new ColorNames;
-	color_names->color_space_convert = color_rgb_to_lab_d50;
+	color_names->color_space_convert = color_rgb_to_lab_d50_fast;
 	color_names->color_space_distance = color_distance_lch;
+	color_names->current = nullptr;
+	color_names->readers = 0;
+	color_names->cache_hits = 0;
+	color_names->cache_misses = 0;
+	color_names->loader_running = false;
+	color_names->load_pending = false;
+	color_names->load_request = 0;
+	color_names_set_dictionaries(color_names, make_shared<ColorDictionarySet>());
 	return color_names;
 }
 void color_names_clear(ColorNames *color_names)
 {
-	for (auto i = color_names->names.begin(); i != color_names->names.end(); i++){
-		delete *i;
-	}
-	color_names->names.clear();
-	for (int x = 0; x < SpaceDivisions; x++){
-		for (int y = 0; y < SpaceDivisions; y++){
-			for (int z = 0; z < SpaceDivisions; z++){
-				for (auto i = color_names->colors[x][y][z].begin(); i != color_names->colors[x][y][z].end(); ++i){
-					delete *i;
-				}
-				color_names->colors[x][y][z].clear();
-			}
-		}
-	}
+	lock_guard<mutex> lock(color_names->loader_mutex);
+	color_names_cancel_loading(color_names);
+	color_names_set_dictionaries(color_names, make_shared<ColorDictionarySet>());
+	color_names_notify_loaded(color_names);
 }
 static void color_names_strip_spaces(string& string_x, const string& strip_chars)
 {
@@ -81,129 +164,295 @@ static void color_names_strip_spaces(string& string_x, const string& strip_chars
 	}
 	string_x = string_x.substr(start_index, (end_index - start_index) + 1);
 }
-void color_names_normalize(const Color &color, Color &out)
+static float chroma(const Color &color)
 {
-	out.xyz.x = color.xyz.x / 100.0;
-	out.xyz.y = (color.xyz.y + 86.1825) / (86.1825 + 98.2346);
-	out.xyz.z = (color.xyz.z + 107.86) / (107.86 + 94.478);
+	return sqrt(color.lab.a * color.lab.a + color.lab.b * color.lab.b);
 }
-void color_names_get_color_xyz(ColorNames* color_names, Color* c, int* x1, int* y1, int* z1, int* x2, int* y2, int* z2)
+static uint32_t color_names_build_index(ColorDictionary &dictionary, uint32_t begin, uint32_t end)
 {
-	*x1 = clamp_int(int(c->xyz.x / 100 * SpaceDivisions - 0.5), 0, SpaceDivisions - 1);
-	*y1 = clamp_int(int((c->xyz.y + 100) / 200 * SpaceDivisions - 0.5), 0, SpaceDivisions - 1);
-	*z1 = clamp_int(int((c->xyz.z + 100) / 200 * SpaceDivisions - 0.5), 0, SpaceDivisions - 1);
-	*x2 = clamp_int(int(c->xyz.x / 100 * SpaceDivisions + 0.5), 0, SpaceDivisions - 1);
-	*y2 = clamp_int(int((c->xyz.y + 100) / 200 * SpaceDivisions + 0.5), 0, SpaceDivisions - 1);
-	*z2 = clamp_int(int((c->xyz.z + 100) / 200 * SpaceDivisions + 0.5), 0, SpaceDivisions - 1);
+	uint32_t node_index = dictionary.index_storage.size();
+	dictionary.index_storage.push_back(ColorIndexNode());
+	ColorIndexNode node;
+	node.begin = begin;
+	node.end = end;
+	node.left = node.right = 0;
+	for (int i = 0; i < 3; i++){
+		node.min[i] = numeric_limits<float>::max();
+		node.max[i] = -numeric_limits<float>::max();
+	}
+	node.chroma_min = numeric_limits<float>::max();
+	node.chroma_max = 0;
+	for (uint32_t i = begin; i < end; i++){
+		const Color &color = dictionary.entry_storage[i].color;
+		for (int j = 0; j < 3; j++){
+			node.min[j] = std::min(node.min[j], color.ma[j]);
+			node.max[j] = std::max(node.max[j], color.ma[j]);
+		}
+		float c = chroma(color);
+		node.chroma_min = std::min(node.chroma_min, c);
+		node.chroma_max = std::max(node.chroma_max, c);
+	}
+	if (end - begin > IndexLeafSize){
+		int axis = 0;
+		for (int i = 1; i < 3; i++){
+			if (node.max[i] - node.min[i] > node.max[axis] - node.min[axis]) axis = i;
+		}
+		uint32_t middle = begin + (end - begin) / 2;
+		auto entries = dictionary.entry_storage.begin();
+		nth_element(entries + begin, entries + middle, entries + end, [axis](const ColorNamesEntry &a, const ColorNamesEntry &b){
+			return a.color.ma[axis] < b.color.ma[axis];
+		});
+		node.left = color_names_build_index(dictionary, begin, middle);
+		node.right = color_names_build_index(dictionary, middle, end);
+	}
+	dictionary.index_storage[node_index] = node;
+	return node_index;
+}
+static void color_names_parse(const ColorNames *color_names, const string &data, ColorDictionary &dictionary)
+{
+	istringstream file(data);
+	string line;
+	stringstream rline (ios::in | ios::out);
+	Color color;
+	string name;
+	while (!(file.eof())){
+		getline(file, line);
+		if (line.empty()) continue;
+		if (line.at(0) == '!') continue;
+		rline.clear();
+		rline.str(line);
+		rline >> color.rgb.red >> color.rgb.green >> color.rgb.blue;
+		getline(rline, name);
+		const string strip_chars = " \t,.\n\r";
+		color_names_strip_spaces(name, strip_chars);
+		string::iterator i(name.begin());
+		if (i != name.end()){
+			name[0] = toupper((unsigned char)name[0]);
+			while(++i != name.end()){
+				*i = tolower((unsigned char)*i);
+			}
+			color_multiply(&color, 1 / 255.0);
+			ColorNamesEntry entry;
+			entry.name = dictionary.string_storage.size();
+			entry.reserved = 0;
+			dictionary.string_storage.insert(dictionary.string_storage.end(), name.begin(), name.end());
+			dictionary.string_storage.push_back(0);
+			color_names->color_space_convert(&color, &entry.color);
+			color_copy(&color, &entry.original_color);
+			dictionary.entry_storage.push_back(entry);
+		}
+	}
+	if (dictionary.string_storage.empty())
+		dictionary.string_storage.push_back(0);
+	if (!dictionary.entry_storage.empty())
+		color_names_build_index(dictionary, 0, dictionary.entry_storage.size());
+	dictionary.useStorage();
 }
-static vector<ColorEntry*>* color_names_get_color_list(ColorNames* color_names, Color* c)
+/**
+ * Load dictionary from binary cache or text file, without adding it to the dictionary set.
+ * @return Nullptr on failure.
+ */
+static shared_ptr<ColorDictionary> color_names_load_dictionary(const ColorNames *color_names, const char *filename)
 {
-	int x,y,z;
-	x = clamp_int(int(c->xyz.x / 100 * SpaceDivisions), 0, SpaceDivisions - 1);
-	y = clamp_int(int((c->xyz.y + 100) / 200 * SpaceDivisions), 0, SpaceDivisions - 1);
-	z = clamp_int(int((c->xyz.z + 100) / 200 * SpaceDivisions), 0, SpaceDivisions - 1);
-	return &color_names->colors[x][y][z];
+	FileCacheSource source;
+	if (!file_cache_source_stat(filename, source)) return nullptr;
+	auto cache_filenames = color_dictionary_cache_filenames(filename);
+	auto dictionary = make_shared<ColorDictionary>();
+	for (auto &cache_filename: cache_filenames){
+		if (color_dictionary_cache_load(*dictionary, cache_filename.c_str(), filename, source))
+			return dictionary;
+	}
+	ifstream file(filename, ifstream::in | ifstream::binary);
+	if (!file.is_open()) return nullptr;
+	stringstream content;
+	content << file.rdbuf();
+	file.close();
+	string data = content.str();
+	source.hash = file_cache_hash(data.data(), data.size());
+	color_names_parse(color_names, data, *dictionary);
+	for (auto &cache_filename: cache_filenames){
+		if (color_dictionary_cache_save(*dictionary, cache_filename.c_str(), source))
+			break;
+	}
+	return dictionary;
 }
 int color_names_load_from_file(ColorNames* color_names, const char* filename)
 {
-	float a = 0, b = 0, c = 0;
-	ifstream file(filename, ifstream::in);
-	if (file.is_open()){
-		string line;
-		stringstream rline (ios::in | ios::out);
-		Color color;
-		string name;
-		while (!(file.eof())){
-			getline(file, line);
-			if (line.empty()) continue;
-			if (line.at(0) == '!') continue;
-			rline.clear();
-			rline.str(line);
-			rline >> color.rgb.red >> color.rgb.green >> color.rgb.blue;
-			getline(rline, name);
-			const string strip_chars = " \t,.\n\r";
-			color_names_strip_spaces(name, strip_chars);
-			string::iterator i(name.begin());
-			if (i != name.end()){
-				name[0] = toupper((unsigned char)name[0]);
-				while(++i != name.end()){
-					*i = tolower((unsigned char)*i);
-				}
-				color_multiply(&color, 1 / 255.0);
-				ColorNameEntry* name_entry = new ColorNameEntry;
-				name_entry->name = name;
-				color_names->names.push_back(name_entry);
-				ColorEntry* color_entry = new ColorEntry;
-				color_entry->name = name_entry;
-				color_names->color_space_convert(&color, &color_entry->color);
-				color_copy(&color, &color_entry->original_color);
-				color_names_get_color_list(color_names, &color_entry->color)->push_back(color_entry);
-			}
-		}
-		file.close();
-		return 0;
+	lock_guard<mutex> lock(color_names->loader_mutex);
+	color_names_cancel_loading(color_names);
+	auto dictionary = color_names_load_dictionary(color_names, filename);
+	if (dictionary){
+		auto dictionaries = make_shared<ColorDictionarySet>();
+		dictionaries->dictionaries = color_names_get_dictionaries(color_names)->dictionaries;
+		dictionaries->dictionaries.push_back(dictionary);
+		color_names_set_dictionaries(color_names, dictionaries);
 	}
-	return -1;
+	color_names_notify_loaded(color_names);
+	return dictionary ? 0 : -1;
 }
 void color_names_destroy(ColorNames* color_names)
 {
-	color_names_clear(color_names);
+	{
+		lock_guard<mutex> lock(color_names->loader_mutex);
+		color_names_cancel_loading(color_names);
+		color_names_notify_loaded(color_names);
+	}
+	// loader exits after the dictionary it is currently reading
+	if (color_names->loader.joinable())
+		color_names->loader.join();
 	delete color_names;
 }
-static void color_names_iterate(ColorNames* color_names, const Color* color, function<bool(ColorEntry*, float)> on_color, function<bool()> on_expansion)
-{
-	Color c1;
-	color_names->color_space_convert(color, &c1);
-	int x1, y1, z1, x2, y2, z2;
-	color_names_get_color_xyz(color_names, &c1, &x1, &y1, &z1, &x2, &y2, &z2);
-	char skip_mask[SpaceDivisions][SpaceDivisions][SpaceDivisions];
-	memset(&skip_mask, 0, sizeof(skip_mask));
-	/* Search expansion should be from 0 to SpaceDivisions, but this would only increase search time and return
-	 * wrong color names when no closely matching color is found. Search expansion is only useful
-	 * when color name database is very small (16 colors)
-	 */
-	for (int expansion = 0; expansion < SpaceDivisions - 1; ++expansion){
-		int x_start = std::max(x1 - expansion, 0), x_end = std::min(x2 + expansion, SpaceDivisions - 1);
-		int y_start = std::max(y1 - expansion, 0), y_end = std::min(y2 + expansion, SpaceDivisions - 1);
-		int z_start = std::max(z1 - expansion, 0), z_end = std::min(z2 + expansion, SpaceDivisions - 1);
-		for (int x_i = x_start; x_i <= x_end; ++x_i){
-			for (int y_i = y_start; y_i <= y_end; ++y_i){
-				for (int z_i = z_start; z_i <= z_end; ++z_i){
-					if (skip_mask[x_i][y_i][z_i]) continue; // skip checked items
-					skip_mask[x_i][y_i][z_i] = 1;
-					for (auto i = color_names->colors[x_i][y_i][z_i].begin(); i != color_names->colors[x_i][y_i][z_i].end(); ++i){
-						float delta = color_names->color_space_distance(&(*i)->color, &c1);
-						if (!on_color(*i, delta)) return;
+/**
+ * Lower bound of color_distance_lch(entry, query) for any entry in the node.
+ * Each term of the distance is bounded separately using Lab and chroma ranges of node entries.
+ */
+static float color_names_distance_lch_bound(const ColorIndexNode &node, const Color &query, float query_chroma)
+{
+	float delta[3];
+	for (int i = 0; i < 3; i++){
+		delta[i] = std::max(std::max(node.min[i] - query.ma[i], query.ma[i] - node.max[i]), 0.0f);
+	}
+	float chroma_delta = std::max(std::max(node.chroma_min - query_chroma, query_chroma - node.chroma_max), 0.0f);
+	float c = chroma_delta / (1 + 0.045f * node.chroma_max);
+	float h = delta[1] * delta[1] + delta[2] * delta[2] - (query_chroma - node.chroma_min);
+	h = std::max(h, 0.0f) / (1 + 0.015f * node.chroma_max);
+	return sqrt(delta[0] * delta[0] + c * c + h * h);
+}
+struct ColorNamesMatch
+{
+	float distance;
+	const ColorDictionary *dictionary;
+	const ColorNamesEntry *entry;
+	const char *getName() const
+	{
+		return dictionary->strings + entry->name;
+	}
+};
+static bool color_names_match_less(const ColorNamesMatch &a, const ColorNamesMatch &b)
+{
+	return a.distance < b.distance;
+}
+/**
+ * Find up to count entries closest to color, results are sorted by distance.
+ */
+static void color_names_search(const ColorNames *color_names, const ColorDictionarySet &dictionaries, const Color &color, size_t count, vector<ColorNamesMatch> &result)
+{
+	result.clear();
+	if (count == 0) return;
+	Color query;
+	color_names->color_space_convert(&color, &query);
+	float query_chroma = chroma(query);
+	// Lower bound is only known for color_distance_lch, other distance functions search all entries
+	bool use_bound = color_names->color_space_distance == color_distance_lch;
+	for (auto &dictionary: dictionaries.dictionaries){
+		if (dictionary->index_count == 0) continue;
+		auto bound = [&](uint32_t node_index) -> float {
+			if (!use_bound) return 0;
+			// Slightly reduce bound to account for rounding differences between bound and distance calculations
+			return color_names_distance_lch_bound(dictionary->index[node_index], query, query_chroma) * 0.9999f;
+		};
+		// result is kept as a max-heap of the best matches found so far
+		function<void(uint32_t, float)> visit = [&](uint32_t node_index, float node_bound){
+			if (result.size() == count && node_bound > result.front().distance) return;
+			const ColorIndexNode &node = dictionary->index[node_index];
+			if (node.left == 0){
+				for (uint32_t i = node.begin; i < node.end; i++){
+					const ColorNamesEntry *entry = &dictionary->entries[i];
+					float delta = color_names->color_space_distance(&entry->color, &query);
+					ColorNamesMatch match = {delta, dictionary.get(), entry};
+					if (result.size() < count){
+						result.push_back(match);
+						push_heap(result.begin(), result.end(), color_names_match_less);
+					}else if (delta < result.front().distance){
+						pop_heap(result.begin(), result.end(), color_names_match_less);
+						result.back() = match;
+						push_heap(result.begin(), result.end(), color_names_match_less);
 					}
 				}
+				return;
 			}
-		}
-		if (on_expansion && !on_expansion()) return;
+			float left_bound = bound(node.left), right_bound = bound(node.right);
+			if (left_bound <= right_bound){
+				visit(node.left, left_bound);
+				visit(node.right, right_bound);
+			}else{
+				visit(node.right, right_bound);
+				visit(node.left, left_bound);
+			}
+		};
+		visit(0, 0);
 	}
+	sort_heap(result.begin(), result.end(), color_names_match_less);
 }
-string color_names_get(ColorNames* color_names, const Color* color, bool imprecision_postfix)
+/**
+ * Get the name of the closest dictionary entry, using name cache.
+ * Colors are rounded to 8 bits per channel, so results do not depend on the state of the cache.
+ * Returned name belongs to one of the dictionaries in the set.
+ * @return False if no dictionaries are loaded.
+ */
+static bool color_names_get_cached(ColorNames *color_names, const ColorDictionarySet &dictionaries, const Color &color, const char *&name, float &distance)
 {
-	float result_delta = 1e5;
-	ColorEntry* found_color_entry = nullptr;
-	color_names_iterate(color_names, color, [&](ColorEntry *color_entry, float delta){
-		if (delta < result_delta){
-			result_delta = delta;
-			found_color_entry = color_entry;
-		}
+	Color quantized;
+	uint32_t key = 0;
+	for (int i = 0; i < 3; i++){
+		int value = clamp_int(int(color.ma[i] * 255 + 0.5f), 0, 255);
+		quantized.ma[i] = value / 255.0f;
+		key |= value << (i * 8);
+	}
+	quantized.ma[3] = 0;
+	atomic<uint64_t> &entry = dictionaries.cache[((key * 2654435761u) >> 20) % NameCacheSize];
+	// entry only refers to immutable set data, so it does not order any other memory access
+	uint64_t value = entry.load(memory_order_relaxed);
+	if (value != 0 && (value & 0xffffff) == key){
+		const ColorDictionary &dictionary = *dictionaries.dictionaries[(value >> 24) & 0xff];
+		const ColorNamesEntry &dictionary_entry = dictionary.entries[(value >> 32) - 1];
+		Color query;
+		color_names->color_space_convert(&quantized, &query);
+		name = dictionary.strings + dictionary_entry.name;
+		distance = color_names->color_space_distance(&dictionary_entry.color, &query);
+		color_names->cache_hits++;
 		return true;
-	}, [&](){
-		return found_color_entry == nullptr; // stop further expansion if we have found a match
-	});
-	if (found_color_entry){
+	}
+	color_names->cache_misses++;
+	vector<ColorNamesMatch> result;
+	color_names_search(color_names, dictionaries, quantized, 1, result);
+	if (result.empty()) return false;
+	name = result[0].getName();
+	distance = result[0].distance;
+	for (size_t i = 0; i < dictionaries.dictionaries.size() && i < NameCacheMaxDictionaries; i++){
+		if (dictionaries.dictionaries[i].get() != result[0].dictionary) continue;
+		uint64_t index = result[0].entry - result[0].dictionary->entries;
+		entry.store(key | (uint64_t(i) << 24) | ((index + 1) << 32), memory_order_relaxed);
+		break;
+	}
+	return true;
+}
+string color_names_get(ColorNames* color_names, const Color* color, bool imprecision_postfix)
+{
+	const char *name;
+	float distance;
+	ColorNamesReader dictionaries(color_names);
+	if (color_names_get_cached(color_names, *dictionaries, *color, name, distance)){
 		stringstream s;
-		s << found_color_entry->name->name;
-		if (imprecision_postfix) if (result_delta > 0.1) s << " ~";
+		s << name;
+		if (imprecision_postfix) if (distance > 0.1) s << " ~";
 		return s.str();
 	}
 	return string("");
 }
-void color_names_load(ColorNames *color_names, dynvSystem *params)
+ColorNamesCacheStatistics color_names_get_cache_statistics(ColorNames *color_names)
 {
+	ColorNamesCacheStatistics statistics;
+	statistics.hits = color_names->cache_hits;
+	statistics.misses = color_names->cache_misses;
+	return statistics;
+}
+/**
+ * Get paths of all enabled dictionaries.
+ */
+static vector<string> color_names_get_filenames(dynvSystem *params)
+{
+	vector<string> filenames;
 	uint32_t dictionary_count = 0;
 	struct dynvSystem** dictionaries = dynv_get_dynv_array_wd(params, "color_dictionaries.items", nullptr, 0, &dictionary_count);
 	if (dictionaries){
@@ -215,34 +464,93 @@ void color_names_load(ColorNames *color_names, dynvSystem *params)
 				if (built_in){
 					if (path == "built_in_0"){
 						gchar *tmp;
-						color_names_load_from_file(color_names, tmp = build_filename("color_dictionary_0.txt"));
+						filenames.push_back(tmp = build_filename("color_dictionary_0.txt"));
 						g_free(tmp);
 					}
 				}else{
-					color_names_load_from_file(color_names, path.c_str());
+					filenames.push_back(path);
 				}
 			}
 			dynv_system_release(dictionaries[i]);
 		}
 		if (dictionaries) delete [] dictionaries;
 	}
+	return filenames;
+}
+void color_names_load(ColorNames *color_names, dynvSystem *params)
+{
+	for (auto &filename: color_names_get_filenames(params)){
+		color_names_load_from_file(color_names, filename.c_str());
+	}
+}
+/**
+ * Background loader thread. Loads pending requests until there are none left. A request is dropped between dictionary files when a newer request or a synchronous change arrives.
+ */
+static void color_names_loader_run(ColorNames *color_names)
+{
+	for (;;){
+		vector<string> filenames;
+		uint32_t request;
+		{
+			lock_guard<mutex> lock(color_names->loader_mutex);
+			if (!color_names->load_pending){
+				color_names->loader_running = false;
+				return;
+			}
+			filenames.swap(color_names->pending_filenames);
+			color_names->load_pending = false;
+			request = color_names->load_request;
+		}
+		auto dictionaries = make_shared<ColorDictionarySet>();
+		bool cancelled = false;
+		for (auto &filename: filenames){
+			if (color_names->load_request != request){
+				cancelled = true;
+				break;
+			}
+			auto dictionary = color_names_load_dictionary(color_names, filename.c_str());
+			if (dictionary)
+				dictionaries->dictionaries.push_back(dictionary);
+		}
+		if (cancelled) continue;
+		lock_guard<mutex> lock(color_names->loader_mutex);
+		if (color_names->load_request == request){
+			color_names_set_dictionaries(color_names, dictionaries);
+			color_names_notify_loaded(color_names);
+		}
+	}
+}
+/**
+ * Load enabled dictionaries in a background thread. Does not wait for earlier loads: an in-flight load is cancelled and replaced by this one.
+ * Current dictionaries stay in use until loading finishes, then they are replaced by loaded dictionaries in one step.
+ * Before the first load finishes, color_names_get returns an empty name and color_names_find_nearest returns no colors.
+ * @return Future which becomes ready when new dictionaries are in use.
+ */
+shared_future<void> color_names_load_async(ColorNames *color_names, dynvSystem *params)
+{
+	auto filenames = color_names_get_filenames(params);
+	lock_guard<mutex> lock(color_names->loader_mutex);
+	color_names->load_request++;
+	color_names->pending_filenames = move(filenames);
+	color_names->load_pending = true;
+	color_names->load_waiting.emplace_back();
+	shared_future<void> loaded = color_names->load_waiting.back().get_future().share();
+	if (!color_names->loader_running){
+		// previous loader thread has already released the mutex for the last time, so joining it does not wait for loading
+		if (color_names->loader.joinable())
+			color_names->loader.join();
+		color_names->loader_running = true;
+		color_names->loader = thread(color_names_loader_run, color_names);
+	}
+	return loaded;
 }
 void color_names_find_nearest(ColorNames *color_names, const Color &color, size_t count, std::vector<std::pair<const char*, Color>> &colors)
 {
-	multimap<float, ColorEntry*> found_colors;
-	color_names_iterate(color_names, &color, [&](ColorEntry *color_entry, float delta){
-		found_colors.insert(pair<float, ColorEntry*>(delta, color_entry));
-		return true;
-	}, [&](){
-		return found_colors.size() < count;
-	});
-	if (found_colors.size() >= count)
-		colors.resize(count);
-	else
-		colors.resize(found_colors.size());
-	size_t index = 0;
-	for (auto &item: found_colors){
-		if (index >= count) break;
-		colors[index++] = pair<const char*, Color>(item.second->name->name.c_str(), item.second->original_color);
+	vector<ColorNamesMatch> result;
+	ColorNamesReader dictionaries(color_names);
+	color_names_search(color_names, *dictionaries, color, count, result);
+	colors.resize(result.size());
+	for (size_t i = 0; i < result.size(); i++){
+		colors[i] = pair<const char*, Color>(result[i].getName(), result[i].entry->original_color);
 	}
 }
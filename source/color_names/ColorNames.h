@@ -22,12 +22,29 @@
 #include "../DynvHelpers.h"
 #include <string>
 #include <vector>
+#include <future>
+#include <stdint.h>
 struct ColorNames;
+struct ColorNamesCacheStatistics
+{
+	uint64_t hits;
+	uint64_t misses;
+};
 ColorNames *color_names_new();
 void color_names_clear(ColorNames *color_names);
 void color_names_load(ColorNames *color_names, dynvSystem *params);
+std::shared_future<void> color_names_load_async(ColorNames *color_names, dynvSystem *params);
 int color_names_load_from_file(ColorNames *color_names, const char *filename);
 void color_names_destroy(ColorNames *color_names);
 std::string color_names_get(ColorNames *color_names, const Color *color, bool imprecision_postfix);
+ColorNamesCacheStatistics color_names_get_cache_statistics(ColorNames *color_names);
+/**
+ * Find dictionary entries nearest to a color.
+ * Returned name pointers reference dictionary storage. They stay valid until dictionaries are replaced twice (by loading or clearing), so copy names that are kept longer than the current operation.
+ * @param[in] color_names Color names.
+ * @param[in] color Color in RGB color space.
+ * @param[in] count Maximum number of entries to return.
+ * @param[out] colors Entry names and RGB colors, nearest first.
+ */
 void color_names_find_nearest(ColorNames *color_names, const Color &color, size_t count, std::vector<std::pair<const char*, Color>> &colors);
 #endif /* GPICK_COLOR_NAMES_COLOR_NAMES_H_ */
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_COLOR_NAMES_DICTIONARY_H_
+#define GPICK_COLOR_NAMES_DICTIONARY_H_
+#include "../Color.h"
+#include "../FileCache.h"
+#include <boost/interprocess/mapped_region.hpp>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/** \file source/color_names/Dictionary.h
+ * \brief Color dictionary storage shared by text loader and binary cache.
+ *
+ * All structures are plain data and are stored in the binary cache as is, so a mapped cache file can be used
+ * without any per-entry processing.
+ */
+
+/** \struct ColorNamesEntry
+ * \brief Single color dictionary entry.
+ */
+struct ColorNamesEntry
+{
+	Color color; /**< Color in dictionary color space */
+	Color original_color; /**< Color in RGB color space */
+	uint32_t name; /**< Offset of null terminated name in dictionary string table */
+	uint32_t reserved;
+};
+
+/** \struct ColorIndexNode
+ * \brief K-d tree node covering a range of dictionary entries.
+ * Bounds are kept for Lab components and chroma of all entries in the range, they are used to calculate lower bound
+ * of distance from a query color to any entry in the node. Node 0 is the root node.
+ */
+struct ColorIndexNode
+{
+	uint32_t begin, end; /**< Range of entries */
+	uint32_t left, right; /**< Child node indices, zero for leaf nodes */
+	float min[3], max[3]; /**< Lab bounds */
+	float chroma_min, chroma_max; /**< Chroma bounds */
+};
+
+/** \struct ColorDictionary
+ * \brief Entries, string table and k-d tree index of a single dictionary file.
+ * Pointers either reference owned storage vectors (text loader) or mapped cache file.
+ */
+struct ColorDictionary
+{
+	const ColorNamesEntry *entries;
+	uint32_t entry_count;
+	const ColorIndexNode *index;
+	uint32_t index_count;
+	const char *strings;
+	uint32_t strings_size;
+	std::vector<ColorNamesEntry> entry_storage;
+	std::vector<ColorIndexNode> index_storage;
+	std::vector<char> string_storage;
+	boost::interprocess::mapped_region region;
+	ColorDictionary();
+	/**
+	 * Point data pointers to owned storage vectors.
+	 */
+	void useStorage();
+};
+
+/**
+ * Get binary cache file names of a dictionary text file, in order of preference.
+ * First cache file is located next to the text file, second one in user configuration directory.
+ */
+std::vector<std::string> color_dictionary_cache_filenames(const char *filename);
+
+/**
+ * Map binary cache file and check that it was built from the same dictionary text file.
+ * When size and modification time of text file do not match, cache is still accepted if hash of the text file contents is the same.
+ * @param[out] dictionary Dictionary to map cache into.
+ * @param[in] cache_filename Binary cache file name.
+ * @param[in] filename Dictionary text file name.
+ * @param[in] source Current source information of dictionary text file.
+ * @return True if cache is valid and was mapped.
+ */
+bool color_dictionary_cache_load(ColorDictionary &dictionary, const char *cache_filename, const char *filename, const FileCacheSource &source);
+
+/**
+ * Write dictionary into binary cache file.
+ * @param[in] dictionary Dictionary.
+ * @param[in] cache_filename Binary cache file name.
+ * @param[in] source Source information of dictionary text file, including hash.
+ * @return True on success.
+ */
+bool color_dictionary_cache_save(const ColorDictionary &dictionary, const char *cache_filename, const FileCacheSource &source);
+
+#endif /* GPICK_COLOR_NAMES_DICTIONARY_H_ */
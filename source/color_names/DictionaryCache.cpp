@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Dictionary.h"
+#include "../Paths.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <glib.h>
+#include <string.h>
+using namespace std;
+namespace bip = boost::interprocess;
+
+/** Cache format version. Must be increased when file layout, source validation or color space conversion of entries changes. */
+const uint32_t CacheVersion = 2;
+const char CacheMagic[8] = {'G', 'P', 'C', 'D', 'I', 'C', 'T', 0};
+
+struct CacheHeader
+{
+	FileCacheHeader file;
+	uint32_t entry_count;
+	uint32_t index_count;
+	uint32_t strings_size;
+	uint32_t entries_offset;
+	uint32_t index_offset;
+	uint32_t strings_offset;
+};
+
+ColorDictionary::ColorDictionary():
+	entries(nullptr),
+	entry_count(0),
+	index(nullptr),
+	index_count(0),
+	strings(nullptr),
+	strings_size(0)
+{
+}
+void ColorDictionary::useStorage()
+{
+	entries = entry_storage.data();
+	entry_count = entry_storage.size();
+	index = index_storage.data();
+	index_count = index_storage.size();
+	strings = string_storage.data();
+	strings_size = string_storage.size();
+}
+vector<string> color_dictionary_cache_filenames(const char *filename)
+{
+	vector<string> result;
+	result.push_back(string(filename) + ".cache");
+	string name = "color_dictionary_" + file_cache_name(filename) + ".cache";
+	gchar *config_path = build_config_path(name.c_str());
+	result.push_back(config_path);
+	g_free(config_path);
+	return result;
+}
+template<typename T>
+static bool get_section(const bip::mapped_region &region, uint32_t offset, uint32_t count, const T *&result)
+{
+	if (offset % alignof(T) != 0) return false;
+	if (offset > region.get_size() || (region.get_size() - offset) / sizeof(T) < count) return false;
+	result = reinterpret_cast<const T*>(static_cast<const char*>(region.get_address()) + offset);
+	return true;
+}
+static bool validate(const ColorDictionary &dictionary)
+{
+	if (dictionary.strings_size == 0 || dictionary.strings[dictionary.strings_size - 1] != 0) return false;
+	for (uint32_t i = 0; i < dictionary.entry_count; i++){
+		if (dictionary.entries[i].name >= dictionary.strings_size) return false;
+	}
+	if (dictionary.entry_count > 0 && dictionary.index_count == 0) return false;
+	for (uint32_t i = 0; i < dictionary.index_count; i++){
+		const ColorIndexNode &node = dictionary.index[i];
+		if (node.begin > node.end || node.end > dictionary.entry_count) return false;
+		if ((node.left == 0) != (node.right == 0)) return false;
+		// children are always stored after their parent, which also rules out cycles
+		if (node.left != 0 && (node.left <= i || node.right <= i || node.left >= dictionary.index_count || node.right >= dictionary.index_count)) return false;
+	}
+	return true;
+}
+bool color_dictionary_cache_load(ColorDictionary &dictionary, const char *cache_filename, const char *filename, const FileCacheSource &source)
+{
+	bip::mapped_region region;
+	try{
+		bip::file_mapping mapping(cache_filename, bip::read_only);
+		bip::mapped_region mapped(mapping, bip::read_only);
+		region.swap(mapped);
+	}catch (const bip::interprocess_exception &){
+		return false;
+	}
+	if (region.get_size() < sizeof(CacheHeader)) return false;
+	const CacheHeader *header = static_cast<const CacheHeader*>(region.get_address());
+	if (!file_cache_header_check(header->file, CacheMagic, CacheVersion)) return false;
+	if (header->file.source_size != source.size) return false;
+	if (header->file.source_modification_time != source.modification_time){
+		uint64_t hash;
+		if (!file_cache_hash_file(filename, hash) || hash != header->file.source_hash) return false;
+	}
+	ColorDictionary result;
+	if (!get_section(region, header->entries_offset, header->entry_count, result.entries)) return false;
+	if (!get_section(region, header->index_offset, header->index_count, result.index)) return false;
+	if (!get_section(region, header->strings_offset, header->strings_size, result.strings)) return false;
+	result.entry_count = header->entry_count;
+	result.index_count = header->index_count;
+	result.strings_size = header->strings_size;
+	if (!validate(result)) return false;
+	dictionary.entries = result.entries;
+	dictionary.entry_count = result.entry_count;
+	dictionary.index = result.index;
+	dictionary.index_count = result.index_count;
+	dictionary.strings = result.strings;
+	dictionary.strings_size = result.strings_size;
+	dictionary.entry_storage.clear();
+	dictionary.index_storage.clear();
+	dictionary.string_storage.clear();
+	dictionary.region.swap(region);
+	return true;
+}
+static uint32_t align(uint32_t offset)
+{
+	return (offset + 7) & ~uint32_t(7);
+}
+static void write_section(ostream &file, uint32_t offset, const void *data, size_t size)
+{
+	static const char padding[8] = {};
+	file.write(padding, offset - uint32_t(file.tellp()));
+	file.write(static_cast<const char*>(data), size);
+}
+bool color_dictionary_cache_save(const ColorDictionary &dictionary, const char *cache_filename, const FileCacheSource &source)
+{
+	CacheHeader header;
+	memset(&header, 0, sizeof(header));
+	file_cache_header_init(header.file, CacheMagic, CacheVersion, source);
+	header.entry_count = dictionary.entry_count;
+	header.index_count = dictionary.index_count;
+	header.strings_size = dictionary.strings_size;
+	header.entries_offset = align(sizeof(CacheHeader));
+	header.index_offset = align(header.entries_offset + header.entry_count * sizeof(ColorNamesEntry));
+	header.strings_offset = align(header.index_offset + header.index_count * sizeof(ColorIndexNode));
+	return file_cache_write(cache_filename, [&](ostream &file){
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		write_section(file, header.entries_offset, dictionary.entries, header.entry_count * sizeof(ColorNamesEntry));
+		write_section(file, header.index_offset, dictionary.index, header.index_count * sizeof(ColorIndexNode));
+		write_section(file, header.strings_offset, dictionary.strings, header.strings_size);
+	});
+}
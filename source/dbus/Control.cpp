@@ -20,10 +20,17 @@
 #ifndef WIN32
 #include "DbusInterface.h"
 #include <iostream>
+#include <stdint.h>
 using namespace std;
 
 namespace dbus
 {
+	/** Maximum number of grid columns and rows accepted by SampleGrid */
+	const int MaxGridSize = 256;
+	/** Maximum number of points or regions accepted by SamplePoints and SampleRegions, same as the largest grid */
+	const int MaxSampleCount = MaxGridSize * MaxGridSize;
+	/** Maximum total area of regions accepted by SampleRegions, about 32 full HD screens */
+	const int64_t MaxRegionArea = int64_t(1) << 26;
 	struct Control::Impl
 	{
 		public:
@@ -119,6 +126,89 @@ namespace dbus
 				gpick_control_complete_check_if_running(control, invocation);
 				return true;
 			}
+			static GVariant *colors_to_variant(const vector<Color> &colors)
+			{
+				GVariantBuilder builder;
+				g_variant_builder_init(&builder, G_VARIANT_TYPE("a(ddd)"));
+				for (auto &color: colors){
+					g_variant_builder_add(&builder, "(ddd)", static_cast<double>(color.rgb.red), static_cast<double>(color.rgb.green), static_cast<double>(color.rgb.blue));
+				}
+				return g_variant_builder_end(&builder);
+			}
+			static gboolean on_control_sample_points(GpickControl *control, GDBusMethodInvocation *invocation, GVariant *points_variant, Impl *impl)
+			{
+				if (g_variant_n_children(points_variant) > static_cast<gsize>(MaxSampleCount)){
+					g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "At most %d points can be sampled at once", MaxSampleCount);
+					return true;
+				}
+				vector<math::Vec2<int>> points;
+				points.reserve(g_variant_n_children(points_variant));
+				GVariantIter iter;
+				gint32 x, y;
+				g_variant_iter_init(&iter, points_variant);
+				while (g_variant_iter_next(&iter, "(ii)", &x, &y)){
+					points.emplace_back(x, y);
+				}
+				vector<Color> colors;
+				if (!impl->m_decl->onSamplePoints || !impl->m_decl->onSamplePoints(points, colors)){
+					g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "All points must be inside the screen");
+					return true;
+				}
+				gpick_control_complete_sample_points(control, invocation, colors_to_variant(colors));
+				return true;
+			}
+			static gboolean on_control_sample_regions(GpickControl *control, GDBusMethodInvocation *invocation, GVariant *regions_variant, Impl *impl)
+			{
+				if (g_variant_n_children(regions_variant) > static_cast<gsize>(MaxSampleCount)){
+					g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "At most %d regions can be sampled at once", MaxSampleCount);
+					return true;
+				}
+				vector<math::Rect2<int>> regions;
+				regions.reserve(g_variant_n_children(regions_variant));
+				GVariantIter iter;
+				gint32 x, y, width, height;
+				int64_t area = 0;
+				g_variant_iter_init(&iter, regions_variant);
+				while (g_variant_iter_next(&iter, "(iiii)", &x, &y, &width, &height)){
+					if (width <= 0 || height <= 0){
+						g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "Region width and height must be positive");
+						return true;
+					}
+					area += int64_t(width) * height;
+					if (area > MaxRegionArea){
+						g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "Total area of regions must not exceed %d pixels", static_cast<int>(MaxRegionArea));
+						return true;
+					}
+					regions.emplace_back(x, y, x + width, y + height);
+				}
+				vector<Color> colors;
+				if (!impl->m_decl->onSampleRegions || !impl->m_decl->onSampleRegions(regions, colors)){
+					g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "All regions must intersect the screen");
+					return true;
+				}
+				gpick_control_complete_sample_regions(control, invocation, colors_to_variant(colors));
+				return true;
+			}
+			static gboolean on_control_sample_grid(GpickControl *control, GDBusMethodInvocation *invocation, gint x, gint y, gint width, gint height, gint columns, gint rows, Impl *impl)
+			{
+				if (width <= 0 || height <= 0 || columns <= 0 || rows <= 0 || columns > MaxGridSize || rows > MaxGridSize){
+					g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "Grid size must be positive and columns and rows must not exceed %d", MaxGridSize);
+					return true;
+				}
+				vector<Color> colors;
+				if (!impl->m_decl->onSampleGrid || !impl->m_decl->onSampleGrid(math::Rect2<int>(x, y, x + width, y + height), columns, rows, colors)){
+					g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "All grid cell centers must be inside the screen");
+					return true;
+				}
+				gpick_control_complete_sample_grid(control, invocation, colors_to_variant(colors));
+				return true;
+			}
+			static gboolean on_control_get_statistics(GpickControl *control, GDBusMethodInvocation *invocation, Impl *impl)
+			{
+				string statistics = impl->m_decl->onGetStatistics ? impl->m_decl->onGetStatistics() : string("{}");
+				gpick_control_complete_get_statistics(control, invocation, statistics.c_str());
+				return true;
+			}
 			static gboolean on_single_instance_activate(GpickSingleInstance *single_instance, GDBusMethodInvocation *invocation, Impl *impl)
 			{
 				bool result = impl->m_decl->onSingleInstanceActivate();
@@ -139,6 +229,10 @@ namespace dbus
 
 				g_signal_connect(control, "handle-activate-floating-picker", G_CALLBACK(on_control_activate_floating_picker), impl);
 				g_signal_connect(control, "handle-check-if-running", G_CALLBACK(on_control_check_if_running), impl);
+				g_signal_connect(control, "handle-sample-points", G_CALLBACK(on_control_sample_points), impl);
+				g_signal_connect(control, "handle-sample-regions", G_CALLBACK(on_control_sample_regions), impl);
+				g_signal_connect(control, "handle-sample-grid", G_CALLBACK(on_control_sample_grid), impl);
+				g_signal_connect(control, "handle-get-statistics", G_CALLBACK(on_control_get_statistics), impl);
 				g_dbus_object_manager_server_export(manager, G_DBUS_OBJECT_SKELETON(object));
 				g_object_unref(object);
 
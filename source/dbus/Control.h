@@ -19,9 +19,13 @@
 #ifndef GPICK_DBUS_CONTROL_H_
 #define GPICK_DBUS_CONTROL_H_
 
+#include "../Color.h"
+#include "../Rect2.h"
+#include "../Vector2.h"
 #include <memory>
 #include <functional>
 #include <string>
+#include <vector>
 namespace dbus
 {
 	struct Control
@@ -36,6 +40,14 @@ namespace dbus
 			bool checkIfRunning();
 			std::function<bool(const char *)> onActivateFloatingPicker;
 			std::function<bool()> onSingleInstanceActivate;
+			/** Sample colors at given screen points. Returns false if points can not be sampled. */
+			std::function<bool(const std::vector<math::Vec2<int>> &points, std::vector<Color> &colors)> onSamplePoints;
+			/** Get mean colors of given screen regions. Returns false if regions can not be sampled. */
+			std::function<bool(const std::vector<math::Rect2<int>> &regions, std::vector<Color> &colors)> onSampleRegions;
+			/** Sample colors at centers of grid cells covering the area, row by row. Returns false if grid can not be sampled. */
+			std::function<bool(const math::Rect2<int> &area, int columns, int rows, std::vector<Color> &colors)> onSampleGrid;
+			/** Get picker latency statistics as JSON object */
+			std::function<std::string()> onGetStatistics;
 		private:
 			struct Impl;
 			std::unique_ptr<Impl> m_impl;
@@ -1069,10 +1069,245 @@ static const _ExtendedGDBusMethodInfo _gpick_control_method_info_check_if_runnin
   FALSE
 };
 
+static const _ExtendedGDBusArgInfo _gpick_control_method_info_sample_points_IN_ARG_points =
+{
+  {
+    -1,
+    (gchar *) "points",
+    (gchar *) "a(ii)",
+    NULL
+  },
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo * const _gpick_control_method_info_sample_points_IN_ARG_pointers[] =
+{
+  &_gpick_control_method_info_sample_points_IN_ARG_points,
+  NULL
+};
+
+static const _ExtendedGDBusArgInfo _gpick_control_method_info_sample_points_OUT_ARG_colors =
+{
+  {
+    -1,
+    (gchar *) "colors",
+    (gchar *) "a(ddd)",
+    NULL
+  },
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo * const _gpick_control_method_info_sample_points_OUT_ARG_pointers[] =
+{
+  &_gpick_control_method_info_sample_points_OUT_ARG_colors,
+  NULL
+};
+
+static const _ExtendedGDBusMethodInfo _gpick_control_method_info_sample_points =
+{
+  {
+    -1,
+    (gchar *) "SamplePoints",
+    (GDBusArgInfo **) &_gpick_control_method_info_sample_points_IN_ARG_pointers,
+    (GDBusArgInfo **) &_gpick_control_method_info_sample_points_OUT_ARG_pointers,
+    NULL
+  },
+  "handle-sample-points",
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo _gpick_control_method_info_sample_regions_IN_ARG_regions =
+{
+  {
+    -1,
+    (gchar *) "regions",
+    (gchar *) "a(iiii)",
+    NULL
+  },
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo * const _gpick_control_method_info_sample_regions_IN_ARG_pointers[] =
+{
+  &_gpick_control_method_info_sample_regions_IN_ARG_regions,
+  NULL
+};
+
+static const _ExtendedGDBusArgInfo _gpick_control_method_info_sample_regions_OUT_ARG_colors =
+{
+  {
+    -1,
+    (gchar *) "colors",
+    (gchar *) "a(ddd)",
+    NULL
+  },
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo * const _gpick_control_method_info_sample_regions_OUT_ARG_pointers[] =
+{
+  &_gpick_control_method_info_sample_regions_OUT_ARG_colors,
+  NULL
+};
+
+static const _ExtendedGDBusMethodInfo _gpick_control_method_info_sample_regions =
+{
+  {
+    -1,
+    (gchar *) "SampleRegions",
+    (GDBusArgInfo **) &_gpick_control_method_info_sample_regions_IN_ARG_pointers,
+    (GDBusArgInfo **) &_gpick_control_method_info_sample_regions_OUT_ARG_pointers,
+    NULL
+  },
+  "handle-sample-regions",
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo _gpick_control_method_info_sample_grid_IN_ARG_x =
+{
+  {
+    -1,
+    (gchar *) "x",
+    (gchar *) "i",
+    NULL
+  },
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo _gpick_control_method_info_sample_grid_IN_ARG_y =
+{
+  {
+    -1,
+    (gchar *) "y",
+    (gchar *) "i",
+    NULL
+  },
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo _gpick_control_method_info_sample_grid_IN_ARG_width =
+{
+  {
+    -1,
+    (gchar *) "width",
+    (gchar *) "i",
+    NULL
+  },
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo _gpick_control_method_info_sample_grid_IN_ARG_height =
+{
+  {
+    -1,
+    (gchar *) "height",
+    (gchar *) "i",
+    NULL
+  },
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo _gpick_control_method_info_sample_grid_IN_ARG_columns =
+{
+  {
+    -1,
+    (gchar *) "columns",
+    (gchar *) "i",
+    NULL
+  },
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo _gpick_control_method_info_sample_grid_IN_ARG_rows =
+{
+  {
+    -1,
+    (gchar *) "rows",
+    (gchar *) "i",
+    NULL
+  },
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo * const _gpick_control_method_info_sample_grid_IN_ARG_pointers[] =
+{
+  &_gpick_control_method_info_sample_grid_IN_ARG_x,
+  &_gpick_control_method_info_sample_grid_IN_ARG_y,
+  &_gpick_control_method_info_sample_grid_IN_ARG_width,
+  &_gpick_control_method_info_sample_grid_IN_ARG_height,
+  &_gpick_control_method_info_sample_grid_IN_ARG_columns,
+  &_gpick_control_method_info_sample_grid_IN_ARG_rows,
+  NULL
+};
+
+static const _ExtendedGDBusArgInfo _gpick_control_method_info_sample_grid_OUT_ARG_colors =
+{
+  {
+    -1,
+    (gchar *) "colors",
+    (gchar *) "a(ddd)",
+    NULL
+  },
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo * const _gpick_control_method_info_sample_grid_OUT_ARG_pointers[] =
+{
+  &_gpick_control_method_info_sample_grid_OUT_ARG_colors,
+  NULL
+};
+
+static const _ExtendedGDBusMethodInfo _gpick_control_method_info_sample_grid =
+{
+  {
+    -1,
+    (gchar *) "SampleGrid",
+    (GDBusArgInfo **) &_gpick_control_method_info_sample_grid_IN_ARG_pointers,
+    (GDBusArgInfo **) &_gpick_control_method_info_sample_grid_OUT_ARG_pointers,
+    NULL
+  },
+  "handle-sample-grid",
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo _gpick_control_method_info_get_statistics_OUT_ARG_statistics =
+{
+  {
+    -1,
+    (gchar *) "statistics",
+    (gchar *) "s",
+    NULL
+  },
+  FALSE
+};
+
+static const _ExtendedGDBusArgInfo * const _gpick_control_method_info_get_statistics_OUT_ARG_pointers[] =
+{
+  &_gpick_control_method_info_get_statistics_OUT_ARG_statistics,
+  NULL
+};
+
+static const _ExtendedGDBusMethodInfo _gpick_control_method_info_get_statistics =
+{
+  {
+    -1,
+    (gchar *) "GetStatistics",
+    NULL,
+    (GDBusArgInfo **) &_gpick_control_method_info_get_statistics_OUT_ARG_pointers,
+    NULL
+  },
+  "handle-get-statistics",
+  FALSE
+};
+
 static const _ExtendedGDBusMethodInfo * const _gpick_control_method_info_pointers[] =
 {
   &_gpick_control_method_info_activate_floating_picker,
   &_gpick_control_method_info_check_if_running,
+  &_gpick_control_method_info_sample_points,
+  &_gpick_control_method_info_sample_regions,
+  &_gpick_control_method_info_sample_grid,
+  &_gpick_control_method_info_get_statistics,
   NULL
 };
 
@@ -1132,6 +1367,10 @@ gpick_control_override_properties (GObjectClass *klass, guint property_id_begin)
  * @parent_iface: The parent interface.
  * @handle_activate_floating_picker: Handler for the #GpickControl::handle-activate-floating-picker signal.
  * @handle_check_if_running: Handler for the #GpickControl::handle-check-if-running signal.
+ * @handle_sample_points: Handler for the #GpickControl::handle-sample-points signal.
+ * @handle_sample_regions: Handler for the #GpickControl::handle-sample-regions signal.
+ * @handle_sample_grid: Handler for the #GpickControl::handle-sample-grid signal.
+ * @handle_get_statistics: Handler for the #GpickControl::handle-get-statistics signal.
  *
  * Virtual table for the D-Bus interface <link linkend="gdbus-interface-org-gpick-Control.top_of_page">org.gpick.Control</link>.
  */
@@ -1188,6 +1427,102 @@ gpick_control_default_init (GpickControlIface *iface)
     1,
     G_TYPE_DBUS_METHOD_INVOCATION);
 
+  /**
+   * GpickControl::handle-sample-points:
+   * @object: A #GpickControl.
+   * @invocation: A #GDBusMethodInvocation.
+   * @arg_points: Argument passed by remote caller.
+   *
+   * Signal emitted when a remote caller is invoking the <link linkend="gdbus-method-org-gpick-Control.SamplePoints">SamplePoints()</link> D-Bus method.
+   *
+   * If a signal handler returns %TRUE, it means the signal handler will handle the invocation (e.g. take a reference to @invocation and eventually call gpick_control_complete_sample_points() or e.g. g_dbus_method_invocation_return_error() on it) and no order signal handlers will run. If no signal handler handles the invocation, the %G_DBUS_ERROR_UNKNOWN_METHOD error is returned.
+   *
+   * Returns: %TRUE if the invocation was handled, %FALSE to let other signal handlers run.
+   */
+  g_signal_new ("handle-sample-points",
+    G_TYPE_FROM_INTERFACE (iface),
+    G_SIGNAL_RUN_LAST,
+    G_STRUCT_OFFSET (GpickControlIface, handle_sample_points),
+    g_signal_accumulator_true_handled,
+    NULL,
+    g_cclosure_marshal_generic,
+    G_TYPE_BOOLEAN,
+    2,
+    G_TYPE_DBUS_METHOD_INVOCATION, G_TYPE_VARIANT);
+
+  /**
+   * GpickControl::handle-sample-regions:
+   * @object: A #GpickControl.
+   * @invocation: A #GDBusMethodInvocation.
+   * @arg_regions: Argument passed by remote caller.
+   *
+   * Signal emitted when a remote caller is invoking the <link linkend="gdbus-method-org-gpick-Control.SampleRegions">SampleRegions()</link> D-Bus method.
+   *
+   * If a signal handler returns %TRUE, it means the signal handler will handle the invocation (e.g. take a reference to @invocation and eventually call gpick_control_complete_sample_regions() or e.g. g_dbus_method_invocation_return_error() on it) and no order signal handlers will run. If no signal handler handles the invocation, the %G_DBUS_ERROR_UNKNOWN_METHOD error is returned.
+   *
+   * Returns: %TRUE if the invocation was handled, %FALSE to let other signal handlers run.
+   */
+  g_signal_new ("handle-sample-regions",
+    G_TYPE_FROM_INTERFACE (iface),
+    G_SIGNAL_RUN_LAST,
+    G_STRUCT_OFFSET (GpickControlIface, handle_sample_regions),
+    g_signal_accumulator_true_handled,
+    NULL,
+    g_cclosure_marshal_generic,
+    G_TYPE_BOOLEAN,
+    2,
+    G_TYPE_DBUS_METHOD_INVOCATION, G_TYPE_VARIANT);
+
+  /**
+   * GpickControl::handle-sample-grid:
+   * @object: A #GpickControl.
+   * @invocation: A #GDBusMethodInvocation.
+   * @arg_x: Argument passed by remote caller.
+   * @arg_y: Argument passed by remote caller.
+   * @arg_width: Argument passed by remote caller.
+   * @arg_height: Argument passed by remote caller.
+   * @arg_columns: Argument passed by remote caller.
+   * @arg_rows: Argument passed by remote caller.
+   *
+   * Signal emitted when a remote caller is invoking the <link linkend="gdbus-method-org-gpick-Control.SampleGrid">SampleGrid()</link> D-Bus method.
+   *
+   * If a signal handler returns %TRUE, it means the signal handler will handle the invocation (e.g. take a reference to @invocation and eventually call gpick_control_complete_sample_grid() or e.g. g_dbus_method_invocation_return_error() on it) and no order signal handlers will run. If no signal handler handles the invocation, the %G_DBUS_ERROR_UNKNOWN_METHOD error is returned.
+   *
+   * Returns: %TRUE if the invocation was handled, %FALSE to let other signal handlers run.
+   */
+  g_signal_new ("handle-sample-grid",
+    G_TYPE_FROM_INTERFACE (iface),
+    G_SIGNAL_RUN_LAST,
+    G_STRUCT_OFFSET (GpickControlIface, handle_sample_grid),
+    g_signal_accumulator_true_handled,
+    NULL,
+    g_cclosure_marshal_generic,
+    G_TYPE_BOOLEAN,
+    7,
+    G_TYPE_DBUS_METHOD_INVOCATION, G_TYPE_INT, G_TYPE_INT, G_TYPE_INT, G_TYPE_INT, G_TYPE_INT, G_TYPE_INT);
+
+  /**
+   * GpickControl::handle-get-statistics:
+   * @object: A #GpickControl.
+   * @invocation: A #GDBusMethodInvocation.
+   *
+   * Signal emitted when a remote caller is invoking the <link linkend="gdbus-method-org-gpick-Control.GetStatistics">GetStatistics()</link> D-Bus method.
+   *
+   * If a signal handler returns %TRUE, it means the signal handler will handle the invocation (e.g. take a reference to @invocation and eventually call gpick_control_complete_get_statistics() or e.g. g_dbus_method_invocation_return_error() on it) and no order signal handlers will run. If no signal handler handles the invocation, the %G_DBUS_ERROR_UNKNOWN_METHOD error is returned.
+   *
+   * Returns: %TRUE if the invocation was handled, %FALSE to let other signal handlers run.
+   */
+  g_signal_new ("handle-get-statistics",
+    G_TYPE_FROM_INTERFACE (iface),
+    G_SIGNAL_RUN_LAST,
+    G_STRUCT_OFFSET (GpickControlIface, handle_get_statistics),
+    g_signal_accumulator_true_handled,
+    NULL,
+    g_cclosure_marshal_generic,
+    G_TYPE_BOOLEAN,
+    1,
+    G_TYPE_DBUS_METHOD_INVOCATION);
+
 }
 
 /**
@@ -1381,33 +1716,473 @@ _out:
 }
 
 /**
- * gpick_control_complete_activate_floating_picker:
- * @object: A #GpickControl.
- * @invocation: (transfer full): A #GDBusMethodInvocation.
+ * gpick_control_call_sample_points:
+ * @proxy: A #GpickControlProxy.
+ * @arg_points: Argument to pass with the method invocation.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
  *
- * Helper function used in service implementations to finish handling invocations of the <link linkend="gdbus-method-org-gpick-Control.ActivateFloatingPicker">ActivateFloatingPicker()</link> D-Bus method. If you instead want to finish handling an invocation by returning an error, use g_dbus_method_invocation_return_error() or similar.
+ * Asynchronously invokes the <link linkend="gdbus-method-org-gpick-Control.SamplePoints">SamplePoints()</link> D-Bus method on @proxy.
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call gpick_control_call_sample_points_finish() to get the result of the operation.
  *
- * This method will free @invocation, you cannot use it afterwards.
+ * See gpick_control_call_sample_points_sync() for the synchronous, blocking version of this method.
  */
 void
-gpick_control_complete_activate_floating_picker (
-    GpickControl *object,
-    GDBusMethodInvocation *invocation)
+gpick_control_call_sample_points (
+    GpickControl *proxy,
+    GVariant *arg_points,
+    GCancellable *cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data)
 {
-  g_dbus_method_invocation_return_value (invocation,
-    g_variant_new ("()"));
+  g_dbus_proxy_call (G_DBUS_PROXY (proxy),
+    "SamplePoints",
+    g_variant_new ("(@a(ii))",
+                   arg_points),
+    G_DBUS_CALL_FLAGS_NONE,
+    -1,
+    cancellable,
+    callback,
+    user_data);
 }
 
 /**
- * gpick_control_complete_check_if_running:
- * @object: A #GpickControl.
- * @invocation: (transfer full): A #GDBusMethodInvocation.
+ * gpick_control_call_sample_points_finish:
+ * @proxy: A #GpickControlProxy.
+ * @out_colors: (out): Return location for return parameter or %NULL to ignore.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to gpick_control_call_sample_points().
+ * @error: Return location for error or %NULL.
  *
- * Helper function used in service implementations to finish handling invocations of the <link linkend="gdbus-method-org-gpick-Control.CheckIfRunning">CheckIfRunning()</link> D-Bus method. If you instead want to finish handling an invocation by returning an error, use g_dbus_method_invocation_return_error() or similar.
+ * Finishes an operation started with gpick_control_call_sample_points().
  *
- * This method will free @invocation, you cannot use it afterwards.
+ * Returns: (skip): %TRUE if the call succeded, %FALSE if @error is set.
  */
-void
+gboolean
+gpick_control_call_sample_points_finish (
+    GpickControl *proxy,
+    GVariant **out_colors,
+    GAsyncResult *res,
+    GError **error)
+{
+  GVariant *_ret;
+  _ret = g_dbus_proxy_call_finish (G_DBUS_PROXY (proxy), res, error);
+  if (_ret == NULL)
+    goto _out;
+  g_variant_get (_ret,
+                 "(@a(ddd))",
+                 out_colors);
+  g_variant_unref (_ret);
+_out:
+  return _ret != NULL;
+}
+
+/**
+ * gpick_control_call_sample_points_sync:
+ * @proxy: A #GpickControlProxy.
+ * @arg_points: Argument to pass with the method invocation.
+ * @out_colors: (out): Return location for return parameter or %NULL to ignore.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously invokes the <link linkend="gdbus-method-org-gpick-Control.SamplePoints">SamplePoints()</link> D-Bus method on @proxy. The calling thread is blocked until a reply is received.
+ *
+ * See gpick_control_call_sample_points() for the asynchronous version of this method.
+ *
+ * Returns: (skip): %TRUE if the call succeded, %FALSE if @error is set.
+ */
+gboolean
+gpick_control_call_sample_points_sync (
+    GpickControl *proxy,
+    GVariant *arg_points,
+    GVariant **out_colors,
+    GCancellable *cancellable,
+    GError **error)
+{
+  GVariant *_ret;
+  _ret = g_dbus_proxy_call_sync (G_DBUS_PROXY (proxy),
+    "SamplePoints",
+    g_variant_new ("(@a(ii))",
+                   arg_points),
+    G_DBUS_CALL_FLAGS_NONE,
+    -1,
+    cancellable,
+    error);
+  if (_ret == NULL)
+    goto _out;
+  g_variant_get (_ret,
+                 "(@a(ddd))",
+                 out_colors);
+  g_variant_unref (_ret);
+_out:
+  return _ret != NULL;
+}
+
+/**
+ * gpick_control_call_sample_regions:
+ * @proxy: A #GpickControlProxy.
+ * @arg_regions: Argument to pass with the method invocation.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously invokes the <link linkend="gdbus-method-org-gpick-Control.SampleRegions">SampleRegions()</link> D-Bus method on @proxy.
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call gpick_control_call_sample_regions_finish() to get the result of the operation.
+ *
+ * See gpick_control_call_sample_regions_sync() for the synchronous, blocking version of this method.
+ */
+void
+gpick_control_call_sample_regions (
+    GpickControl *proxy,
+    GVariant *arg_regions,
+    GCancellable *cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+  g_dbus_proxy_call (G_DBUS_PROXY (proxy),
+    "SampleRegions",
+    g_variant_new ("(@a(iiii))",
+                   arg_regions),
+    G_DBUS_CALL_FLAGS_NONE,
+    -1,
+    cancellable,
+    callback,
+    user_data);
+}
+
+/**
+ * gpick_control_call_sample_regions_finish:
+ * @proxy: A #GpickControlProxy.
+ * @out_colors: (out): Return location for return parameter or %NULL to ignore.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to gpick_control_call_sample_regions().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with gpick_control_call_sample_regions().
+ *
+ * Returns: (skip): %TRUE if the call succeded, %FALSE if @error is set.
+ */
+gboolean
+gpick_control_call_sample_regions_finish (
+    GpickControl *proxy,
+    GVariant **out_colors,
+    GAsyncResult *res,
+    GError **error)
+{
+  GVariant *_ret;
+  _ret = g_dbus_proxy_call_finish (G_DBUS_PROXY (proxy), res, error);
+  if (_ret == NULL)
+    goto _out;
+  g_variant_get (_ret,
+                 "(@a(ddd))",
+                 out_colors);
+  g_variant_unref (_ret);
+_out:
+  return _ret != NULL;
+}
+
+/**
+ * gpick_control_call_sample_regions_sync:
+ * @proxy: A #GpickControlProxy.
+ * @arg_regions: Argument to pass with the method invocation.
+ * @out_colors: (out): Return location for return parameter or %NULL to ignore.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously invokes the <link linkend="gdbus-method-org-gpick-Control.SampleRegions">SampleRegions()</link> D-Bus method on @proxy. The calling thread is blocked until a reply is received.
+ *
+ * See gpick_control_call_sample_regions() for the asynchronous version of this method.
+ *
+ * Returns: (skip): %TRUE if the call succeded, %FALSE if @error is set.
+ */
+gboolean
+gpick_control_call_sample_regions_sync (
+    GpickControl *proxy,
+    GVariant *arg_regions,
+    GVariant **out_colors,
+    GCancellable *cancellable,
+    GError **error)
+{
+  GVariant *_ret;
+  _ret = g_dbus_proxy_call_sync (G_DBUS_PROXY (proxy),
+    "SampleRegions",
+    g_variant_new ("(@a(iiii))",
+                   arg_regions),
+    G_DBUS_CALL_FLAGS_NONE,
+    -1,
+    cancellable,
+    error);
+  if (_ret == NULL)
+    goto _out;
+  g_variant_get (_ret,
+                 "(@a(ddd))",
+                 out_colors);
+  g_variant_unref (_ret);
+_out:
+  return _ret != NULL;
+}
+
+/**
+ * gpick_control_call_sample_grid:
+ * @proxy: A #GpickControlProxy.
+ * @arg_x: Argument to pass with the method invocation.
+ * @arg_y: Argument to pass with the method invocation.
+ * @arg_width: Argument to pass with the method invocation.
+ * @arg_height: Argument to pass with the method invocation.
+ * @arg_columns: Argument to pass with the method invocation.
+ * @arg_rows: Argument to pass with the method invocation.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously invokes the <link linkend="gdbus-method-org-gpick-Control.SampleGrid">SampleGrid()</link> D-Bus method on @proxy.
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call gpick_control_call_sample_grid_finish() to get the result of the operation.
+ *
+ * See gpick_control_call_sample_grid_sync() for the synchronous, blocking version of this method.
+ */
+void
+gpick_control_call_sample_grid (
+    GpickControl *proxy,
+    gint arg_x,
+    gint arg_y,
+    gint arg_width,
+    gint arg_height,
+    gint arg_columns,
+    gint arg_rows,
+    GCancellable *cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+  g_dbus_proxy_call (G_DBUS_PROXY (proxy),
+    "SampleGrid",
+    g_variant_new ("(iiiiii)",
+                   arg_x,
+                   arg_y,
+                   arg_width,
+                   arg_height,
+                   arg_columns,
+                   arg_rows),
+    G_DBUS_CALL_FLAGS_NONE,
+    -1,
+    cancellable,
+    callback,
+    user_data);
+}
+
+/**
+ * gpick_control_call_sample_grid_finish:
+ * @proxy: A #GpickControlProxy.
+ * @out_colors: (out): Return location for return parameter or %NULL to ignore.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to gpick_control_call_sample_grid().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with gpick_control_call_sample_grid().
+ *
+ * Returns: (skip): %TRUE if the call succeded, %FALSE if @error is set.
+ */
+gboolean
+gpick_control_call_sample_grid_finish (
+    GpickControl *proxy,
+    GVariant **out_colors,
+    GAsyncResult *res,
+    GError **error)
+{
+  GVariant *_ret;
+  _ret = g_dbus_proxy_call_finish (G_DBUS_PROXY (proxy), res, error);
+  if (_ret == NULL)
+    goto _out;
+  g_variant_get (_ret,
+                 "(@a(ddd))",
+                 out_colors);
+  g_variant_unref (_ret);
+_out:
+  return _ret != NULL;
+}
+
+/**
+ * gpick_control_call_sample_grid_sync:
+ * @proxy: A #GpickControlProxy.
+ * @arg_x: Argument to pass with the method invocation.
+ * @arg_y: Argument to pass with the method invocation.
+ * @arg_width: Argument to pass with the method invocation.
+ * @arg_height: Argument to pass with the method invocation.
+ * @arg_columns: Argument to pass with the method invocation.
+ * @arg_rows: Argument to pass with the method invocation.
+ * @out_colors: (out): Return location for return parameter or %NULL to ignore.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously invokes the <link linkend="gdbus-method-org-gpick-Control.SampleGrid">SampleGrid()</link> D-Bus method on @proxy. The calling thread is blocked until a reply is received.
+ *
+ * See gpick_control_call_sample_grid() for the asynchronous version of this method.
+ *
+ * Returns: (skip): %TRUE if the call succeded, %FALSE if @error is set.
+ */
+gboolean
+gpick_control_call_sample_grid_sync (
+    GpickControl *proxy,
+    gint arg_x,
+    gint arg_y,
+    gint arg_width,
+    gint arg_height,
+    gint arg_columns,
+    gint arg_rows,
+    GVariant **out_colors,
+    GCancellable *cancellable,
+    GError **error)
+{
+  GVariant *_ret;
+  _ret = g_dbus_proxy_call_sync (G_DBUS_PROXY (proxy),
+    "SampleGrid",
+    g_variant_new ("(iiiiii)",
+                   arg_x,
+                   arg_y,
+                   arg_width,
+                   arg_height,
+                   arg_columns,
+                   arg_rows),
+    G_DBUS_CALL_FLAGS_NONE,
+    -1,
+    cancellable,
+    error);
+  if (_ret == NULL)
+    goto _out;
+  g_variant_get (_ret,
+                 "(@a(ddd))",
+                 out_colors);
+  g_variant_unref (_ret);
+_out:
+  return _ret != NULL;
+}
+
+/**
+ * gpick_control_call_get_statistics:
+ * @proxy: A #GpickControlProxy.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously invokes the <link linkend="gdbus-method-org-gpick-Control.GetStatistics">GetStatistics()</link> D-Bus method on @proxy.
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call gpick_control_call_get_statistics_finish() to get the result of the operation.
+ *
+ * See gpick_control_call_get_statistics_sync() for the synchronous, blocking version of this method.
+ */
+void
+gpick_control_call_get_statistics (
+    GpickControl *proxy,
+    GCancellable *cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+  g_dbus_proxy_call (G_DBUS_PROXY (proxy),
+    "GetStatistics",
+    g_variant_new ("()"),
+    G_DBUS_CALL_FLAGS_NONE,
+    -1,
+    cancellable,
+    callback,
+    user_data);
+}
+
+/**
+ * gpick_control_call_get_statistics_finish:
+ * @proxy: A #GpickControlProxy.
+ * @out_statistics: (out): Return location for return parameter or %NULL to ignore.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to gpick_control_call_get_statistics().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with gpick_control_call_get_statistics().
+ *
+ * Returns: (skip): %TRUE if the call succeded, %FALSE if @error is set.
+ */
+gboolean
+gpick_control_call_get_statistics_finish (
+    GpickControl *proxy,
+    gchar **out_statistics,
+    GAsyncResult *res,
+    GError **error)
+{
+  GVariant *_ret;
+  _ret = g_dbus_proxy_call_finish (G_DBUS_PROXY (proxy), res, error);
+  if (_ret == NULL)
+    goto _out;
+  g_variant_get (_ret,
+                 "(s)",
+                 out_statistics);
+  g_variant_unref (_ret);
+_out:
+  return _ret != NULL;
+}
+
+/**
+ * gpick_control_call_get_statistics_sync:
+ * @proxy: A #GpickControlProxy.
+ * @out_statistics: (out): Return location for return parameter or %NULL to ignore.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously invokes the <link linkend="gdbus-method-org-gpick-Control.GetStatistics">GetStatistics()</link> D-Bus method on @proxy. The calling thread is blocked until a reply is received.
+ *
+ * See gpick_control_call_get_statistics() for the asynchronous version of this method.
+ *
+ * Returns: (skip): %TRUE if the call succeded, %FALSE if @error is set.
+ */
+gboolean
+gpick_control_call_get_statistics_sync (
+    GpickControl *proxy,
+    gchar **out_statistics,
+    GCancellable *cancellable,
+    GError **error)
+{
+  GVariant *_ret;
+  _ret = g_dbus_proxy_call_sync (G_DBUS_PROXY (proxy),
+    "GetStatistics",
+    g_variant_new ("()"),
+    G_DBUS_CALL_FLAGS_NONE,
+    -1,
+    cancellable,
+    error);
+  if (_ret == NULL)
+    goto _out;
+  g_variant_get (_ret,
+                 "(s)",
+                 out_statistics);
+  g_variant_unref (_ret);
+_out:
+  return _ret != NULL;
+}
+
+/**
+ * gpick_control_complete_activate_floating_picker:
+ * @object: A #GpickControl.
+ * @invocation: (transfer full): A #GDBusMethodInvocation.
+ *
+ * Helper function used in service implementations to finish handling invocations of the <link linkend="gdbus-method-org-gpick-Control.ActivateFloatingPicker">ActivateFloatingPicker()</link> D-Bus method. If you instead want to finish handling an invocation by returning an error, use g_dbus_method_invocation_return_error() or similar.
+ *
+ * This method will free @invocation, you cannot use it afterwards.
+ */
+void
+gpick_control_complete_activate_floating_picker (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation)
+{
+  g_dbus_method_invocation_return_value (invocation,
+    g_variant_new ("()"));
+}
+
+/**
+ * gpick_control_complete_check_if_running:
+ * @object: A #GpickControl.
+ * @invocation: (transfer full): A #GDBusMethodInvocation.
+ *
+ * Helper function used in service implementations to finish handling invocations of the <link linkend="gdbus-method-org-gpick-Control.CheckIfRunning">CheckIfRunning()</link> D-Bus method. If you instead want to finish handling an invocation by returning an error, use g_dbus_method_invocation_return_error() or similar.
+ *
+ * This method will free @invocation, you cannot use it afterwards.
+ */
+void
 gpick_control_complete_check_if_running (
     GpickControl *object,
     GDBusMethodInvocation *invocation)
@@ -1416,6 +2191,90 @@ gpick_control_complete_check_if_running (
     g_variant_new ("()"));
 }
 
+/**
+ * gpick_control_complete_sample_points:
+ * @object: A #GpickControl.
+ * @invocation: (transfer full): A #GDBusMethodInvocation.
+ * @colors: Parameter to return.
+ *
+ * Helper function used in service implementations to finish handling invocations of the <link linkend="gdbus-method-org-gpick-Control.SamplePoints">SamplePoints()</link> D-Bus method. If you instead want to finish handling an invocation by returning an error, use g_dbus_method_invocation_return_error() or similar.
+ *
+ * This method will free @invocation, you cannot use it afterwards.
+ */
+void
+gpick_control_complete_sample_points (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation,
+    GVariant *colors)
+{
+  g_dbus_method_invocation_return_value (invocation,
+    g_variant_new ("(@a(ddd))",
+                   colors));
+}
+
+/**
+ * gpick_control_complete_sample_regions:
+ * @object: A #GpickControl.
+ * @invocation: (transfer full): A #GDBusMethodInvocation.
+ * @colors: Parameter to return.
+ *
+ * Helper function used in service implementations to finish handling invocations of the <link linkend="gdbus-method-org-gpick-Control.SampleRegions">SampleRegions()</link> D-Bus method. If you instead want to finish handling an invocation by returning an error, use g_dbus_method_invocation_return_error() or similar.
+ *
+ * This method will free @invocation, you cannot use it afterwards.
+ */
+void
+gpick_control_complete_sample_regions (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation,
+    GVariant *colors)
+{
+  g_dbus_method_invocation_return_value (invocation,
+    g_variant_new ("(@a(ddd))",
+                   colors));
+}
+
+/**
+ * gpick_control_complete_sample_grid:
+ * @object: A #GpickControl.
+ * @invocation: (transfer full): A #GDBusMethodInvocation.
+ * @colors: Parameter to return.
+ *
+ * Helper function used in service implementations to finish handling invocations of the <link linkend="gdbus-method-org-gpick-Control.SampleGrid">SampleGrid()</link> D-Bus method. If you instead want to finish handling an invocation by returning an error, use g_dbus_method_invocation_return_error() or similar.
+ *
+ * This method will free @invocation, you cannot use it afterwards.
+ */
+void
+gpick_control_complete_sample_grid (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation,
+    GVariant *colors)
+{
+  g_dbus_method_invocation_return_value (invocation,
+    g_variant_new ("(@a(ddd))",
+                   colors));
+}
+
+/**
+ * gpick_control_complete_get_statistics:
+ * @object: A #GpickControl.
+ * @invocation: (transfer full): A #GDBusMethodInvocation.
+ * @statistics: Parameter to return.
+ *
+ * Helper function used in service implementations to finish handling invocations of the <link linkend="gdbus-method-org-gpick-Control.GetStatistics">GetStatistics()</link> D-Bus method. If you instead want to finish handling an invocation by returning an error, use g_dbus_method_invocation_return_error() or similar.
+ *
+ * This method will free @invocation, you cannot use it afterwards.
+ */
+void
+gpick_control_complete_get_statistics (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation,
+    const gchar *statistics)
+{
+  g_dbus_method_invocation_return_value (invocation,
+    g_variant_new ("(s)",
+                   statistics));
+}
+
 /* ------------------------------------------------------------------------ */
 
 /**
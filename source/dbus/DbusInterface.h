@@ -195,6 +195,30 @@ struct _GpickControlIface
     GpickControl *object,
     GDBusMethodInvocation *invocation);
 
+  gboolean (*handle_sample_points) (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation,
+    GVariant *arg_points);
+
+  gboolean (*handle_sample_regions) (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation,
+    GVariant *arg_regions);
+
+  gboolean (*handle_sample_grid) (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation,
+    gint arg_x,
+    gint arg_y,
+    gint arg_width,
+    gint arg_height,
+    gint arg_columns,
+    gint arg_rows);
+
+  gboolean (*handle_get_statistics) (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation);
+
 };
 
 GType gpick_control_get_type (void) G_GNUC_CONST;
@@ -212,6 +236,26 @@ void gpick_control_complete_check_if_running (
     GpickControl *object,
     GDBusMethodInvocation *invocation);
 
+void gpick_control_complete_sample_points (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation,
+    GVariant *colors);
+
+void gpick_control_complete_sample_regions (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation,
+    GVariant *colors);
+
+void gpick_control_complete_sample_grid (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation,
+    GVariant *colors);
+
+void gpick_control_complete_get_statistics (
+    GpickControl *object,
+    GDBusMethodInvocation *invocation,
+    const gchar *statistics);
+
 
 
 /* D-Bus method calls: */
@@ -249,6 +293,94 @@ gboolean gpick_control_call_check_if_running_sync (
     GCancellable *cancellable,
     GError **error);
 
+void gpick_control_call_sample_points (
+    GpickControl *proxy,
+    GVariant *arg_points,
+    GCancellable *cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data);
+
+gboolean gpick_control_call_sample_points_finish (
+    GpickControl *proxy,
+    GVariant **out_colors,
+    GAsyncResult *res,
+    GError **error);
+
+gboolean gpick_control_call_sample_points_sync (
+    GpickControl *proxy,
+    GVariant *arg_points,
+    GVariant **out_colors,
+    GCancellable *cancellable,
+    GError **error);
+
+void gpick_control_call_sample_regions (
+    GpickControl *proxy,
+    GVariant *arg_regions,
+    GCancellable *cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data);
+
+gboolean gpick_control_call_sample_regions_finish (
+    GpickControl *proxy,
+    GVariant **out_colors,
+    GAsyncResult *res,
+    GError **error);
+
+gboolean gpick_control_call_sample_regions_sync (
+    GpickControl *proxy,
+    GVariant *arg_regions,
+    GVariant **out_colors,
+    GCancellable *cancellable,
+    GError **error);
+
+void gpick_control_call_sample_grid (
+    GpickControl *proxy,
+    gint arg_x,
+    gint arg_y,
+    gint arg_width,
+    gint arg_height,
+    gint arg_columns,
+    gint arg_rows,
+    GCancellable *cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data);
+
+gboolean gpick_control_call_sample_grid_finish (
+    GpickControl *proxy,
+    GVariant **out_colors,
+    GAsyncResult *res,
+    GError **error);
+
+gboolean gpick_control_call_sample_grid_sync (
+    GpickControl *proxy,
+    gint arg_x,
+    gint arg_y,
+    gint arg_width,
+    gint arg_height,
+    gint arg_columns,
+    gint arg_rows,
+    GVariant **out_colors,
+    GCancellable *cancellable,
+    GError **error);
+
+void gpick_control_call_get_statistics (
+    GpickControl *proxy,
+    GCancellable *cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data);
+
+gboolean gpick_control_call_get_statistics_finish (
+    GpickControl *proxy,
+    gchar **out_statistics,
+    GAsyncResult *res,
+    GError **error);
+
+gboolean gpick_control_call_get_statistics_sync (
+    GpickControl *proxy,
+    gchar **out_statistics,
+    GCancellable *cancellable,
+    GError **error);
+
 
 
 /* ---- */
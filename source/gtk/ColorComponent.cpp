@@ -19,11 +19,15 @@
 #include "ColorComponent.h"
 #include "../uiUtilities.h"
 #include "../Color.h"
+#include "../ColorPipeline.h"
 #include "../MathUtil.h"
 #include "../Paths.h"
 #include <math.h>
 #include <string.h>
-#include <vector>
+#include <stdint.h>
+#ifdef GPICK_X86_KERNELS
+#include <immintrin.h>
+#endif
 using namespace std;
 
 #define GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), GTK_TYPE_COLOR_COMPONENT, GtkColorComponentPrivate))
@@ -47,6 +51,10 @@ enum
 	LAST_SIGNAL
 };
 static const int MaxNumberOfComponents = 4;
+/** Gradient colors are converted at the ends of this many segments and interpolated in between */
+static const int GradientSteps = 100;
+static const int GradientWidth = 200;
+static const int ComponentHeight = 16;
 static guint signals[LAST_SIGNAL] = {};
 struct GtkColorComponentPrivate
 {
@@ -60,8 +68,16 @@ struct GtkColorComponentPrivate
 	bool out_of_gamut_mask;
 	ReferenceIlluminant lab_illuminant;
 	ReferenceObserver lab_observer;
+	RgbToLabPipeline rgb_to_lab;
+	RgbToLchPipeline rgb_to_lch;
+	LabToRgbPipeline lab_to_rgb;
+	LchToRgbPipeline lch_to_rgb;
 	cairo_surface_t *pattern_surface;
 	cairo_pattern_t *pattern;
+	cairo_surface_t *gradient_surface; /**< Gradient strips of all components, each strip is rebuilt only when other components of color change */
+	Color gradient_color[MaxNumberOfComponents]; /**< Color each gradient strip was built for */
+	bool gradient_valid[MaxNumberOfComponents];
+	bool out_of_gamut[MaxNumberOfComponents][GradientSteps + 1];
 	const char *label[MaxNumberOfComponents][2];
 	gchar *text[MaxNumberOfComponents];
 	double range[MaxNumberOfComponents];
@@ -71,6 +87,15 @@ struct GtkColorComponentPrivate
 #endif
 };
 
+static void update_pipelines(GtkColorComponentPrivate *ns)
+{
+	ns->rgb_to_lab = RgbToLabPipeline(ns->lab_illuminant, ns->lab_observer);
+	ns->rgb_to_lch = RgbToLchPipeline(ns->lab_illuminant, ns->lab_observer);
+	ns->lab_to_rgb = LabToRgbPipeline(ns->lab_illuminant, ns->lab_observer);
+	ns->lch_to_rgb = LchToRgbPipeline(ns->lab_illuminant, ns->lab_observer);
+	for (int i = 0; i < MaxNumberOfComponents; i++)
+		ns->gradient_valid[i] = false;
+}
 static void gtk_color_component_class_init(GtkColorComponentClass *color_component_class)
 {
 	GObjectClass *obj_class = G_OBJECT_CLASS (color_component_class);
@@ -122,6 +147,8 @@ static void finalize(GObject *color_obj)
 		cairo_surface_destroy(ns->pattern_surface);
 	if (ns->pattern)
 		cairo_pattern_destroy(ns->pattern);
+	if (ns->gradient_surface)
+		cairo_surface_destroy(ns->gradient_surface);
 	gpointer parent_class = g_type_class_peek_parent(G_OBJECT_CLASS(GTK_COLOR_COMPONENT_GET_CLASS(color_obj)));
 	G_OBJECT_CLASS(parent_class)->finalize(color_obj);
 }
@@ -134,11 +161,13 @@ GtkWidget *gtk_color_component_new(GtkColorComponentComp component)
 	g_free(pattern_filename);
 	ns->pattern = cairo_pattern_create_for_surface(ns->pattern_surface);
 	cairo_pattern_set_extend(ns->pattern, CAIRO_EXTEND_REPEAT);
+	ns->gradient_surface = nullptr;
 	ns->component = component;
 	ns->last_event_position = -1;
 	ns->changing_color = false;
 	ns->lab_illuminant = REFERENCE_ILLUMINANT_D50;
 	ns->lab_observer= REFERENCE_OBSERVER_2;
+	update_pipelines(ns);
 	ns->out_of_gamut_mask = false;
 #if GTK_MAJOR_VERSION >= 3
 	ns->pointer_grab = nullptr;
@@ -251,31 +280,17 @@ void gtk_color_component_set_color(GtkColorComponent* color_component, Color* co
 			color_rgb_to_cmyk(&ns->orig_color, &ns->color);
 			break;
 		case GtkColorComponentComp::lab:
-			{
-				matrix3x3 adaptation_matrix;
-				color_get_chromatic_adaptation_matrix(color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2), color_get_reference(ns->lab_illuminant, ns->lab_observer), &adaptation_matrix);
-				color_rgb_to_lab(&ns->orig_color, &ns->color, color_get_reference(ns->lab_illuminant, ns->lab_observer), color_get_sRGB_transformation_matrix(), &adaptation_matrix);
-			}
+			ns->rgb_to_lab(&ns->orig_color, &ns->color);
 			break;
 		case GtkColorComponentComp::xyz:
 			//TODO: implement
 			break;
 		case GtkColorComponentComp::lch:
-			{
-				matrix3x3 adaptation_matrix;
-				color_get_chromatic_adaptation_matrix(color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2), color_get_reference(ns->lab_illuminant, ns->lab_observer), &adaptation_matrix);
-				color_rgb_to_lch(&ns->orig_color, &ns->color, color_get_reference(ns->lab_illuminant, ns->lab_observer), color_get_sRGB_transformation_matrix(), &adaptation_matrix);
-			}
+			ns->rgb_to_lch(&ns->orig_color, &ns->color);
 			break;
 	}
 	gtk_widget_queue_draw(GTK_WIDGET(color_component));
 }
-static void interpolate_colors(Color *color1, Color *color2, float position, Color *result)
-{
-	result->rgb.red = color1->rgb.red * (1 - position) + color2->rgb.red * position;
-	result->rgb.green= color1->rgb.green * (1 - position) + color2->rgb.green * position;
-	result->rgb.blue = color1->rgb.blue * (1 - position) + color2->rgb.blue * position;
-}
 #if GTK_MAJOR_VERSION >= 3
 #else
 static void size_request(GtkWidget *widget, GtkRequisition *requisition)
@@ -295,238 +310,163 @@ static int get_x_offset(GtkWidget *widget)
 	return widget->allocation.width - widget->style->xthickness * 2 - 240;
 #endif
 }
-static gboolean draw(GtkWidget *widget, cairo_t *cr)
+/** Convert channel value to 8-bit value. Values are truncated and clamped to 0-255 range. */
+static inline uint32_t pack_channel(float value)
 {
-	GtkColorComponentPrivate *ns = GET_PRIVATE(widget);
-	Color c[MaxNumberOfComponents];
-	double pointer_pos[MaxNumberOfComponents];
-	float steps;
-	int i, j;
-	for (int i = 0; i < ns->n_components; ++i){
-		pointer_pos[i] = (ns->color.ma[i] - ns->offset[i]) / ns->range[i];
+	value *= 255;
+	if (!(value > 0)) return 0;
+	if (value > 255) return 255;
+	return static_cast<uint32_t>(value);
+}
+/**
+ * Pack RGB channel values into opaque cairo ARGB32 pixels.
+ * @param[in] red Red channel values.
+ * @param[in] green Green channel values.
+ * @param[in] blue Blue channel values.
+ * @param[in] count Number of pixels.
+ * @param[out] pixels Destination pixels.
+ */
+static void pack_pixels_scalar(const float *red, const float *green, const float *blue, int count, uint32_t *pixels)
+{
+	for (int i = 0; i < count; i++){
+		pixels[i] = 0xff000000 | (pack_channel(red[i]) << 16) | (pack_channel(green[i]) << 8) | pack_channel(blue[i]);
+	}
+}
+#ifdef GPICK_X86_KERNELS
+GPICK_TARGET("sse2")
+static void pack_pixels_sse2(const float *red, const float *green, const float *blue, int count, uint32_t *pixels)
+{
+	const __m128 zero = _mm_setzero_ps(), scale = _mm_set1_ps(255.0f);
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+	int i = 0;
+	for (; i + 4 <= count; i += 4){
+		// max(value, 0) returns 0 for NaN values, same as scalar version
+		__m128i r = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(red + i), scale), zero), scale));
+		__m128i g = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(green + i), scale), zero), scale));
+		__m128i b = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(blue + i), scale), zero), scale));
+		__m128i argb = _mm_or_si128(_mm_or_si128(alpha, _mm_slli_epi32(r, 16)), _mm_or_si128(_mm_slli_epi32(g, 8), b));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), argb);
+	}
+	pack_pixels_scalar(red + i, green + i, blue + i, count - i, pixels + i);
+}
+#endif
+typedef void (*PackPixelsKernel)(const float *red, const float *green, const float *blue, int count, uint32_t *pixels);
+/**
+ * Check if gradient strip of a component was built for current color.
+ * Strip depends on all components except the one it shows.
+ */
+static bool is_gradient_valid(GtkColorComponentPrivate *ns, int component)
+{
+	if (!ns->gradient_valid[component]) return false;
+	for (int i = 0; i < ns->n_components; i++){
+		if (i != component && ns->gradient_color[component].ma[i] != ns->color.ma[i]) return false;
+	}
+	return true;
+}
+/**
+ * Convert colors at the ends of gradient segments to RGB and mark colors which are out of RGB gamut.
+ */
+static void build_gradient_points(GtkColorComponentPrivate *ns, int component, Color *points)
+{
+	const int count = GradientSteps + 1;
+	for (int i = 0; i < count; i++){
+		color_copy(&ns->color, &points[i]);
+		points[i].ma[component] = (i / float(GradientSteps)) * ns->range[component] + ns->offset[component];
 	}
-	cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 200, ns->n_components * 16);
-	unsigned char *data = cairo_image_surface_get_data(surface);
-	int stride = cairo_image_surface_get_stride(surface);
-	int surface_width = cairo_image_surface_get_width(surface);
-	unsigned char *col_ptr;
-	Color *rgb_points = new Color[ns->n_components * 200];
-	double int_part;
-	matrix3x3 adaptation_matrix;
-	vector<vector<bool> > out_of_gamut(MaxNumberOfComponents, vector<bool>(false, 1));
-	switch (ns->component) {
+	bool *out_of_gamut = ns->out_of_gamut[component];
+	memset(out_of_gamut, 0, sizeof(ns->out_of_gamut[component]));
+	switch (ns->component){
 		case GtkColorComponentComp::rgb:
-			steps = 1;
-			for (i = 0; i < 3; ++i){
-				color_copy(&ns->color, &c[i]);
-			}
-			for (i = 0; i < surface_width; ++i){
-				c[0].rgb.red = c[1].rgb.green = c[2].rgb.blue = (float)i / (float)(surface_width - 1);
-				col_ptr = data + i * 4;
-				for (int y = 0; y < ns->n_components * 16; ++y){
-					if ((y & 0x0f) != 0x0f){
-						col_ptr[2] = (unsigned char)(c[y / 16].rgb.red * 255);
-						col_ptr[1] = (unsigned char)(c[y / 16].rgb.green * 255);
-						col_ptr[0] = (unsigned char)(c[y / 16].rgb.blue * 255);
-						col_ptr[3] = 0xff;
-					}else{
-						col_ptr[0] = 0x00;
-						col_ptr[1] = 0x00;
-						col_ptr[2] = 0x00;
-						col_ptr[3] = 0x00;
-					}
-					col_ptr += stride;
-				}
-			}
 			break;
 		case GtkColorComponentComp::hsv:
-			steps = 100;
-			for (i = 0; i < 3; ++i){
-				color_copy(&ns->color, &c[i]);
-			}
-			for (i = 0; i <= steps; ++i){
-				c[0].hsv.hue = c[1].hsv.saturation = c[2].hsv.value = i / steps;
-				for (j = 0; j < 3; ++j){
-					color_hsv_to_rgb(&c[j], &rgb_points[j * (int(steps) + 1) + i]);
-				}
-			}
-			for (i = 0; i < surface_width; ++i){
-				float position = modf(i * steps / surface_width, &int_part);
-				int index = i * int(steps) / surface_width;
-				interpolate_colors(&rgb_points[0 * (int(steps) + 1) + index], &rgb_points[0 * (int(steps) + 1) + index + 1], position, &c[0]);
-				interpolate_colors(&rgb_points[1 * (int(steps) + 1) + index], &rgb_points[1 * (int(steps) + 1) + index + 1], position, &c[1]);
-				interpolate_colors(&rgb_points[2 * (int(steps) + 1) + index], &rgb_points[2 * (int(steps) + 1) + index + 1], position, &c[2]);
-				col_ptr = data + i * 4;
-				for (int y = 0; y < ns->n_components * 16; ++y){
-					if ((y & 0x0f) != 0x0f){
-						col_ptr[2] = (unsigned char)(c[y / 16].rgb.red * 255);
-						col_ptr[1] = (unsigned char)(c[y / 16].rgb.green * 255);
-						col_ptr[0] = (unsigned char)(c[y / 16].rgb.blue * 255);
-						col_ptr[3] = 0xff;
-					}else{
-						col_ptr[0] = 0x00;
-						col_ptr[1] = 0x00;
-						col_ptr[2] = 0x00;
-						col_ptr[3] = 0x00;
-					}
-					col_ptr += stride;
-				}
-			}
+			color_hsv_to_rgb_batch(points, points, count);
 			break;
 		case GtkColorComponentComp::hsl:
-			steps = 100;
-			for (i = 0; i < 3; ++i){
-				color_copy(&ns->color, &c[i]);
-			}
-			for (i = 0; i <= steps; ++i){
-				c[0].hsl.hue = c[1].hsl.saturation = c[2].hsl.lightness = i / steps;
-				for (j = 0; j < 3; ++j){
-					color_hsl_to_rgb(&c[j], &rgb_points[j * (int(steps) + 1) + i]);
-				}
-			}
-			for (i = 0; i < surface_width; ++i){
-				float position = modf(i * steps / surface_width, &int_part);
-				int index = i * int(steps) / surface_width;
-				interpolate_colors(&rgb_points[0 * (int(steps) + 1) + index], &rgb_points[0 * (int(steps) + 1) + index + 1], position, &c[0]);
-				interpolate_colors(&rgb_points[1 * (int(steps) + 1) + index], &rgb_points[1 * (int(steps) + 1) + index + 1], position, &c[1]);
-				interpolate_colors(&rgb_points[2 * (int(steps) + 1) + index], &rgb_points[2 * (int(steps) + 1) + index + 1], position, &c[2]);
-				col_ptr = data + i * 4;
-				for (int y = 0; y < ns->n_components * 16; ++y){
-					if ((y & 0x0f) != 0x0f){
-						col_ptr[2] = (unsigned char)(c[y / 16].rgb.red * 255);
-						col_ptr[1] = (unsigned char)(c[y / 16].rgb.green * 255);
-						col_ptr[0] = (unsigned char)(c[y / 16].rgb.blue * 255);
-						col_ptr[3] = 0xff;
-					}else{
-						col_ptr[0] = 0x00;
-						col_ptr[1] = 0x00;
-						col_ptr[2] = 0x00;
-						col_ptr[3] = 0x00;
-					}
-					col_ptr += stride;
-				}
-			}
+			color_hsl_to_rgb_batch(points, points, count);
 			break;
 		case GtkColorComponentComp::cmyk:
-			steps = 100;
-			for (i = 0; i < 4; ++i){
-				color_copy(&ns->color, &c[i]);
-			}
-			for (i = 0; i <= steps; ++i){
-				c[0].cmyk.c = c[1].cmyk.m = c[2].cmyk.y = c[3].cmyk.k = i / steps;
-				for (j = 0; j < 4; ++j){
-					color_cmyk_to_rgb(&c[j], &rgb_points[j * (int(steps) + 1) + i]);
-				}
-			}
-			for (i = 0; i < surface_width; ++i){
-				float position = modf(i * steps / surface_width, &int_part);
-				int index = i * int(steps) / surface_width;
-				interpolate_colors(&rgb_points[0 * (int(steps) + 1) + index], &rgb_points[0 * (int(steps) + 1) + index + 1], position, &c[0]);
-				interpolate_colors(&rgb_points[1 * (int(steps) + 1) + index], &rgb_points[1 * (int(steps) + 1) + index + 1], position, &c[1]);
-				interpolate_colors(&rgb_points[2 * (int(steps) + 1) + index], &rgb_points[2 * (int(steps) + 1) + index + 1], position, &c[2]);
-				interpolate_colors(&rgb_points[3 * (int(steps) + 1) + index], &rgb_points[3 * (int(steps) + 1) + index + 1], position, &c[3]);
-				col_ptr = data + i * 4;
-				for (int y = 0; y < ns->n_components * 16; ++y){
-					if ((y & 0x0f) != 0x0f){
-						col_ptr[2] = (unsigned char)(c[y / 16].rgb.red * 255);
-						col_ptr[1] = (unsigned char)(c[y / 16].rgb.green * 255);
-						col_ptr[0] = (unsigned char)(c[y / 16].rgb.blue * 255);
-						col_ptr[3] = 0xff;
-					}else{
-						col_ptr[0] = 0x00;
-						col_ptr[1] = 0x00;
-						col_ptr[2] = 0x00;
-						col_ptr[3] = 0x00;
-					}
-					col_ptr += stride;
-				}
-			}
+			for (int i = 0; i < count; i++)
+				color_cmyk_to_rgb(&points[i], &points[i]);
 			break;
 		case GtkColorComponentComp::lab:
-			steps = 100;
-			color_get_chromatic_adaptation_matrix(color_get_reference(ns->lab_illuminant, ns->lab_observer), color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2), &adaptation_matrix);
-			for (j = 0; j < 3; ++j){
-				color_copy(&ns->color, &c[j]);
-				out_of_gamut[j] = vector<bool>(steps + 1, false);
-				for (i = 0; i <= steps; ++i){
-					c[j].ma[j] = (i / steps) * ns->range[j] + ns->offset[j];
-					color_lab_to_rgb(&c[j], &rgb_points[j * (int(steps) + 1) + i], color_get_reference(ns->lab_illuminant, ns->lab_observer), color_get_inverted_sRGB_transformation_matrix(), &adaptation_matrix);
-					if (color_is_rgb_out_of_gamut(&rgb_points[j * (int(steps) + 1) + i])){
-						out_of_gamut[j][i] = true;
-					}
-					color_rgb_normalize(&rgb_points[j * (int(steps) + 1) + i]);
-				}
-			}
-			for (i = 0; i < surface_width; ++i){
-				float position = modf(i * steps / surface_width, &int_part);
-				int index = i * int(steps) / surface_width;
-				interpolate_colors(&rgb_points[0 * (int(steps) + 1) + index], &rgb_points[0 * (int(steps) + 1) + index + 1], position, &c[0]);
-				interpolate_colors(&rgb_points[1 * (int(steps) + 1) + index], &rgb_points[1 * (int(steps) + 1) + index + 1], position, &c[1]);
-				interpolate_colors(&rgb_points[2 * (int(steps) + 1) + index], &rgb_points[2 * (int(steps) + 1) + index + 1], position, &c[2]);
-				col_ptr = data + i * 4;
-				for (int y = 0; y < ns->n_components * 16; ++y){
-					if ((y & 0x0f) != 0x0f){
-						col_ptr[2] = (unsigned char)(c[y / 16].rgb.red * 255);
-						col_ptr[1] = (unsigned char)(c[y / 16].rgb.green * 255);
-						col_ptr[0] = (unsigned char)(c[y / 16].rgb.blue * 255);
-						col_ptr[3] = 0xff;
-					}else{
-						col_ptr[0] = 0x00;
-						col_ptr[1] = 0x00;
-						col_ptr[2] = 0x00;
-						col_ptr[3] = 0x00;
-					}
-					col_ptr += stride;
-				}
-			}
-			break;
 		case GtkColorComponentComp::lch:
-			steps = 100;
-			color_get_chromatic_adaptation_matrix(color_get_reference(ns->lab_illuminant, ns->lab_observer), color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2), &adaptation_matrix);
-			for (j = 0; j < 3; ++j){
-				color_copy(&ns->color, &c[j]);
-				out_of_gamut[j] = vector<bool>(steps + 1, false);
-				for (i = 0; i <= steps; ++i){
-					c[j].ma[j] = (i / steps) * ns->range[j] + ns->offset[j];
-					color_lch_to_rgb(&c[j], &rgb_points[j * (int(steps) + 1) + i], color_get_reference(ns->lab_illuminant, ns->lab_observer), color_get_inverted_sRGB_transformation_matrix(), &adaptation_matrix);
-					if (color_is_rgb_out_of_gamut(&rgb_points[j * (int(steps) + 1) + i])){
-						out_of_gamut[j][i] = true;
-					}
-					color_rgb_normalize(&rgb_points[j * (int(steps) + 1) + i]);
-				}
-			}
-			for (i = 0; i < surface_width; ++i){
-				float position = modf(i * steps / surface_width, &int_part);
-				int index = i * int(steps) / surface_width;
-				interpolate_colors(&rgb_points[0 * (int(steps) + 1) + index], &rgb_points[0 * (int(steps) + 1) + index + 1], position, &c[0]);
-				interpolate_colors(&rgb_points[1 * (int(steps) + 1) + index], &rgb_points[1 * (int(steps) + 1) + index + 1], position, &c[1]);
-				interpolate_colors(&rgb_points[2 * (int(steps) + 1) + index], &rgb_points[2 * (int(steps) + 1) + index + 1], position, &c[2]);
-				col_ptr = data + i * 4;
-				for (int y = 0; y < ns->n_components * 16; ++y){
-					if ((y & 0x0f) != 0x0f){
-						col_ptr[2] = (unsigned char)(c[y / 16].rgb.red * 255);
-						col_ptr[1] = (unsigned char)(c[y / 16].rgb.green * 255);
-						col_ptr[0] = (unsigned char)(c[y / 16].rgb.blue * 255);
-						col_ptr[3] = 0xff;
-					}else{
-						col_ptr[0] = 0x00;
-						col_ptr[1] = 0x00;
-						col_ptr[2] = 0x00;
-						col_ptr[3] = 0x00;
-					}
-					col_ptr += stride;
-				}
+			if (ns->component == GtkColorComponentComp::lab)
+				ns->lab_to_rgb(points, points, count);
+			else
+				ns->lch_to_rgb(points, points, count);
+			for (int i = 0; i < count; i++){
+				out_of_gamut[i] = color_is_rgb_out_of_gamut(&points[i]);
+				color_rgb_normalize(&points[i]);
 			}
 			break;
 		default:
 			break;
 	}
-	delete [] rgb_points;
-	cairo_surface_mark_dirty(surface);
+}
+/**
+ * Rebuild gradient strip of one component. Gradient row is interpolated from segment end colors, packed into pixels and copied into all strip rows except the last one, which stays transparent.
+ */
+static void build_gradient(GtkColorComponentPrivate *ns, int component)
+{
+	PackPixelsKernel pack_pixels = simd_select<PackPixelsKernel>(pack_pixels_scalar, GPICK_KERNEL(pack_pixels_sse2));
+	Color points[GradientSteps + 1];
+	float red[GradientWidth], green[GradientWidth], blue[GradientWidth];
+	uint32_t row[GradientWidth];
+	if (ns->component == GtkColorComponentComp::rgb){
+		// RGB gradients are linear, so channel values are calculated directly
+		for (int i = 0; i < GradientWidth; i++){
+			red[i] = ns->color.rgb.red;
+			green[i] = ns->color.rgb.green;
+			blue[i] = ns->color.rgb.blue;
+		}
+		float *channel = component == 0 ? red : (component == 1 ? green : blue);
+		for (int i = 0; i < GradientWidth; i++)
+			channel[i] = i / float(GradientWidth - 1);
+		memset(ns->out_of_gamut[component], 0, sizeof(ns->out_of_gamut[component]));
+	}else{
+		build_gradient_points(ns, component, points);
+		for (int i = 0; i < GradientWidth; i++){
+			int index = i * GradientSteps / GradientWidth;
+			float position = i * float(GradientSteps) / GradientWidth - index;
+			const Color &a = points[index], &b = points[index + 1];
+			red[i] = a.rgb.red * (1 - position) + b.rgb.red * position;
+			green[i] = a.rgb.green * (1 - position) + b.rgb.green * position;
+			blue[i] = a.rgb.blue * (1 - position) + b.rgb.blue * position;
+		}
+	}
+	pack_pixels(red, green, blue, GradientWidth, row);
+	cairo_surface_flush(ns->gradient_surface);
+	unsigned char *data = cairo_image_surface_get_data(ns->gradient_surface);
+	int stride = cairo_image_surface_get_stride(ns->gradient_surface);
+	for (int y = 0; y < ComponentHeight; y++){
+		unsigned char *line = data + (component * ComponentHeight + y) * stride;
+		if (y < ComponentHeight - 1)
+			memcpy(line, row, sizeof(row));
+		else
+			memset(line, 0, sizeof(row));
+	}
+	cairo_surface_mark_dirty_rectangle(ns->gradient_surface, 0, component * ComponentHeight, GradientWidth, ComponentHeight);
+	color_copy(&ns->color, &ns->gradient_color[component]);
+	ns->gradient_valid[component] = true;
+}
+static gboolean draw(GtkWidget *widget, cairo_t *cr)
+{
+	GtkColorComponentPrivate *ns = GET_PRIVATE(widget);
+	double pointer_pos[MaxNumberOfComponents];
+	int i;
+	for (int i = 0; i < ns->n_components; ++i){
+		pointer_pos[i] = (ns->color.ma[i] - ns->offset[i]) / ns->range[i];
+	}
+	if (!ns->gradient_surface){
+		ns->gradient_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, GradientWidth, ns->n_components * ComponentHeight);
+	}
+	for (i = 0; i < ns->n_components; ++i){
+		if (!is_gradient_valid(ns, i))
+			build_gradient(ns, i);
+	}
 	cairo_save(cr);
 	int offset_x = get_x_offset(widget);
-	cairo_set_source_surface(cr, surface, offset_x, 0);
-	cairo_surface_destroy(surface);
+	cairo_set_source_surface(cr, ns->gradient_surface, offset_x, 0);
 	for (i = 0; i < ns->n_components; ++i){
 		cairo_rectangle(cr, offset_x, 16 * i, 200, 15);
 		cairo_fill(cr);
@@ -537,25 +477,27 @@ static gboolean draw(GtkWidget *widget, cairo_t *cr)
 		cairo_matrix_init_translate(&matrix, -offset_x - 64, -64 + 5 * i);
 		cairo_pattern_set_matrix(ns->pattern, &matrix);
 		if (ns->out_of_gamut_mask){
+			const bool *out_of_gamut = ns->out_of_gamut[i];
+			const int count = GradientSteps + 1;
 			int first_out_of_gamut = 0;
 			bool out_of_gamut_found = false;
 			cairo_set_source(cr, ns->pattern);
-			for (size_t j = 0; j < out_of_gamut[i].size(); j++){
-				if (out_of_gamut[i][j]){
+			for (int j = 0; j < count; j++){
+				if (out_of_gamut[j]){
 					if (!out_of_gamut_found){
 						out_of_gamut_found = true;
 						first_out_of_gamut = j;
 					}
 				}else{
 					if (out_of_gamut_found){
-						cairo_rectangle(cr, offset_x + (first_out_of_gamut * 200.0 / out_of_gamut[i].size()), 16 * i, (j - first_out_of_gamut) * 200.0 / out_of_gamut[i].size(), 15);
+						cairo_rectangle(cr, offset_x + (first_out_of_gamut * 200.0 / count), 16 * i, (j - first_out_of_gamut) * 200.0 / count, 15);
 						cairo_fill(cr);
 						out_of_gamut_found = false;
 					}
 				}
 			}
 			if (out_of_gamut_found){
-				cairo_rectangle(cr, offset_x + (first_out_of_gamut * 200.0 / out_of_gamut[i].size()), 16 * i, (out_of_gamut[i].size() - first_out_of_gamut) * 200.0 / out_of_gamut[i].size(), 15);
+				cairo_rectangle(cr, offset_x + (first_out_of_gamut * 200.0 / count), 16 * i, (count - first_out_of_gamut) * 200.0 / count, 15);
 				cairo_fill(cr);
 			}
 		}
@@ -651,23 +593,15 @@ static void update_rgb_color(GtkColorComponentPrivate *ns, Color *c)
 			color_rgb_normalize(c);
 			break;
 		case GtkColorComponentComp::lab:
-			{
-				matrix3x3 adaptation_matrix;
-				color_get_chromatic_adaptation_matrix(color_get_reference(ns->lab_illuminant, ns->lab_observer), color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2), &adaptation_matrix);
-				color_lab_to_rgb(&ns->color, c, color_get_reference(ns->lab_illuminant, ns->lab_observer), color_get_inverted_sRGB_transformation_matrix(), &adaptation_matrix);
-				color_rgb_normalize(c);
-			}
+			ns->lab_to_rgb(&ns->color, c);
+			color_rgb_normalize(c);
 			break;
 		case GtkColorComponentComp::xyz:
 			//TODO: implement
 			break;
 		case GtkColorComponentComp::lch:
-			{
-				matrix3x3 adaptation_matrix;
-				color_get_chromatic_adaptation_matrix(color_get_reference(ns->lab_illuminant, ns->lab_observer), color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2), &adaptation_matrix);
-				color_lch_to_rgb(&ns->color, c, color_get_reference(ns->lab_illuminant, ns->lab_observer), color_get_inverted_sRGB_transformation_matrix(), &adaptation_matrix);
-				color_rgb_normalize(c);
-			}
+			ns->lch_to_rgb(&ns->color, c);
+			color_rgb_normalize(c);
 			break;
 	}
 }
@@ -760,6 +694,7 @@ void gtk_color_component_set_lab_illuminant(GtkColorComponent* color_component,
 {
 	GtkColorComponentPrivate *ns = GET_PRIVATE(color_component);
 	ns->lab_illuminant = illuminant;
+	update_pipelines(ns);
 	gtk_color_component_set_color(color_component, &ns->orig_color);
 	gtk_widget_queue_draw(GTK_WIDGET(color_component));
 }
@@ -767,6 +702,7 @@ void gtk_color_component_set_lab_observer(GtkColorComponent* color_component, Re
 {
 	GtkColorComponentPrivate *ns = GET_PRIVATE(color_component);
 	ns->lab_observer = observer;
+	update_pipelines(ns);
 	gtk_color_component_set_color(color_component, &ns->orig_color);
 	gtk_widget_queue_draw(GTK_WIDGET(color_component));
 }
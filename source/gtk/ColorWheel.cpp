@@ -25,8 +25,12 @@
 #define M_PI 3.14159265359
 #endif
 #include <stdlib.h>
+#include <stdint.h>
 #include <list>
 #include <iostream>
+#ifdef GPICK_X86_KERNELS
+#include <immintrin.h>
+#endif
 using namespace std;
 
 #define GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), GTK_TYPE_COLOR_WHEEL, GtkColorWheelPrivate))
@@ -56,6 +60,27 @@ struct ColorPoint
 	double lightness;
 	double saturation;
 };
+/** Number of cached wheel rings, one for each recently used wheel type */
+static const int WheelRingCacheSize = 4;
+/** Number of cached saturation/value blocks */
+static const int SatValBlockCacheSize = 8;
+/** Number of hue values blocks are generated for. Each sixth of the hue circle is split into 256 steps, so quantization changes channel values by less than one 8-bit level. */
+static const int SatValBlockHueSteps = 6 * 256;
+struct WheelRingCache
+{
+	const ColorWheelType *color_wheel_type;
+	double radius;
+	double width;
+	cairo_surface_t *surface;
+	uint32_t last_used;
+};
+struct SatValBlockCache
+{
+	int hue;
+	int size;
+	cairo_surface_t *surface;
+	uint32_t last_used;
+};
 struct GtkColorWheelPrivate
 {
 	ColorPoint cpoint[10];
@@ -69,7 +94,9 @@ struct GtkColorWheelPrivate
 	double block_size;
 	bool block_editable;
 	const ColorWheelType *color_wheel_type;
-	cairo_surface_t *cache_color_wheel;
+	WheelRingCache ring_cache[WheelRingCacheSize];
+	SatValBlockCache block_cache[SatValBlockCacheSize];
+	uint32_t cache_clock;
 #if GTK_MAJOR_VERSION >= 3
 	GdkDevice *pointer_grab;
 #endif
@@ -77,9 +104,17 @@ struct GtkColorWheelPrivate
 static void finalize(GObject *color_wheel_obj)
 {
 	GtkColorWheelPrivate *ns = GET_PRIVATE(color_wheel_obj);
-	if (ns->cache_color_wheel){
-		cairo_surface_destroy(ns->cache_color_wheel);
-		ns->cache_color_wheel = 0;
+	for (int i = 0; i < WheelRingCacheSize; i++){
+		if (ns->ring_cache[i].surface){
+			cairo_surface_destroy(ns->ring_cache[i].surface);
+			ns->ring_cache[i].surface = nullptr;
+		}
+	}
+	for (int i = 0; i < SatValBlockCacheSize; i++){
+		if (ns->block_cache[i].surface){
+			cairo_surface_destroy(ns->block_cache[i].surface);
+			ns->block_cache[i].surface = nullptr;
+		}
 	}
 	G_OBJECT_CLASS(parent_class)->finalize(color_wheel_obj);
 }
@@ -124,7 +159,15 @@ GtkWidget* gtk_color_wheel_new()
 	ns->selected = &ns->cpoint[0];
 	ns->block_editable = true;
 	ns->color_wheel_type = &color_wheel_types_get()[0];
-	ns->cache_color_wheel = 0;
+	for (int i = 0; i < WheelRingCacheSize; i++){
+		ns->ring_cache[i].surface = nullptr;
+		ns->ring_cache[i].last_used = 0;
+	}
+	for (int i = 0; i < SatValBlockCacheSize; i++){
+		ns->block_cache[i].surface = nullptr;
+		ns->block_cache[i].last_used = 0;
+	}
+	ns->cache_clock = 0;
 #if GTK_MAJOR_VERSION >= 3
 	ns->pointer_grab = nullptr;
 #endif
@@ -136,10 +179,6 @@ void gtk_color_wheel_set_color_wheel_type(GtkColorWheel *color_wheel, const Colo
 	GtkColorWheelPrivate *ns = GET_PRIVATE(color_wheel);
 	if (ns->color_wheel_type != color_wheel_type){
 		ns->color_wheel_type = color_wheel_type;
-		if (ns->cache_color_wheel){
-			cairo_surface_destroy(ns->cache_color_wheel);
-			ns->cache_color_wheel = 0;
-		}
 		gtk_widget_queue_draw(GTK_WIDGET(color_wheel));
 	}
 }
@@ -238,78 +277,202 @@ static void draw_dot(cairo_t *cr, double x, double y, double size)
 	cairo_set_line_width(cr, 1);
 	cairo_stroke(cr);
 }
-static void draw_sat_val_block(cairo_t *cr, double pos_x, double pos_y, double size, double hue)
+/**
+ * Get HSV to RGB conversion factors for constant hue. Each channel value is value * (1 - saturation * factor), which gives the same result as color_hsv_to_rgb().
+ * @param[in] hue Hue.
+ * @param[out] factors Red, green and blue channel factors.
+ */
+static void get_hue_factors(float hue, float factors[3])
 {
-	cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, ceil(size), ceil(size));
+	float h = (hue - floor(hue)) * 6.0f;
+	int i = int(h);
+	float f = h - floor(h);
+	float x = 1.0f, y = f, z = 1.0f - f, v = 0.0f;
+	const float table[6][3] = {
+		{v, z, x},
+		{y, v, x},
+		{x, v, z},
+		{x, y, v},
+		{z, x, v},
+		{v, x, y},
+	};
+	const float *row = table[i < 5 ? i : 5];
+	factors[0] = row[0];
+	factors[1] = row[1];
+	factors[2] = row[2];
+}
+/**
+ * Fill part of one row of saturation/value block with opaque cairo ARGB32 pixels. Saturation changes in 1 / size steps and is first / size at the first pixel.
+ * @param[in] factors Channel factors from get_hue_factors().
+ * @param[in] value Value of all pixels in the row.
+ * @param[in] size Block size.
+ * @param[in] first Position of the first pixel in the row.
+ * @param[in] count Number of pixels.
+ * @param[out] pixels Destination pixels.
+ */
+static void fill_sat_val_row_scalar(const float factors[3], float value, float size, int first, int count, uint32_t *pixels)
+{
+	for (int x = 0; x < count; x++){
+		float saturation = (first + x) / size;
+		uint32_t red = static_cast<unsigned char>(value * (1.0f - saturation * factors[0]) * 255);
+		uint32_t green = static_cast<unsigned char>(value * (1.0f - saturation * factors[1]) * 255);
+		uint32_t blue = static_cast<unsigned char>(value * (1.0f - saturation * factors[2]) * 255);
+		pixels[x] = 0xff000000 | (red << 16) | (green << 8) | blue;
+	}
+}
+#ifdef GPICK_X86_KERNELS
+GPICK_TARGET("sse2")
+static void fill_sat_val_row_sse2(const float factors[3], float value, float size, int first, int count, uint32_t *pixels)
+{
+	const __m128 one = _mm_set1_ps(1.0f), scale = _mm_set1_ps(255.0f), v = _mm_set1_ps(value), divisor = _mm_set1_ps(size);
+	const __m128 fr = _mm_set1_ps(factors[0]), fg = _mm_set1_ps(factors[1]), fb = _mm_set1_ps(factors[2]);
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+	__m128 position = _mm_add_ps(_mm_set1_ps(static_cast<float>(first)), _mm_set_ps(3, 2, 1, 0));
+	const __m128 step = _mm_set1_ps(4);
+	int x = 0;
+	for (; x + 4 <= count; x += 4){
+		__m128 saturation = _mm_div_ps(position, divisor);
+		__m128i r = _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(v, _mm_sub_ps(one, _mm_mul_ps(saturation, fr))), scale));
+		__m128i g = _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(v, _mm_sub_ps(one, _mm_mul_ps(saturation, fg))), scale));
+		__m128i b = _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(v, _mm_sub_ps(one, _mm_mul_ps(saturation, fb))), scale));
+		__m128i argb = _mm_or_si128(_mm_or_si128(alpha, _mm_slli_epi32(r, 16)), _mm_or_si128(_mm_slli_epi32(g, 8), b));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + x), argb);
+		position = _mm_add_ps(position, step);
+	}
+	fill_sat_val_row_scalar(factors, value, size, first + x, count - x, pixels + x);
+}
+#endif
+typedef void (*FillSatValRowKernel)(const float factors[3], float value, float size, int first, int count, uint32_t *pixels);
+static void fill_sat_val_block(cairo_surface_t *surface, double size, double hue)
+{
+	FillSatValRowKernel fill_sat_val_row = simd_select<FillSatValRowKernel>(fill_sat_val_row_scalar, GPICK_KERNEL(fill_sat_val_row_sse2));
+	cairo_surface_flush(surface);
 	unsigned char *data = cairo_image_surface_get_data(surface);
 	int stride = cairo_image_surface_get_stride(surface);
 	int surface_width = cairo_image_surface_get_width(surface);
 	int surface_height = cairo_image_surface_get_height(surface);
-	Color c;
-	unsigned char *line_data;
+	float factors[3];
+	get_hue_factors(hue, factors);
 	for (int y = 0; y < surface_height; ++y){
-		line_data = data + stride * y;
-		for (int x = 0; x < surface_width; ++x){
-			c.hsv.hue = hue;
-			c.hsv.saturation = x / size;
-			c.hsv.value = y / size;
-			color_hsv_to_rgb(&c, &c);
-			line_data[2] = c.rgb.red * 255;
-			line_data[1] = c.rgb.green * 255;
-			line_data[0] = c.rgb.blue * 255;
-			line_data[3] = 0xFF;
-			line_data += 4;
-		}
+		fill_sat_val_row(factors, static_cast<float>(y / size), static_cast<float>(size), 0, surface_width, reinterpret_cast<uint32_t*>(data + stride * y));
 	}
 	cairo_surface_mark_dirty(surface);
+}
+/**
+ * Get saturation/value block surface for a hue. Blocks are cached for quantized hue values and least recently used block is replaced on cache miss.
+ */
+static cairo_surface_t *get_sat_val_block(GtkColorWheelPrivate *ns, double size, double hue)
+{
+	int hue_index = int((hue - floor(hue)) * SatValBlockHueSteps + 0.5) % SatValBlockHueSteps;
+	int pixel_size = ceil(size);
+	SatValBlockCache *entry = nullptr;
+	for (int i = 0; i < SatValBlockCacheSize; i++){
+		SatValBlockCache &block = ns->block_cache[i];
+		if (block.surface && block.hue == hue_index && block.size == pixel_size){
+			block.last_used = ++ns->cache_clock;
+			return block.surface;
+		}
+		if (!entry || !block.surface || (entry->surface && block.last_used < entry->last_used))
+			entry = &block;
+	}
+	if (entry->surface && entry->size != pixel_size){
+		cairo_surface_destroy(entry->surface);
+		entry->surface = nullptr;
+	}
+	if (!entry->surface){
+		cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, pixel_size, pixel_size);
+		if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS){
+			cerr << "ColorWheel image surface allocation failed" << endl;
+			cairo_surface_destroy(surface);
+			return nullptr;
+		}
+		entry->surface = surface;
+	}
+	fill_sat_val_block(entry->surface, size, double(hue_index) / SatValBlockHueSteps);
+	entry->hue = hue_index;
+	entry->size = pixel_size;
+	entry->last_used = ++ns->cache_clock;
+	return entry->surface;
+}
+static void draw_sat_val_block(GtkColorWheelPrivate *ns, cairo_t *cr, double pos_x, double pos_y, double size, double hue)
+{
+	cairo_surface_t *surface = get_sat_val_block(ns, size, hue);
+	if (!surface) return;
 	cairo_save(cr);
 	cairo_set_source_surface(cr, surface, pos_x - size / 2, pos_y - size / 2);
-	cairo_surface_destroy(surface);
 	cairo_rectangle(cr, pos_x - size / 2, pos_y - size / 2, size, size);
 	cairo_fill(cr);
 	cairo_restore(cr);
 }
-static void draw_wheel(GtkColorWheelPrivate *ns, cairo_t *cr, double radius, double width, const ColorWheelType *wheel)
+static cairo_surface_t *create_wheel_ring(double radius, double width, const ColorWheelType *wheel)
 {
-	cairo_surface_t *surface;
 	double inner_radius = radius - width;
-	if (ns->cache_color_wheel){
-		surface = ns->cache_color_wheel;
-	}else{
-		surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, ceil(radius * 2), ceil(radius * 2));
-		if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS){
-			cerr << "ColorWheel image surface allocation failed" << endl;
-			return;
-		}
-		unsigned char *data = cairo_image_surface_get_data(surface);
-		int stride = cairo_image_surface_get_stride(surface);
-		int surface_width = cairo_image_surface_get_width(surface);
-		int surface_height = cairo_image_surface_get_height(surface);
-		double radius_sq = radius * radius + 2 * radius + 1;
-		double inner_radius_sq = inner_radius * inner_radius - 2 * inner_radius + 1;
-		Color c;
-		unsigned char *line_data;
-		for (int y = 0; y < surface_height; ++y){
-			line_data = data + stride * y;
-			for (int x = 0; x < surface_width; ++x){
-				int dx = -(x - surface_width / 2);
-				int dy = y - surface_height / 2;
-				int dist = dx * dx + dy * dy;
-				if ((dist >= inner_radius_sq) && (dist <= radius_sq)){
-					double angle = atan2((double)dx, (double)dy) + M_PI;
-					wheel->hue_to_hsl(angle / (M_PI * 2), &c);
-					color_hsl_to_rgb(&c, &c);
-					line_data[2] = c.rgb.red * 255;
-					line_data[1] = c.rgb.green * 255;
-					line_data[0] = c.rgb.blue * 255;
-					line_data[3] = 0xFF;
-				}
-				line_data += 4;
+	cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, ceil(radius * 2), ceil(radius * 2));
+	if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS){
+		cerr << "ColorWheel image surface allocation failed" << endl;
+		cairo_surface_destroy(surface);
+		return nullptr;
+	}
+	unsigned char *data = cairo_image_surface_get_data(surface);
+	int stride = cairo_image_surface_get_stride(surface);
+	int surface_width = cairo_image_surface_get_width(surface);
+	int surface_height = cairo_image_surface_get_height(surface);
+	double radius_sq = radius * radius + 2 * radius + 1;
+	double inner_radius_sq = inner_radius * inner_radius - 2 * inner_radius + 1;
+	Color c;
+	unsigned char *line_data;
+	for (int y = 0; y < surface_height; ++y){
+		line_data = data + stride * y;
+		for (int x = 0; x < surface_width; ++x){
+			int dx = -(x - surface_width / 2);
+			int dy = y - surface_height / 2;
+			int dist = dx * dx + dy * dy;
+			if ((dist >= inner_radius_sq) && (dist <= radius_sq)){
+				double angle = atan2((double)dx, (double)dy) + M_PI;
+				wheel->hue_to_hsl(angle / (M_PI * 2), &c);
+				color_hsl_to_rgb(&c, &c);
+				line_data[2] = c.rgb.red * 255;
+				line_data[1] = c.rgb.green * 255;
+				line_data[0] = c.rgb.blue * 255;
+				line_data[3] = 0xFF;
 			}
+			line_data += 4;
 		}
-		ns->cache_color_wheel = surface;
 	}
 	cairo_surface_mark_dirty(surface);
+	return surface;
+}
+/**
+ * Get wheel ring surface. Rings are cached for each size and wheel type and least recently used ring is replaced on cache miss.
+ */
+static cairo_surface_t *get_wheel_ring(GtkColorWheelPrivate *ns, double radius, double width, const ColorWheelType *wheel)
+{
+	WheelRingCache *entry = nullptr;
+	for (int i = 0; i < WheelRingCacheSize; i++){
+		WheelRingCache &ring = ns->ring_cache[i];
+		if (ring.surface && ring.color_wheel_type == wheel && ring.radius == radius && ring.width == width){
+			ring.last_used = ++ns->cache_clock;
+			return ring.surface;
+		}
+		if (!entry || !ring.surface || (entry->surface && ring.last_used < entry->last_used))
+			entry = &ring;
+	}
+	cairo_surface_t *surface = create_wheel_ring(radius, width, wheel);
+	if (!surface) return nullptr;
+	if (entry->surface)
+		cairo_surface_destroy(entry->surface);
+	entry->surface = surface;
+	entry->color_wheel_type = wheel;
+	entry->radius = radius;
+	entry->width = width;
+	entry->last_used = ++ns->cache_clock;
+	return surface;
+}
+static void draw_wheel(GtkColorWheelPrivate *ns, cairo_t *cr, double radius, double width, const ColorWheelType *wheel)
+{
+	cairo_surface_t *surface = get_wheel_ring(ns, radius, width, wheel);
+	if (!surface) return;
+	double inner_radius = radius - width;
 	cairo_save(cr);
 	cairo_set_source_surface(cr, surface, 0, 0);
 	cairo_set_line_width(cr, width);
@@ -393,7 +556,7 @@ static gboolean draw(GtkWidget *widget, cairo_t *cr)
 		double block_size = 2 * (ns->radius - ns->circle_width) * sin(M_PI / 4) - 6;
 		Color hsl;
 		ns->color_wheel_type->hue_to_hsl(ns->selected->hue, &hsl);
-		draw_sat_val_block(cr, ns->radius, ns->radius, block_size, hsl.hsl.hue);
+		draw_sat_val_block(ns, cr, ns->radius, ns->radius, block_size, hsl.hsl.hue);
 		draw_dot(cr, ns->radius - block_size / 2 + block_size * ns->selected->saturation, ns->radius - block_size / 2 + block_size * ns->selected->lightness, 4);
 	}
 	for (uint32_t i = 0; i != ns->n_cpoint; i++){
@@ -23,9 +23,16 @@
 #include "I18N.h"
 #include "version/Version.h"
 #include "DynvHelpers.h"
+#include "GlobalState.h"
+#include "Color.h"
+#include "tools/PaletteExtract.h"
+#include "tools/Quantizer.h"
 #include <gtk/gtk.h>
 #include <string>
+#include <vector>
 #include <iostream>
+#include <string.h>
+#include <algorithm>
 using namespace std;
 
 static gchar **commandline_filename = nullptr;
@@ -37,6 +44,8 @@ static gboolean single_color_pick_mode = FALSE;
 static gboolean version_information = FALSE;
 static gboolean do_not_start = FALSE;
 static gchar *converter_name = nullptr;
+static gboolean extract_palette = FALSE;
+static gchar *statistics_filename = nullptr;
 static GOptionEntry commandline_entries[] =
 {
 	{"geometry", 'g', 0, G_OPTION_ARG_STRING, &commandline_geometry, "Window geometry", "GEOMETRY"},
@@ -47,12 +56,87 @@ static GOptionEntry commandline_entries[] =
 	{"no-start", 0, 0, G_OPTION_ARG_NONE, &do_not_start, "Do not start Gpick if it is not already running", nullptr},
 	{"converter-name", 'c', 0, G_OPTION_ARG_STRING, &converter_name, "Converter name used for floating picker mode", nullptr},
 	{"version", 'v', 0, G_OPTION_ARG_NONE, &version_information, "Print version information", nullptr},
+	{"statistics", 0, 0, G_OPTION_ARG_FILENAME, &statistics_filename, "Write color picker latency statistics as JSON to file on exit", "FILE"},
+	{"extract-palette", 0, 0, G_OPTION_ARG_NONE, &extract_palette, "Extract palettes from image files without starting user interface, see --extract-palette --help", nullptr},
 	{G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &commandline_filename, nullptr, "[FILE...]"},
 	{nullptr}
 };
+static gint extract_colors = 8;
+static gchar *extract_quantizer = nullptr;
+static gchar *extract_format = nullptr;
+static gchar *extract_output_directory = nullptr;
+static gint64 extract_max_pixels = 16 * 1024 * 1024;
+static gint extract_threads = 0;
+static GOptionEntry extract_palette_entries[] =
+{
+	{"extract-palette", 0, 0, G_OPTION_ARG_NONE, &extract_palette, "Extract palettes from image files without starting user interface", nullptr},
+	{"colors", 'n', 0, G_OPTION_ARG_INT, &extract_colors, "Maximum number of colors in each palette", "N"},
+	{"quantizer", 'q', 0, G_OPTION_ARG_STRING, &extract_quantizer, "Quantizer: octree, wu, median_cut or kmeans", "NAME"},
+	{"out", 0, 0, G_OPTION_ARG_STRING, &extract_format, "Output format: gpl, gpa, txt, ase, css, html or mtl", "FORMAT"},
+	{"output-directory", 'd', 0, G_OPTION_ARG_FILENAME, &extract_output_directory, "Directory for palette files, default is image directory", "DIRECTORY"},
+	{"max-pixels", 0, 0, G_OPTION_ARG_INT64, &extract_max_pixels, "Sample larger images with a stride, 0 disables the limit", "N"},
+	{"threads", 'j', 0, G_OPTION_ARG_INT, &extract_threads, "Number of images processed in parallel, 0 uses all cores", "N"},
+	{G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &commandline_filename, nullptr, "FILE..."},
+	{nullptr}
+};
+static bool is_extract_palette_mode(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++){
+		if (strcmp(argv[i], "--") == 0) break;
+		if (strcmp(argv[i], "--extract-palette") == 0) return true;
+	}
+	return false;
+}
+/**
+ * Extract palettes without initializing GTK, so that no display is needed.
+ */
+static int extract_palette_main(int argc, char **argv)
+{
+	GError *error = nullptr;
+	GOptionContext *context = g_option_context_new("--extract-palette FILE... - extract palettes from images");
+	g_option_context_add_main_entries(context, extract_palette_entries, 0);
+	if (!g_option_context_parse(context, &argc, &argv, &error)){
+		g_print("option parsing failed: %s\n", error->message);
+		g_clear_error(&error);
+		g_option_context_free(context);
+		return -1;
+	}
+	g_option_context_free(context);
+	if (!commandline_filename){
+		g_print("no image files specified\n");
+		return -1;
+	}
+	PaletteExtractOptions options;
+	options.colors = max(0, extract_colors);
+	options.max_pixels = max<gint64>(0, extract_max_pixels);
+	options.threads = max(0, extract_threads);
+	if (extract_format) options.format = extract_format;
+	if (extract_output_directory) options.output_directory = extract_output_directory;
+	if (extract_quantizer){
+		options.quantizer = quantizer_get(extract_quantizer);
+		if (!options.quantizer){
+			g_print("unknown quantizer: %s\n", extract_quantizer);
+			return -1;
+		}
+	}
+	vector<string> filenames;
+	for (int i = 0; commandline_filename[i]; i++){
+		filenames.push_back(commandline_filename[i]);
+	}
+	color_init();
+	GlobalState gs;
+	gs.loadConverters();
+	int failed = tools_palette_extract(&gs, options, filenames);
+	return failed == 0 ? 0 : 1;
+}
 int main(int argc, char **argv)
 {
 	setlocale(LC_ALL, "");
+	if (is_extract_palette_mode(argc, argv)){
+		initialize_i18n();
+		g_set_application_name(program_name);
+		return extract_palette_main(argc, argv);
+	}
 	gtk_init(&argc, &argv);
 	initialize_i18n();
 	g_set_application_name(program_name);
@@ -90,6 +174,8 @@ int main(int argc, char **argv)
 	options.do_not_start = do_not_start;
 	if (converter_name != nullptr)
 		options.converter_name = converter_name;
+	if (statistics_filename != nullptr)
+		options.statistics_filename = statistics_filename;
 	int return_value = 0;
 	app_initialize();
 	AppArgs *args = app_create_main(options, return_value);
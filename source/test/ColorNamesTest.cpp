@@ -0,0 +1,123 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE color_names
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include "color_names/ColorNames.h"
+#include "Color.h"
+using namespace std;
+
+struct ColorNamesFixture
+{
+	ColorNames *color_names;
+	ColorNamesFixture()
+	{
+		color_init();
+		color_names = color_names_new();
+		color_names_load_from_file(color_names, "share/gpick/color_dictionary_0.txt");
+	}
+	~ColorNamesFixture()
+	{
+		color_names_destroy(color_names);
+	}
+};
+static vector<Color> buildQueries()
+{
+	vector<Color> colors;
+	for (int r = 0; r < 256; r += 51){
+		for (int g = 0; g < 256; g += 37){
+			for (int b = 0; b < 256; b += 29){
+				Color color;
+				color_set(&color, r, g, b);
+				colors.push_back(color);
+			}
+		}
+	}
+	return colors;
+}
+BOOST_FIXTURE_TEST_CASE(nearest_matches_exhaustive_search, ColorNamesFixture)
+{
+	vector<pair<const char*, Color>> all, nearest;
+	color_names_find_nearest(color_names, buildQueries()[0], 1000000, all);
+	size_t entry_count = all.size();
+	BOOST_REQUIRE(entry_count > 100);
+	for (auto &query: buildQueries()){
+		color_names_find_nearest(color_names, query, entry_count, all);
+		BOOST_REQUIRE_EQUAL(all.size(), entry_count);
+		color_names_find_nearest(color_names, query, 10, nearest);
+		BOOST_REQUIRE_EQUAL(nearest.size(), 10);
+		for (size_t i = 0; i < nearest.size(); i++){
+			BOOST_CHECK(color_equal(&nearest[i].second, &all[i].second));
+		}
+		BOOST_CHECK_EQUAL(color_names_get(color_names, &query, false), string(all[0].first));
+	}
+}
+BOOST_AUTO_TEST_CASE(empty_dictionary)
+{
+	color_init();
+	ColorNames *color_names = color_names_new();
+	Color color;
+	color_set(&color, 0.5f);
+	vector<pair<const char*, Color>> nearest;
+	color_names_find_nearest(color_names, color, 5, nearest);
+	BOOST_CHECK(nearest.empty());
+	BOOST_CHECK(color_names_get(color_names, &color, true).empty());
+	color_names_destroy(color_names);
+}
+BOOST_FIXTURE_TEST_CASE(name_cache, ColorNamesFixture)
+{
+	Color color;
+	color_set(&color, 10, 200, 30);
+	string name = color_names_get(color_names, &color, true);
+	ColorNamesCacheStatistics before = color_names_get_cache_statistics(color_names);
+	BOOST_CHECK_EQUAL(color_names_get(color_names, &color, true), name);
+	ColorNamesCacheStatistics after = color_names_get_cache_statistics(color_names);
+	BOOST_CHECK_EQUAL(after.hits, before.hits + 1);
+	BOOST_CHECK_EQUAL(after.misses, before.misses);
+	color_names_clear(color_names);
+	BOOST_CHECK(color_names_get(color_names, &color, true).empty());
+	color_names_load_from_file(color_names, "share/gpick/color_dictionary_0.txt");
+	BOOST_CHECK_EQUAL(color_names_get(color_names, &color, true), name);
+	BOOST_CHECK_EQUAL(color_names_get_cache_statistics(color_names).misses, after.misses + 2);
+}
+BOOST_AUTO_TEST_CASE(binary_cache)
+{
+	color_init();
+	auto filename = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("gpick-%%%%-%%%%.txt");
+	auto cache_filename = filename.string() + ".cache";
+	{
+		ofstream file(filename.string());
+		file << "! comment\n255 0 0 red\n0 255 0\tGREEN.\n0 0 255 blue\n250 250 250 white\n";
+	}
+	vector<vector<pair<const char*, Color>>> results(2);
+	vector<vector<string>> names(2);
+	for (int i = 0; i < 2; i++){
+		ColorNames *color_names = color_names_new();
+		BOOST_REQUIRE_EQUAL(color_names_load_from_file(color_names, filename.string().c_str()), 0);
+		BOOST_CHECK(boost::filesystem::exists(cache_filename));
+		for (auto &query: buildQueries()){
+			color_names_find_nearest(color_names, query, 2, results[i]);
+			for (auto &result: results[i])
+				names[i].push_back(result.first);
+		}
+		color_names_destroy(color_names);
+	}
+	BOOST_CHECK(names[0] == names[1]);
+	BOOST_CHECK_EQUAL(names[0].size(), buildQueries().size() * 2);
+	{
+		ofstream file(filename.string(), ios::app);
+		file << "0 0 0 black\n";
+	}
+	ColorNames *color_names = color_names_new();
+	color_names_load_from_file(color_names, filename.string().c_str());
+	Color color;
+	color_set(&color, 0.0f);
+	BOOST_CHECK_EQUAL(color_names_get(color_names, &color, false), "Black");
+	color_set(&color, 0.0f, 1.0f, 0.0f);
+	BOOST_CHECK_EQUAL(color_names_get(color_names, &color, false), "Green");
+	color_names_destroy(color_names);
+	boost::filesystem::remove(filename);
+	boost::filesystem::remove(cache_filename);
+}
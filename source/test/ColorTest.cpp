@@ -0,0 +1,193 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE color
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include <string.h>
+#include <math.h>
+#include "Color.h"
+#include "ColorPipeline.h"
+#include "MathUtil.h"
+using namespace std;
+
+struct ColorInitialization
+{
+	ColorInitialization()
+	{
+		color_init();
+	}
+};
+BOOST_GLOBAL_FIXTURE(ColorInitialization);
+
+static vector<Color> buildRgbColors()
+{
+	vector<Color> colors;
+	for (int r = 0; r < 256; r += 15){
+		for (int g = 0; g < 256; g += 17){
+			for (int b = 0; b < 256; b += 5){
+				Color color;
+				color_set(&color, r, g, b);
+				colors.push_back(color);
+			}
+		}
+	}
+	return colors;
+}
+static bool bitwiseEqual(const Color &a, const Color &b)
+{
+	return memcmp(a.ma, b.ma, sizeof(float) * 3) == 0;
+}
+BOOST_AUTO_TEST_CASE(batch_kernels_match_scalar)
+{
+	vector<float> x, y, z;
+	for (int i = 0; i < 1003; i++){
+		x.push_back(i / 1003.0f);
+		y.push_back(1 - i / 1003.0f);
+		z.push_back((i % 17) / 17.0f);
+	}
+	matrix3x3 matrix = {{{0.4124, 0.3576, 0.1805}, {0.2126, 0.7152, 0.0722}, {0.0193, 0.1192, 0.9505}}};
+	vector<float> expected[3], result[3];
+	for (int level = static_cast<int>(SimdLevel::scalar); level <= static_cast<int>(SimdLevel::avx2); level++){
+		simd_set_max_level(static_cast<SimdLevel>(level));
+		matrix3x3_init_batch_kernels();
+		vector<float> *out = level == 0 ? expected : result;
+		for (int i = 0; i < 3; i++)
+			out[i].resize(x.size());
+		vector3_multiply_matrix3x3_batch(x.data(), y.data(), z.data(), x.size(), &matrix, out[0].data(), out[1].data(), out[2].data());
+		if (level == 0) continue;
+		for (int i = 0; i < 3; i++)
+			BOOST_REQUIRE(memcmp(expected[i].data(), result[i].data(), x.size() * sizeof(float)) == 0);
+	}
+	simd_set_max_level(SimdLevel::avx2);
+	matrix3x3_init_batch_kernels();
+}
+BOOST_AUTO_TEST_CASE(rgb_to_lab_batch)
+{
+	auto colors = buildRgbColors();
+	vector<Color> result(colors.size());
+	RgbToLabPipeline pipeline;
+	color_rgb_to_lab_d50_batch(&colors[0], &result[0], colors.size());
+	for (size_t i = 0; i < colors.size(); i++){
+		Color expected;
+		pipeline(&colors[i], &expected);
+		BOOST_REQUIRE(bitwiseEqual(expected, result[i]));
+		color_rgb_to_lab_d50(&colors[i], &expected);
+		for (int j = 0; j < 3; j++)
+			BOOST_REQUIRE_SMALL(expected.ma[j] - result[i].ma[j], 1e-3f);
+	}
+}
+BOOST_AUTO_TEST_CASE(rgb_to_lch_batch)
+{
+	auto colors = buildRgbColors();
+	vector<Color> result(colors.size());
+	RgbToLchPipeline pipeline;
+	color_rgb_to_lch_d50_batch(&colors[0], &result[0], colors.size());
+	for (size_t i = 0; i < colors.size(); i++){
+		Color expected;
+		pipeline(&colors[i], &expected);
+		BOOST_REQUIRE(bitwiseEqual(expected, result[i]));
+		color_rgb_to_lch_d50(&colors[i], &expected);
+		BOOST_REQUIRE_SMALL(expected.lch.L - result[i].lch.L, 1e-3f);
+		BOOST_REQUIRE_SMALL(expected.lch.C - result[i].lch.C, 1e-3f);
+	}
+}
+BOOST_AUTO_TEST_CASE(lab_to_rgb_batch)
+{
+	auto colors = buildRgbColors();
+	color_rgb_to_lab_d50_batch(&colors[0], &colors[0], colors.size());
+	vector<Color> result(colors.size());
+	LabToRgbPipeline pipeline;
+	color_lab_to_rgb_d50_batch(&colors[0], &result[0], colors.size());
+	for (size_t i = 0; i < colors.size(); i++){
+		Color expected;
+		pipeline(&colors[i], &expected);
+		BOOST_REQUIRE(bitwiseEqual(expected, result[i]));
+		color_lab_to_rgb_d50(&colors[i], &expected);
+		for (int j = 0; j < 3; j++)
+			BOOST_REQUIRE_SMALL(expected.ma[j] - result[i].ma[j], 1e-5f);
+	}
+}
+BOOST_AUTO_TEST_CASE(hsv_batch)
+{
+	auto colors = buildRgbColors();
+	vector<Color> hsv(colors.size()), rgb(colors.size());
+	color_rgb_to_hsv_batch(&colors[0], &hsv[0], colors.size());
+	color_hsv_to_rgb_batch(&hsv[0], &rgb[0], colors.size());
+	for (size_t i = 0; i < colors.size(); i++){
+		Color expected;
+		color_rgb_to_hsv(&colors[i], &expected);
+		BOOST_REQUIRE(bitwiseEqual(expected, hsv[i]));
+		color_hsv_to_rgb(&hsv[i], &expected);
+		BOOST_REQUIRE(bitwiseEqual(expected, rgb[i]));
+	}
+}
+BOOST_AUTO_TEST_CASE(srgb8_linearization_lookup_is_exact)
+{
+	for (int i = 0; i < 256; i++){
+		float value = i / 255.0;
+		float expected = (value > 0.04045) ? pow((value + 0.055) / 1.055, 2.4) : value / 12.92;
+		BOOST_CHECK_EQUAL(expected, color_srgb_to_linear_fast(value));
+	}
+}
+BOOST_AUTO_TEST_CASE(fast_conversion_error_bounds)
+{
+	for (int i = 0; i <= 100000; i++){
+		float value = i / 100000.0f;
+		float linear = (value > 0.04045) ? pow((value + 0.055) / 1.055, 2.4) : value / 12.92;
+		BOOST_REQUIRE_SMALL(color_srgb_to_linear_fast(value) - linear, 2e-7f);
+		float srgb = (value > 0.0031308) ? 1.055 * pow(value, 1 / 2.4f) - 0.055 : 12.92 * value;
+		BOOST_REQUIRE_SMALL(color_linear_to_srgb_fast(value) - srgb, 3e-5f);
+		float x = value * 4 + 1e-3f;
+		BOOST_REQUIRE_SMALL((color_cbrt_fast(x) - cbrtf(x)) / cbrtf(x), 5e-7f);
+	}
+	auto colors = buildRgbColors();
+	for (size_t i = 0; i < colors.size(); i++){
+		Color expected, result;
+		colors[i].rgb.red *= 0.999f;
+		color_rgb_to_lab_d50(&colors[i], &expected);
+		color_rgb_to_lab_d50_fast(&colors[i], &result);
+		for (int j = 0; j < 3; j++){
+			BOOST_REQUIRE_SMALL(expected.ma[j] - result.ma[j], 5e-4f);
+		}
+	}
+}
+BOOST_AUTO_TEST_CASE(pipelines_match_separate_conversions)
+{
+	auto colors = buildRgbColors();
+	const vector3 *reference_white = color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_10);
+	matrix3x3 adaptation_matrix, adaptation_matrix_inverted;
+	color_get_chromatic_adaptation_matrix(color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2), reference_white, &adaptation_matrix);
+	color_get_chromatic_adaptation_matrix(reference_white, color_get_reference(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_2), &adaptation_matrix_inverted);
+	RgbToLabPipeline to_lab(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_10);
+	RgbToLchFastPipeline to_lch;
+	LabToRgbPipeline from_lab(REFERENCE_ILLUMINANT_D65, REFERENCE_OBSERVER_10);
+	LchToRgbPipeline from_lch;
+	std::vector<Color> lab(colors.size()), lch(colors.size()), rgb(colors.size());
+	to_lab(colors.data(), lab.data(), colors.size());
+	to_lch(colors.data(), lch.data(), colors.size());
+	for (size_t i = 0; i < colors.size(); i++){
+		Color expected, single;
+		color_rgb_to_lab(&colors[i], &expected, reference_white, color_get_sRGB_transformation_matrix(), &adaptation_matrix);
+		to_lab(&colors[i], &single);
+		BOOST_CHECK(memcmp(&single, &lab[i], sizeof(float) * 3) == 0);
+		for (int j = 0; j < 3; j++)
+			BOOST_REQUIRE_SMALL(expected.ma[j] - lab[i].ma[j], 1e-3f);
+		color_rgb_to_lch_d50(&colors[i], &expected);
+		BOOST_REQUIRE_SMALL(expected.lch.L - lch[i].lch.L, 1e-3f);
+		BOOST_REQUIRE_SMALL(expected.lch.C - lch[i].lch.C, 1e-3f);
+		color_lab_to_rgb(&lab[i], &expected, reference_white, color_get_inverted_sRGB_transformation_matrix(), &adaptation_matrix_inverted);
+		from_lab(&lab[i], &single);
+		for (int j = 0; j < 3; j++)
+			BOOST_REQUIRE_SMALL(expected.ma[j] - single.ma[j], 1e-5f);
+	}
+	from_lab(lab.data(), rgb.data(), lab.size());
+	for (size_t i = 0; i < colors.size(); i++){
+		for (int j = 0; j < 3; j++)
+			BOOST_REQUIRE_SMALL(colors[i].ma[j] - rgb[i].ma[j], 1e-4f);
+	}
+	color_rgb_to_lch_d50_batch(colors.data(), lch.data(), colors.size());
+	from_lch(lch.data(), rgb.data(), lch.size());
+	for (size_t i = 0; i < colors.size(); i++){
+		for (int j = 0; j < 3; j++)
+			BOOST_REQUIRE_SMALL(colors[i].ma[j] - rgb[i].ma[j], 1e-4f);
+	}
+}
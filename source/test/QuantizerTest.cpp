@@ -0,0 +1,159 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE quantizer
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include <math.h>
+#include "tools/Quantizer.h"
+#include "tools/Octree.h"
+#include "Color.h"
+#include "MathUtil.h"
+using namespace std;
+
+static vector<unsigned char> buildImage(int width, int height)
+{
+	vector<unsigned char> image(width * height * 3);
+	for (int y = 0; y < height; y++){
+		for (int x = 0; x < width; x++){
+			unsigned char *pixel = &image[(y * width + x) * 3];
+			pixel[0] = x * 255 / width;
+			pixel[1] = y * 255 / height;
+			pixel[2] = (x * y) & 0xff;
+		}
+	}
+	return image;
+}
+BOOST_AUTO_TEST_CASE(histogram)
+{
+	unsigned char image[] = {
+		10, 20, 30, 0, 40, 50, 60, 0,
+		10, 20, 30, 0, 10, 20, 30, 0,
+	};
+	vector<QuantizerColor> histogram;
+	quantizer_histogram_rgb8(image, 4, 2, 2, 8, histogram);
+	BOOST_REQUIRE_EQUAL(histogram.size(), 2);
+	BOOST_CHECK_EQUAL(histogram[0].weight, 3);
+	BOOST_CHECK_EQUAL(histogram[1].weight, 1);
+	Color color;
+	color_set(&color, 10, 20, 30);
+	BOOST_CHECK(color_equal(&histogram[0].color, &color));
+}
+BOOST_AUTO_TEST_CASE(incremental_histogram)
+{
+	auto image = buildImage(256, 256);
+	vector<QuantizerColor> expected, histogram;
+	quantizer_histogram_rgb8(image.data(), 3, 256, 256, 256 * 3, expected);
+	BOOST_REQUIRE(expected.size() > 1 << 15);
+	QuantizerHistogram *builder = quantizer_histogram_new();
+	for (int y = 0; y < 256; y += 100){
+		quantizer_histogram_add_rgb8(builder, image.data() + y * 256 * 3, 3, 256, min(100, 256 - y), 256 * 3);
+	}
+	BOOST_CHECK_EQUAL(quantizer_histogram_get_size(builder), expected.size());
+	quantizer_histogram_get_colors(builder, histogram);
+	quantizer_histogram_destroy(builder);
+	BOOST_REQUIRE_EQUAL(histogram.size(), expected.size());
+	uint64_t total = 0;
+	for (size_t i = 0; i < histogram.size(); i++){
+		BOOST_CHECK(color_equal(&histogram[i].color, &expected[i].color));
+		BOOST_CHECK_EQUAL(histogram[i].weight, expected[i].weight);
+		if (i > 0) BOOST_CHECK(histogram[i - 1].color.rgb.blue <= histogram[i].color.rgb.blue);
+		total += histogram[i].weight;
+	}
+	BOOST_CHECK_EQUAL(total, 256 * 256);
+}
+BOOST_AUTO_TEST_CASE(parallel_histogram)
+{
+	auto image = buildImage(512, 512);
+	vector<QuantizerColor> expected, histogram;
+	quantizer_histogram_rgb8(image.data(), 3, 512, 512, 512 * 3, expected);
+	QuantizerHistogram *builder = quantizer_histogram_new();
+	quantizer_histogram_add_rgb8_parallel(builder, image.data(), 3, 512, 300, 512 * 3, 4);
+	quantizer_histogram_add_rgb8_parallel(builder, image.data() + 300 * 512 * 3, 3, 512, 212, 512 * 3, 3);
+	quantizer_histogram_get_colors(builder, histogram);
+	quantizer_histogram_destroy(builder);
+	BOOST_REQUIRE_EQUAL(histogram.size(), expected.size());
+	for (size_t i = 0; i < histogram.size(); i++){
+		BOOST_CHECK(color_equal(&histogram[i].color, &expected[i].color));
+		BOOST_CHECK_EQUAL(histogram[i].weight, expected[i].weight);
+	}
+}
+BOOST_AUTO_TEST_CASE(parallel_octree_from_histogram)
+{
+	auto image = buildImage(512, 512);
+	vector<QuantizerColor> histogram;
+	quantizer_histogram_rgb8(image.data(), 3, 512, 512, 512 * 3, histogram);
+	vector<Color> expected, colors;
+	for (unsigned int threads = 1; threads <= 4; threads += 3){
+		Octree *tree = octree_new();
+		BOOST_REQUIRE(octree_add_colors_parallel(tree, histogram.data(), histogram.size(), 6, threads, nullptr));
+		octree_reduce(tree, 16);
+		octree_get_colors(tree, threads == 1 ? expected : colors);
+		octree_delete(tree);
+	}
+	BOOST_REQUIRE_EQUAL(colors.size(), expected.size());
+	for (size_t i = 0; i < colors.size(); i++){
+		BOOST_CHECK(color_equal(&colors[i], &expected[i]));
+	}
+}
+BOOST_AUTO_TEST_CASE(palette_size_limit)
+{
+	color_init();
+	auto image = buildImage(64, 64);
+	vector<QuantizerColor> histogram;
+	quantizer_histogram_rgb8(image.data(), 3, 64, 64, 64 * 3, histogram);
+	for (uint32_t i = 0; i < quantizers_get_n(); i++){
+		vector<Color> palette;
+		quantizers_get()[i].quantize(histogram.data(), histogram.size(), 12, palette);
+		BOOST_CHECK(palette.size() > 1);
+		BOOST_CHECK(palette.size() <= 12);
+		for (auto &color: palette){
+			for (int j = 0; j < 3; j++){
+				BOOST_CHECK(color.ma[j] >= 0 && color.ma[j] <= 1);
+			}
+		}
+	}
+}
+BOOST_AUTO_TEST_CASE(distinct_colors_are_preserved)
+{
+	color_init();
+	unsigned char image[] = {
+		255, 0, 0, 0, 255, 0, 0, 0, 255, 255, 255, 255,
+	};
+	vector<QuantizerColor> histogram;
+	quantizer_histogram_rgb8(image, 3, 4, 1, 12, histogram);
+	for (uint32_t i = 0; i < quantizers_get_n(); i++){
+		vector<Color> palette;
+		quantizers_get()[i].quantize(histogram.data(), histogram.size(), 8, palette);
+		BOOST_CHECK_EQUAL(palette.size(), histogram.size());
+		for (auto &expected: histogram){
+			bool found = false;
+			for (auto &color: palette){
+				if (fabs(color.rgb.red - expected.color.rgb.red) < 0.01 && fabs(color.rgb.green - expected.color.rgb.green) < 0.01 && fabs(color.rgb.blue - expected.color.rgb.blue) < 0.01)
+					found = true;
+			}
+			BOOST_CHECK_MESSAGE(found, quantizers_get()[i].name);
+		}
+	}
+}
+BOOST_AUTO_TEST_CASE(kmeans_kernels_match_scalar)
+{
+	color_init();
+	auto image = buildImage(64, 64);
+	vector<QuantizerColor> histogram;
+	quantizer_histogram_rgb8(image.data(), 3, 64, 64, 64 * 3, histogram);
+	const Quantizer *kmeans = quantizer_get("kmeans");
+	vector<Color> expected, palette;
+	simd_set_max_level(SimdLevel::scalar);
+	kmeans->quantize(histogram.data(), histogram.size(), 12, expected);
+	simd_set_max_level(SimdLevel::avx2);
+	kmeans->quantize(histogram.data(), histogram.size(), 12, palette);
+	BOOST_REQUIRE_EQUAL(palette.size(), expected.size());
+	for (size_t i = 0; i < palette.size(); i++){
+		BOOST_CHECK(color_equal(&palette[i], &expected[i]));
+	}
+}
+BOOST_AUTO_TEST_CASE(lookup_by_name)
+{
+	BOOST_REQUIRE(quantizer_get("kmeans") != nullptr);
+	BOOST_CHECK_EQUAL(quantizer_get("wu")->name, "wu");
+	BOOST_CHECK(quantizer_get("unknown") == nullptr);
+}
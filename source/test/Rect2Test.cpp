@@ -0,0 +1,50 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE rect2
+#include <boost/test/unit_test.hpp>
+#include "Rect2.h"
+using namespace math;
+
+BOOST_AUTO_TEST_CASE(union_of_two)
+{
+	Rect2<int> a(0, 0, 10, 10), b(5, -5, 20, 8);
+	Rect2<int> r = a + b;
+	BOOST_CHECK(!r.isEmpty());
+	BOOST_CHECK_EQUAL(r.getLeft(), 0);
+	BOOST_CHECK_EQUAL(r.getTop(), -5);
+	BOOST_CHECK_EQUAL(r.getRight(), 20);
+	BOOST_CHECK_EQUAL(r.getBottom(), 10);
+	BOOST_CHECK(r == Rect2<int>(0, -5, 20, 10));
+}
+BOOST_AUTO_TEST_CASE(union_with_empty)
+{
+	Rect2<int> a(1, 2, 3, 4), empty;
+	BOOST_CHECK(a + empty == a);
+	BOOST_CHECK(empty + a == a);
+	BOOST_CHECK((empty + empty).isEmpty());
+}
+BOOST_AUTO_TEST_CASE(union_accumulated)
+{
+	Rect2<int> r;
+	r += Rect2<int>(0, 0, 1, 1);
+	r += Rect2<int>(10, 10, 11, 11);
+	r += Rect2<int>(-5, 3, -4, 4);
+	BOOST_CHECK(r == Rect2<int>(-5, 0, 11, 11));
+}
+BOOST_AUTO_TEST_CASE(union_intersects)
+{
+	Rect2<int> sampler(100, 100, 105, 105), zoom(90, 90, 110, 110), damage(108, 108, 120, 120);
+	Rect2<int> area = sampler + zoom;
+	BOOST_CHECK(area.intersects(damage));
+	BOOST_CHECK(area != Rect2<int>(100, 100, 105, 105));
+	BOOST_CHECK(!area.intersects(Rect2<int>(110, 0, 120, 200)));
+}
+BOOST_AUTO_TEST_CASE(intersects)
+{
+	Rect2<int> a(0, 0, 10, 10);
+	BOOST_CHECK(a.intersects(Rect2<int>(9, 9, 12, 12)));
+	BOOST_CHECK(a.intersects(Rect2<int>(2, 2, 3, 3)));
+	BOOST_CHECK(!a.intersects(Rect2<int>(10, 0, 12, 10)));
+	BOOST_CHECK(!a.intersects(Rect2<int>(0, -5, 10, 0)));
+	BOOST_CHECK(!a.intersects(Rect2<int>()));
+	BOOST_CHECK(!Rect2<int>().intersects(a));
+}
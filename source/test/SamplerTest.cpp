@@ -0,0 +1,193 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE sampler
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include <string.h>
+#include <math.h>
+#include "Sampler.h"
+#include "ScreenReader.h"
+#include "ScreenSource.h"
+#include "MathUtil.h"
+using namespace math;
+using namespace std;
+
+/** \struct SurfaceSampler
+ * \brief Sampler reading pixels from an in-memory surface instead of the screen
+ */
+struct SurfaceSampler
+{
+	cairo_surface_t *surface;
+	ScreenReader *screen_reader;
+	Sampler *sampler;
+	SurfaceSampler(int width, int height)
+	{
+		surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+		screen_reader = screen_reader_new();
+		screen_reader_set_source(screen_reader, screen_source_new_surface(surface));
+		sampler = sampler_new(screen_reader);
+	}
+	~SurfaceSampler()
+	{
+		sampler_destroy(sampler);
+		screen_reader_destroy(screen_reader);
+		cairo_surface_destroy(surface);
+	}
+	void setPixel(int x, int y, int red, int green, int blue)
+	{
+		cairo_surface_flush(surface);
+		unsigned char *pixel = cairo_image_surface_get_data(surface) + y * cairo_image_surface_get_stride(surface) + x * 4;
+		pixel[0] = blue;
+		pixel[1] = green;
+		pixel[2] = red;
+		pixel[3] = 0xff;
+		cairo_surface_mark_dirty(surface);
+	}
+	void setPixel(int x, int y, int value)
+	{
+		setPixel(x, y, value, value, value);
+	}
+	Color sample(int x, int y)
+	{
+		Vec2<int> point(x, y);
+		Color color;
+		sampler_get_color_samples(sampler, nullptr, &point, 1, &color);
+		return color;
+	}
+};
+/** Fill 3x3 patch centered at x, y with values given row by row */
+static void setPatch(SurfaceSampler &s, int x, int y, const int values[9])
+{
+	for (int i = 0; i < 9; i++)
+		s.setPixel(x - 1 + i % 3, y - 1 + i / 3, values[i]);
+}
+BOOST_AUTO_TEST_CASE(mean_without_falloff)
+{
+	SurfaceSampler s(16, 16);
+	const int values[9] = {10, 20, 30, 40, 50, 60, 100, 200, 250};
+	setPatch(s, 5, 5, values);
+	sampler_set_oversample(s.sampler, 1);
+	Color color = s.sample(5, 5);
+	BOOST_CHECK_CLOSE(color.rgb.red, 760 / 9.0 / 255, 1e-4);
+	BOOST_CHECK_CLOSE(color.rgb.blue, 760 / 9.0 / 255, 1e-4);
+	sampler_set_oversample(s.sampler, 0);
+	color = s.sample(5, 5);
+	BOOST_CHECK_CLOSE(color.rgb.green, 50 / 255.0, 1e-4);
+}
+BOOST_AUTO_TEST_CASE(linear_falloff_weights)
+{
+	// Center pixel has weight 1, edge pixels 1 - 1 / sqrt(2) and corner pixels 0
+	SurfaceSampler s(16, 16);
+	const int values[9] = {255, 80, 255, 80, 200, 80, 255, 80, 255};
+	setPatch(s, 5, 5, values);
+	sampler_set_oversample(s.sampler, 1);
+	sampler_set_falloff(s.sampler, SamplerFalloff::linear);
+	double edge = int((1 - 1 / sqrt(2.0)) * 16384 + 0.5);
+	double expected = (200 * 16384 + 4 * 80 * edge) / (16384 + 4 * edge) / 255;
+	Color color = s.sample(5, 5);
+	BOOST_CHECK_CLOSE(color.rgb.red, expected, 1e-4);
+	BOOST_CHECK_CLOSE(color.rgb.green, expected, 1e-4);
+}
+BOOST_AUTO_TEST_CASE(window_is_clipped_to_screen)
+{
+	SurfaceSampler s(4, 4);
+	s.setPixel(0, 0, 100);
+	s.setPixel(1, 0, 200);
+	s.setPixel(0, 1, 30);
+	s.setPixel(1, 1, 70);
+	sampler_set_oversample(s.sampler, 1);
+	Color color = s.sample(0, 0);
+	BOOST_CHECK_CLOSE(color.rgb.red, 100 / 255.0, 1e-4);
+}
+BOOST_AUTO_TEST_CASE(median_and_trimmed_mean)
+{
+	SurfaceSampler s(16, 16);
+	const int values[9] = {250, 10, 60, 40, 200, 20, 50, 30, 100};
+	setPatch(s, 5, 5, values);
+	sampler_set_oversample(s.sampler, 1);
+	sampler_set_mode(s.sampler, SamplerMode::median);
+	Color color = s.sample(5, 5);
+	BOOST_CHECK_CLOSE(color.rgb.red, 50 / 255.0, 1e-4);
+	BOOST_CHECK_CLOSE(color.rgb.blue, 50 / 255.0, 1e-4);
+	// Lowest and highest 2.25 pixels are dropped: 0.75 * 30 + 40 + 50 + 60 + 0.75 * 100 over 4.5 pixels
+	sampler_set_mode(s.sampler, SamplerMode::trimmed_mean);
+	color = s.sample(5, 5);
+	BOOST_CHECK_CLOSE(color.rgb.green, 55 / 255.0, 1e-4);
+}
+BOOST_AUTO_TEST_CASE(dominant_color)
+{
+	SurfaceSampler s(16, 16);
+	const int colors[9][3] = {
+		{200, 10, 10}, {0, 0, 255}, {201, 10, 10},
+		{0, 0, 255}, {202, 12, 10}, {0, 0, 255},
+		{203, 10, 10}, {0, 0, 255}, {204, 10, 10},
+	};
+	for (int i = 0; i < 9; i++)
+		s.setPixel(4 + i % 3, 4 + i / 3, colors[i][0], colors[i][1], colors[i][2]);
+	sampler_set_oversample(s.sampler, 1);
+	sampler_set_mode(s.sampler, SamplerMode::dominant);
+	Color color = s.sample(5, 5);
+	BOOST_CHECK_CLOSE(color.rgb.red, 202 / 255.0, 1e-4);
+	BOOST_CHECK_CLOSE(color.rgb.green, 10.4 / 255.0, 1e-4);
+	BOOST_CHECK_CLOSE(color.rgb.blue, 10 / 255.0, 1e-4);
+}
+BOOST_AUTO_TEST_CASE(simd_matches_scalar)
+{
+	SurfaceSampler s(40, 40);
+	uint32_t seed = 7;
+	for (int y = 0; y < 40; y++){
+		for (int x = 0; x < 40; x++){
+			seed = seed * 1664525 + 1013904223;
+			s.setPixel(x, y, seed >> 24, (seed >> 16) & 0xff, (seed >> 8) & 0xff);
+		}
+	}
+	vector<Vec2<int>> points;
+	for (int y = 0; y < 40; y += 3){
+		for (int x = 0; x < 40; x += 5)
+			points.push_back(Vec2<int>(x, y));
+	}
+	const SamplerFalloff falloffs[] = {SamplerFalloff::none, SamplerFalloff::linear, SamplerFalloff::quadratic, SamplerFalloff::cubic, SamplerFalloff::exponential};
+	for (auto falloff: falloffs){
+		sampler_set_falloff(s.sampler, falloff);
+		for (int oversample = 0; oversample <= 8; oversample++){
+			sampler_set_oversample(s.sampler, oversample);
+			vector<Color> expected(points.size()), colors(points.size());
+			simd_set_max_level(SimdLevel::scalar);
+			sampler_get_color_samples(s.sampler, nullptr, points.data(), points.size(), expected.data());
+			simd_set_max_level(SimdLevel::avx2);
+			sampler_get_color_samples(s.sampler, nullptr, points.data(), points.size(), colors.data());
+			for (size_t i = 0; i < points.size(); i++)
+				BOOST_REQUIRE(memcmp(expected[i].ma, colors[i].ma, sizeof(float) * 3) == 0);
+		}
+	}
+}
+BOOST_AUTO_TEST_CASE(region_colors)
+{
+	SurfaceSampler s(16, 16);
+	for (int y = 0; y < 16; y++){
+		for (int x = 0; x < 16; x++)
+			s.setPixel(x, y, x * 10, y * 10, 100);
+	}
+	const Rect2<int> regions[] = {
+		Rect2<int>(2, 3, 6, 5),
+		Rect2<int>(14, -4, 20, 2),
+		Rect2<int>(20, 20, 30, 30),
+	};
+	Color colors[3];
+	BOOST_CHECK_EQUAL(sampler_get_region_colors(s.sampler, nullptr, regions, 3, colors), 2u);
+	BOOST_CHECK_CLOSE(colors[0].rgb.red, 35 / 255.0, 1e-4);
+	BOOST_CHECK_CLOSE(colors[0].rgb.green, 35 / 255.0, 1e-4);
+	BOOST_CHECK_CLOSE(colors[0].rgb.blue, 100 / 255.0, 1e-4);
+	BOOST_CHECK_CLOSE(colors[1].rgb.red, 145 / 255.0, 1e-4);
+	BOOST_CHECK_CLOSE(colors[1].rgb.green, 5 / 255.0, 1e-4);
+	BOOST_CHECK_EQUAL(colors[2].rgb.red, 0);
+}
+BOOST_AUTO_TEST_CASE(grid_points)
+{
+	Vec2<int> points[6];
+	sampler_get_grid_points(Rect2<int>(10, 20, 40, 40), 3, 2, points);
+	const int expected[6][2] = {{15, 25}, {25, 25}, {35, 25}, {15, 35}, {25, 35}, {35, 35}};
+	for (int i = 0; i < 6; i++){
+		BOOST_CHECK_EQUAL(points[i].x, expected[i][0]);
+		BOOST_CHECK_EQUAL(points[i].y, expected[i][1]);
+	}
+}
@@ -109,37 +109,39 @@ static void calc(ColorSpaceSamplerArgs *args, bool preview, size_t limit)
 			}
 		}
 	}
+	switch (args->color_space){
+		case 0:
+			break;
+		case 1:
+			color_hsv_to_rgb_batch(values.data(), values.data(), value_count);
+			break;
+		case 2:
+			color_hsl_to_rgb_batch(values.data(), values.data(), value_count);
+			break;
+		case 3:
+			for (size_t i = 0; i < value_count; i++){
+				values[i].lab.L *= 100;
+				values[i].lab.a = (values[i].lab.a - 0.5) * 290;
+				values[i].lab.b = (values[i].lab.b - 0.5) * 290;
+			}
+			color_lab_to_rgb_d50_batch(values.data(), values.data(), value_count);
+			break;
+		case 4:
+			for (size_t i = 0; i < value_count; i++){
+				values[i].lch.L *= 100;
+				values[i].lch.C *= 136;
+				values[i].lch.h *= 360;
+			}
+			color_lch_to_rgb_d50_batch(values.data(), values.data(), value_count);
+			break;
+	}
 	Color t;
 	for (size_t i = 0; i < value_count; i++){
 		if (preview){
 			if (limit <= 0) return;
 			limit--;
 		}
-		switch (args->color_space){
-			case 0:
-				color_copy(&values[i], &t);
-				break;
-			case 1:
-				color_hsv_to_rgb(&values[i], &t);
-				break;
-			case 2:
-				color_hsl_to_rgb(&values[i], &t);
-				break;
-			case 3:
-				color_copy(&values[i], &t);
-				t.lab.L *= 100;
-				t.lab.a = (t.lab.a - 0.5) * 290;
-				t.lab.b = (t.lab.b - 0.5) * 290;
-				color_lab_to_rgb_d50(&t, &t);
-				break;
-			case 4:
-				color_copy(&values[i], &t);
-				t.lch.L *= 100;
-				t.lch.C *= 136;
-				t.lch.h *= 360;
-				color_lch_to_rgb_d50(&t, &t);
-				break;
-		}
+		color_copy(&values[i], &t);
 		if (args->linearization)
 			color_linear_get_rgb(&t, &t);
 		color_rgb_normalize(&t);
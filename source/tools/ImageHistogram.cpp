@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ImageHistogram.h"
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <string.h>
+#include <math.h>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+/** Size of file chunks passed to image loader */
+const size_t ChunkSize = 64 * 1024;
+/** Decoded rows are added to histogram in batches of at least this many sampled pixels, so that histogram threads get enough work */
+const uint64_t BatchPixels = 1 << 18;
+
+ImageHistogramProgress::ImageHistogramProgress():
+	rows_done(0),
+	rows(0),
+	cancel(false)
+{
+}
+
+/** \struct LoadState
+ * \brief State shared between image loader signal handlers
+ */
+struct LoadState{
+	QuantizerHistogram *histogram;
+	ImageHistogramProgress *progress;
+	uint64_t max_pixels;
+	int step; /**< Sample every step-th pixel in every step-th row */
+	int decoded_rows; /**< Number of rows decoded in image order */
+	int next_row; /**< First row which was not added to histogram yet */
+	bool restart; /**< Rows were updated more than once, histogram has to be rebuilt from final image */
+};
+
+/**
+ * Add decoded rows to histogram.
+ * @param[in] flush Add all decoded rows, otherwise rows are added only when there are enough of them for one batch.
+ */
+static void add_rows(LoadState *state, GdkPixbuf *pixbuf, bool flush){
+	int channels = gdk_pixbuf_get_n_channels(pixbuf);
+	int width = gdk_pixbuf_get_width(pixbuf);
+	int rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+	const guchar *data = gdk_pixbuf_get_pixels(pixbuf);
+	int step = state->step;
+	int end_row = state->decoded_rows;
+	int first = ((state->next_row + step - 1) / step) * step;
+	int rows = first < end_row ? (end_row - first + step - 1) / step : 0;
+	int sampled_width = (width + step - 1) / step;
+	if (!flush && uint64_t(rows) * sampled_width < BatchPixels) return;
+	if (rows > 0){
+		// Stride is applied by treating every step-th pixel as the next one and every step-th row as the next one
+		quantizer_histogram_add_rgb8_parallel(state->histogram, data + rowstride * first, channels * step, sampled_width, rows, rowstride * step, 0);
+	}
+	if (end_row > state->next_row){
+		if (state->progress) state->progress->rows_done += end_row - state->next_row;
+		state->next_row = end_row;
+	}
+}
+
+static void size_prepared_cb(GdkPixbufLoader *loader, gint width, gint height, LoadState *state){
+	uint64_t pixels = uint64_t(width) * height;
+	if (state->max_pixels > 0 && pixels > state->max_pixels){
+		int step = static_cast<int>(ceil(sqrt(double(pixels) / state->max_pixels)));
+		GdkPixbufFormat *format = gdk_pixbuf_loader_get_format(loader);
+		gchar *name = format ? gdk_pixbuf_format_get_name(format) : nullptr;
+		if (name && strcmp(name, "jpeg") == 0){
+			// JPEG decoder can scale while decoding, which avoids allocating full size image
+			width = max(1, width / step);
+			height = max(1, height / step);
+			gdk_pixbuf_loader_set_size(loader, width, height);
+		}else{
+			state->step = step;
+		}
+		g_free(name);
+	}
+	if (state->progress) state->progress->rows = height;
+}
+
+static void area_updated_cb(GdkPixbufLoader *loader, gint x, gint y, gint width, gint height, LoadState *state){
+	GdkPixbuf *pixbuf = gdk_pixbuf_loader_get_pixbuf(loader);
+	if (!pixbuf || state->restart) return;
+	if (y < state->decoded_rows){
+		// Interlaced and progressive images update the same rows several times
+		state->restart = true;
+		return;
+	}
+	if (x != 0 || width != gdk_pixbuf_get_width(pixbuf) || y != state->decoded_rows) return;
+	state->decoded_rows = min(y + height, gdk_pixbuf_get_height(pixbuf));
+	add_rows(state, pixbuf, false);
+}
+
+bool image_histogram_load(const char *filename, uint64_t max_pixels, QuantizerHistogram *histogram, ImageHistogramProgress *progress, string &error){
+	ifstream file(filename, ios::in | ios::binary);
+	if (!file.is_open()){
+		error = string("Could not open file \"") + filename + "\"";
+		return false;
+	}
+	LoadState state;
+	state.histogram = histogram;
+	state.progress = progress;
+	state.max_pixels = max_pixels;
+	state.step = 1;
+	state.decoded_rows = 0;
+	state.next_row = 0;
+	state.restart = false;
+	GdkPixbufLoader *loader = gdk_pixbuf_loader_new();
+	g_signal_connect(G_OBJECT(loader), "size-prepared", G_CALLBACK(size_prepared_cb), &state);
+	g_signal_connect(G_OBJECT(loader), "area-updated", G_CALLBACK(area_updated_cb), &state);
+	GError *gerror = nullptr;
+	vector<char> buffer(ChunkSize);
+	bool success = true;
+	while (file.good()){
+		if (progress && progress->cancel){
+			success = false;
+			break;
+		}
+		file.read(buffer.data(), buffer.size());
+		if (file.gcount() == 0) break;
+		if (!gdk_pixbuf_loader_write(loader, reinterpret_cast<const guchar*>(buffer.data()), file.gcount(), &gerror)){
+			success = false;
+			break;
+		}
+	}
+	if (file.bad()){
+		error = string("Could not read file \"") + filename + "\"";
+		success = false;
+	}
+	if (!gdk_pixbuf_loader_close(loader, gerror ? nullptr : &gerror)) success = false;
+	if (gerror){
+		error = gerror->message;
+		g_error_free(gerror);
+		success = false;
+	}
+	if (success){
+		GdkPixbuf *pixbuf = gdk_pixbuf_loader_get_pixbuf(loader);
+		if (pixbuf){
+			if (state.restart){
+				quantizer_histogram_clear(histogram);
+				state.next_row = 0;
+			}
+			state.decoded_rows = gdk_pixbuf_get_height(pixbuf);
+			add_rows(&state, pixbuf, true);
+		}else{
+			error = string("Could not load image \"") + filename + "\"";
+			success = false;
+		}
+	}
+	g_object_unref(loader);
+	return success;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_TOOLS_IMAGE_HISTOGRAM_H_
+#define GPICK_TOOLS_IMAGE_HISTOGRAM_H_
+#include "Quantizer.h"
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+/** \file source/tools/ImageHistogram.h
+ * \brief Incremental image decoding into color histogram.
+ */
+
+/** \struct ImageHistogramProgress
+ * \brief Image decoding progress shared with other threads
+ */
+struct ImageHistogramProgress{
+	std::atomic<int> rows_done; /**< Number of image rows added to histogram */
+	std::atomic<int> rows; /**< Number of image rows, 0 until image size is known */
+	std::atomic<bool> cancel; /**< Set to stop decoding */
+	ImageHistogramProgress();
+};
+
+/**
+ * Decode image file in small chunks and add rows to histogram as soon as they are decoded.
+ * Full image file is never read into memory at once.
+ * @param[in] filename Image file name
+ * @param[in] max_pixels Maximum number of pixels to sample, larger images are sampled with uniform stride. 0 disables the limit.
+ * @param[in] histogram Histogram receiving image colors
+ * @param[in] progress Progress information and cancellation flag, can be nullptr
+ * @param[out] error Error message when decoding fails
+ * @return True on success, false on error or when cancelled
+ */
+bool image_histogram_load(const char *filename, uint64_t max_pixels, QuantizerHistogram *histogram, ImageHistogramProgress *progress, std::string &error);
+#endif /* GPICK_TOOLS_IMAGE_HISTOGRAM_H_ */
@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Octree.h"
+#include "Quantizer.h"
+#include "../Color.h"
+#include "../TreeReduce.h"
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+using namespace std;
+
+/** Approximate number of pixels in one band of rows, processed by one thread at a time */
+const int BandPixels = 1 << 18;
+/** Number of weighted colors in one band. Each color can create a new tree path, so bands are smaller than pixel bands */
+const size_t BandColors = 1 << 14;
+
+OctreeProgress::OctreeProgress():
+	rows_done(0),
+	cancel(false)
+{
+}
+
+/**
+ * Append a new empty node to the node array. References to existing nodes are invalidated
+ * @param[in] tree Tree
+ * @param[in] parent Parent node index
+ * @return Index of new node
+ */
+static uint32_t node_new(Octree *tree, uint32_t parent){
+	OctreeNode n;
+	n.color[0] = n.color[1] = n.color[2] = 0;
+	n.distance = 0;
+	n.n_pixels = 0;
+	n.n_pixels_in = 0;
+	n.parent = parent;
+	for (int i = 0; i < 8; i++){
+		n.child[i] = 0;
+	}
+	tree->nodes.push_back(n);
+	return tree->nodes.size() - 1;
+}
+
+Octree* octree_new(){
+	Octree *tree = new Octree;
+	node_new(tree, 0);
+	return tree;
+}
+
+void octree_delete(Octree *tree){
+	delete tree;
+}
+
+Octree* octree_copy(const Octree *tree){
+	return new Octree(*tree);
+}
+
+static uint32_t compact_node(const Octree *tree, uint32_t index, Octree *result, uint32_t parent){
+	uint32_t new_index = result->nodes.size();
+	result->nodes.push_back(tree->nodes[index]);
+	result->nodes[new_index].parent = parent;
+	for (int i = 0; i < 8; i++){
+		uint32_t child = tree->nodes[index].child[i];
+		if (child){
+			uint32_t new_child = compact_node(tree, child, result, new_index);
+			result->nodes[new_index].child[i] = new_child;
+		}
+	}
+	return new_index;
+}
+
+void octree_compact(Octree *tree){
+	Octree result;
+	compact_node(tree, 0, &result, 0);
+	result.nodes.shrink_to_fit();
+	tree->nodes.swap(result.nodes);
+}
+
+static void merge_node(Octree *tree, uint32_t index, const Octree *source, uint32_t source_index){
+	const OctreeNode &from = source->nodes[source_index];
+	OctreeNode &node = tree->nodes[index];
+	node.n_pixels += from.n_pixels;
+	node.n_pixels_in += from.n_pixels_in;
+	node.color[0] += from.color[0];
+	node.color[1] += from.color[1];
+	node.color[2] += from.color[2];
+	node.distance += from.distance;
+
+	for (int i = 0; i < 8; i++){
+		if (from.child[i]){
+			uint32_t child = tree->nodes[index].child[i];
+			if (!child){
+				child = node_new(tree, index);
+				tree->nodes[index].child[i] = child;
+			}
+			merge_node(tree, child, source, from.child[i]);
+		}
+	}
+}
+
+void octree_merge(Octree *tree, const Octree *source){
+	merge_node(tree, 0, source, 0);
+}
+
+static uint32_t count_leafs(const Octree *tree, uint32_t index){
+	const OctreeNode &node = tree->nodes[index];
+	uint32_t r = 0;
+	if (node.n_pixels_in) r++;
+	for (int i = 0; i < 8; i++){
+		if (node.child[i])
+			r += count_leafs(tree, node.child[i]);
+	}
+	return r;
+}
+
+uint32_t octree_count_leafs(const Octree *tree){
+	return count_leafs(tree, 0);
+}
+
+static void leaf_callback(const Octree *tree, uint32_t index, void (*leaf_cb)(const OctreeNode* node, void* userdata), void* userdata){
+	const OctreeNode &node = tree->nodes[index];
+	if (node.n_pixels_in > 0) leaf_cb(&node, userdata);
+
+	for (int i = 0; i < 8; i++){
+		if (node.child[i])
+			leaf_callback(tree, node.child[i], leaf_cb, userdata);
+	}
+}
+
+void octree_leaf_callback(const Octree *tree, void (*leaf_cb)(const OctreeNode* node, void* userdata), void* userdata){
+	leaf_callback(tree, 0, leaf_cb, userdata);
+}
+
+void octree_reduce(Octree *tree, uint32_t colors){
+	tree_reduce(tree->nodes, -1, colors, [](const OctreeNode &node){
+		return node.n_pixels_in > 0;
+	}, [](OctreeNode &parent, const OctreeNode &node){
+		parent.n_pixels_in += node.n_pixels_in;
+
+		parent.color[0] += node.color[0];
+		parent.color[1] += node.color[1];
+		parent.color[2] += node.color[2];
+	});
+}
+
+void octree_get_colors(const Octree *tree, vector<Color> &colors){
+	colors.clear();
+	octree_leaf_callback(tree, [](const OctreeNode *node, void *userdata){
+		Color c;
+		c.xyz.x = node->color[0] / node->n_pixels_in;
+		c.xyz.y = node->color[1] / node->n_pixels_in;
+		c.xyz.z = node->color[2] / node->n_pixels_in;
+		static_cast<vector<Color>*>(userdata)->push_back(c);
+	}, &colors);
+}
+
+void octree_update(Octree *tree, uint32_t index, const Color *color, uint32_t weight, const OctreeCube *cube, uint32_t max_depth){
+	OctreeCube current = *cube, new_cube;
+
+	for (;;){
+		new_cube.w = current.w / 2;
+		new_cube.h = current.h / 2;
+		new_cube.d = current.d / 2;
+
+		OctreeNode *node = &tree->nodes[index];
+		node->n_pixels += weight;
+
+		node->distance += weight * ((color->xyz.x - (current.x + new_cube.w)) * (color->xyz.x - (current.x + new_cube.w)) +
+			(color->xyz.y - (current.y + new_cube.h)) * (color->xyz.y - (current.y + new_cube.h)) +
+			(color->xyz.z - (current.z + new_cube.d)) * (color->xyz.z - (current.z + new_cube.d)));
+
+		if (!max_depth){
+			node->n_pixels_in += weight;
+
+			node->color[0] += weight * color->xyz.x;
+			node->color[1] += weight * color->xyz.y;
+			node->color[2] += weight * color->xyz.z;
+			return;
+		}
+
+		int x, y, z;
+
+		if (color->xyz.x - current.x < new_cube.w)
+			x = 0;
+		else
+			x = 1;
+
+		if (color->xyz.y - current.y < new_cube.h)
+			y = 0;
+		else
+			y = 1;
+
+		if (color->xyz.z - current.z < new_cube.d)
+			z = 0;
+		else
+			z = 1;
+
+		new_cube.x = current.x + new_cube.w * x;
+		new_cube.y = current.y + new_cube.h * y;
+		new_cube.z = current.z + new_cube.d * z;
+
+		int i = x | (y<<1) | (z<<2);
+
+		if (!node->child[i]){
+			// Adding a node can move the node array
+			uint32_t child = node_new(tree, index);
+			node = &tree->nodes[index];
+			node->child[i] = child;
+		}
+
+		node->n_pixels += weight;
+
+		index = node->child[i];
+		current = new_cube;
+		max_depth--;
+	}
+}
+
+void octree_add_color(Octree *tree, const Color *color, uint32_t weight, uint32_t max_depth){
+	OctreeCube cube;
+	cube.x = 0;
+	cube.y = 0;
+	cube.z = 0;
+	cube.w = 1;
+	cube.h = 1;
+	cube.d = 1;
+	octree_update(tree, 0, color, weight, &cube, max_depth);
+}
+
+static void add_rows(Octree *tree, const unsigned char *data, int channels, int width, int row_begin, int row_end, int rowstride, uint32_t max_depth, vector<Color> &row){
+	OctreeCube cube;
+	cube.x = 0;
+	cube.y = 0;
+	cube.z = 0;
+	cube.w = 1;
+	cube.h = 1;
+	cube.d = 1;
+
+	for (int y = row_begin; y < row_end; y++){
+		color_rgb8_to_rgb_batch(data + rowstride * y, channels, width, row.data());
+		for (int x = 0; x < width; x++){
+			octree_update(tree, 0, &row[x], 1, &cube, max_depth);
+		}
+	}
+}
+
+void octree_add_rgb8(Octree *tree, const unsigned char *data, int channels, int width, int height, int rowstride, uint32_t max_depth){
+	octree_add_rgb8_parallel(tree, data, channels, width, height, rowstride, max_depth, 1, nullptr);
+}
+
+/**
+ * Add bands to the tree using multiple threads. Each band is added to a separate tree by add_band and band trees are merged strictly in band order, so the result does not depend on thread count.
+ * @param[in] add_band Function adding band to an empty tree, returns number of image rows to report as progress
+ * @return False if construction was cancelled
+ */
+template<typename AddBand>
+static bool add_bands_parallel(Octree *tree, int band_count, unsigned int threads, OctreeProgress *progress, AddBand add_band){
+	if (band_count <= 0) return true;
+	if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+	threads = min(threads, static_cast<unsigned int>(band_count));
+
+	// Band trees finished out of order wait in band_trees
+	vector<Octree*> band_trees(band_count, nullptr);
+	int next_band = 0, next_merge = 0;
+	bool cancelled = false, merging = false;
+	mutex lock;
+	auto worker = [&](){
+		for (;;){
+			int band;
+			{
+				lock_guard<mutex> guard(lock);
+				if (cancelled || next_band == band_count) return;
+				band = next_band++;
+			}
+			Octree *band_tree = octree_new();
+			int rows = add_band(band_tree, band);
+			unique_lock<mutex> guard(lock);
+			band_trees[band] = band_tree;
+			if (progress){
+				progress->rows_done += rows;
+				if (progress->cancel) cancelled = true;
+			}
+			// One thread at a time takes ready band trees off the queue in band order and merges them without holding the lock
+			if (merging) continue;
+			merging = true;
+			while (next_merge < band_count && band_trees[next_merge]){
+				Octree *merge_tree = band_trees[next_merge];
+				band_trees[next_merge] = nullptr;
+				guard.unlock();
+				octree_merge(tree, merge_tree);
+				octree_delete(merge_tree);
+				guard.lock();
+				next_merge++;
+			}
+			merging = false;
+		}
+	};
+	vector<thread> pool;
+	for (unsigned int i = 1; i < threads; i++){
+		pool.emplace_back(worker);
+	}
+	worker();
+	for (auto &t: pool){
+		t.join();
+	}
+	for (auto band_tree: band_trees){
+		if (band_tree) octree_delete(band_tree);
+	}
+	return next_merge == band_count;
+}
+
+bool octree_add_rgb8_parallel(Octree *tree, const unsigned char *data, int channels, int width, int height, int rowstride, uint32_t max_depth, unsigned int threads, OctreeProgress *progress){
+	if (width <= 0 || height <= 0) return true;
+	int band_rows = max(1, BandPixels / width);
+	int band_count = (height + band_rows - 1) / band_rows;
+	return add_bands_parallel(tree, band_count, threads, progress, [&](Octree *band_tree, int band){
+		vector<Color> row(width);
+		int row_begin = band * band_rows;
+		int row_end = min(row_begin + band_rows, height);
+		add_rows(band_tree, data, channels, width, row_begin, row_end, rowstride, max_depth, row);
+		return row_end - row_begin;
+	});
+}
+
+bool octree_add_colors_parallel(Octree *tree, const QuantizerColor *colors, size_t count, uint32_t max_depth, unsigned int threads, OctreeProgress *progress){
+	int band_count = static_cast<int>((count + BandColors - 1) / BandColors);
+	return add_bands_parallel(tree, band_count, threads, progress, [&](Octree *band_tree, int band){
+		size_t end = min(count, size_t(band + 1) * BandColors);
+		for (size_t i = size_t(band) * BandColors; i < end; i++){
+			octree_add_color(band_tree, &colors[i].color, colors[i].weight, max_depth);
+		}
+		return 0;
+	});
+}
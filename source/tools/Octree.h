@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_TOOLS_OCTREE_H_
+#define GPICK_TOOLS_OCTREE_H_
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+struct Color;
+struct QuantizerColor;
+
+/** \file source/tools/Octree.h
+ * \brief Octree color quantization used to build palettes from images.
+ */
+
+/** \struct OctreeNode
+ * \brief Node is a cube in space with color information
+ */
+struct OctreeNode{
+	uint32_t n_pixels; /**< Number of colors in current Node and its children */
+	uint32_t n_pixels_in; /**< Number of colors in current Node */
+	float color[3]; /**< Sum of color values */
+	float distance; /**< Squared distances from Node center of colors in Node */
+	uint32_t child[8]; /**< Indices of child Nodes, 0 if there is no child */
+	uint32_t parent; /**< Index of parent Node, 0 for root Node */
+};
+
+/** \struct Octree
+ * \brief Tree with all nodes stored in a single array.
+ * Root node has index 0. Nodes removed by reduction stay in the array unreferenced until octree_compact is called.
+ */
+struct Octree{
+	std::vector<OctreeNode> nodes;
+};
+
+/** \struct OctreeCube
+ * \brief Cube structure holds all information necessary to define cube size and position in space
+ */
+struct OctreeCube{
+	float x; /**< X position */
+	float w; /**< Width */
+	float y; /**< Y position */
+	float h; /**< Height */
+	float z; /**< Z position */
+	float d; /**< Depth */
+};
+
+/** \struct OctreeProgress
+ * \brief Progress of tree construction, shared between worker threads and the caller
+ */
+struct OctreeProgress{
+	std::atomic<int> rows_done; /**< Number of image rows added to the tree */
+	std::atomic<bool> cancel; /**< Set to true to stop construction */
+	OctreeProgress();
+};
+
+/**
+ * Allocate a new tree with empty root node
+ * @return New tree
+ */
+Octree* octree_new();
+
+/**
+ * Deallocate tree
+ * @param[in] tree Tree to deallocate
+ */
+void octree_delete(Octree *tree);
+
+/**
+ * Copy tree. Node array is copied as a whole, so run octree_compact on trees which are copied often
+ * @param[in] tree Tree to copy
+ * @return A copy of tree
+ */
+Octree* octree_copy(const Octree *tree);
+
+/**
+ * Remove unreferenced nodes from node array
+ * @param[in] tree Tree
+ */
+void octree_compact(Octree *tree);
+
+/**
+ * Add color information of source tree to tree
+ * @param[in] tree Destination tree, missing nodes are created
+ * @param[in] source Source tree
+ */
+void octree_merge(Octree *tree, const Octree *source);
+
+/**
+ * Get the number of nodes with available color information in them
+ * @param[in] tree Tree
+ * @return Number of nodes with available color information in them
+ */
+uint32_t octree_count_leafs(const Octree *tree);
+
+/**
+ * Call callback on all nodes with available color information in them
+ * @param[in] tree Tree
+ * @param[in] leaf_cb Callback function
+ * @param[in] userdata User supplied pointer which is passed when calling callback
+ */
+void octree_leaf_callback(const Octree *tree, void (*leaf_cb)(const OctreeNode* node, void* userdata), void* userdata);
+
+/**
+ * Merge nodes with the smallest color distances until no more than specified number of colors is left
+ * @param[in] tree Tree
+ * @param[in] colors Maximum number of colors
+ */
+void octree_reduce(Octree *tree, uint32_t colors);
+
+/**
+ * Get average colors of all nodes with available color information in them
+ * @param[in] tree Tree
+ * @param[out] colors Average colors
+ */
+void octree_get_colors(const Octree *tree, std::vector<Color> &colors);
+
+/**
+ * Add color to the node and its children
+ * @param[in] tree Tree
+ * @param[in] node Node index
+ * @param[in] color Color
+ * @param[in] weight Number of times color is added
+ * @param[in] cube Space occupied by the node
+ * @param[in] max_depth Number of levels below node
+ */
+void octree_update(Octree *tree, uint32_t node, const Color *color, uint32_t weight, const OctreeCube *cube, uint32_t max_depth);
+
+/**
+ * Add color to the tree
+ * @param[in] tree Tree covering unit RGB cube
+ * @param[in] color Color
+ * @param[in] weight Number of times color is added
+ * @param[in] max_depth Number of levels below root node
+ */
+void octree_add_color(Octree *tree, const Color *color, uint32_t weight, uint32_t max_depth);
+
+/**
+ * Add all pixels of 8-bit per channel image to the tree
+ * @param[in] tree Tree covering unit RGB cube
+ * @param[in] data Image data
+ * @param[in] channels Number of channels in each pixel, first three are red, green and blue
+ * @param[in] width Image width
+ * @param[in] height Image height
+ * @param[in] rowstride Number of bytes between rows
+ * @param[in] max_depth Number of levels below root node
+ */
+void octree_add_rgb8(Octree *tree, const unsigned char *data, int channels, int width, int height, int rowstride, uint32_t max_depth);
+
+/**
+ * Add all pixels of 8-bit per channel image to the tree using multiple threads.
+ * Image is split into bands of rows which do not depend on thread count, each band is added to a separate tree and band trees are merged in image order, so the result is identical for any number of threads.
+ * @param[in] tree Tree covering unit RGB cube
+ * @param[in] data Image data
+ * @param[in] channels Number of channels in each pixel, first three are red, green and blue
+ * @param[in] width Image width
+ * @param[in] height Image height
+ * @param[in] rowstride Number of bytes between rows
+ * @param[in] max_depth Number of levels below root node
+ * @param[in] threads Number of threads, 0 to use one thread for each processor
+ * @param[in,out] progress Progress information, can be nullptr
+ * @return False if construction was cancelled, tree then contains only a part of the image
+ */
+bool octree_add_rgb8_parallel(Octree *tree, const unsigned char *data, int channels, int width, int height, int rowstride, uint32_t max_depth, unsigned int threads, OctreeProgress *progress);
+
+/**
+ * Add weighted colors to the tree using multiple threads.
+ * Colors are split into bands which do not depend on thread count, each band is added to a separate tree and band trees are merged in order, so the result is identical for any number of threads.
+ * @param[in] tree Tree covering unit RGB cube
+ * @param[in] colors Colors with weights
+ * @param[in] count Number of colors
+ * @param[in] max_depth Number of levels below root node
+ * @param[in] threads Number of threads, 0 to use one thread for each processor
+ * @param[in,out] progress Cancellation flag, number of rows is not updated. Can be nullptr
+ * @return False if construction was cancelled, tree then contains only a part of the colors
+ */
+bool octree_add_colors_parallel(Octree *tree, const QuantizerColor *colors, size_t count, uint32_t max_depth, unsigned int threads, OctreeProgress *progress);
+#endif /* GPICK_TOOLS_OCTREE_H_ */
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PaletteCache.h"
+#include "../FileCache.h"
+#include "../Paths.h"
+#include "../MathUtil.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <fstream>
+#include <algorithm>
+using namespace std;
+
+/** Cache format version. Must be increased when file layout, source validation or histogram building changes. */
+const uint32_t CacheVersion = 2;
+const char CacheMagic[8] = {'G', 'P', 'C', 'P', 'A', 'L', 0, 0};
+const char CacheDirectory[] = "palette_cache";
+/** Files up to this size are always validated by content hash, as modification time resolution of some file systems is too coarse to notice quick rewrites */
+const uint64_t AlwaysHashSize = 1024 * 1024;
+
+struct CacheHeader
+{
+	FileCacheHeader file;
+	uint64_t max_pixels;
+	uint64_t color_count;
+};
+
+/** \struct CacheEntry
+ * \brief Histogram color stored as packed 24-bit RGB value and weight
+ */
+struct CacheEntry
+{
+	uint32_t color;
+	uint32_t weight;
+};
+
+static string cache_directory()
+{
+	gchar *path = build_config_path(CacheDirectory);
+	string result(path);
+	g_free(path);
+	return result;
+}
+static string cache_filename(const char *filename, uint64_t max_pixels)
+{
+	string name = file_cache_name(filename, &max_pixels, sizeof(max_pixels)) + ".cache";
+	gchar *path = g_build_filename(cache_directory().c_str(), name.c_str(), nullptr);
+	string result(path);
+	g_free(path);
+	return result;
+}
+bool palette_cache_load(const char *filename, uint64_t max_pixels, vector<QuantizerColor> &histogram)
+{
+	FileCacheSource source;
+	if (!file_cache_source_stat(filename, source)) return false;
+	string path = cache_filename(filename, max_pixels);
+	fstream file(path.c_str(), ios::binary | ios::in | ios::out);
+	if (!file.is_open()) return false;
+	CacheHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+	if (!file_cache_header_check(header.file, CacheMagic, CacheVersion)) return false;
+	if (header.file.source_size != source.size || header.max_pixels != max_pixels) return false;
+	bool modified = header.file.source_modification_time != source.modification_time;
+	if (modified || source.size <= AlwaysHashSize){
+		uint64_t hash;
+		if (!file_cache_hash_file(filename, hash) || hash != header.file.source_hash) return false;
+	}
+	if (modified){
+		// Content is unchanged, store new modification time so that the file is not hashed again on next load
+		header.file.source_modification_time = source.modification_time;
+		file.seekp(0);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.seekg(sizeof(header));
+	}
+	if (header.color_count > (1 << 24)) return false;
+	vector<CacheEntry> entries(header.color_count);
+	if (!file.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(CacheEntry))) return false;
+	file.close();
+	histogram.resize(entries.size());
+	for (size_t i = 0; i < entries.size(); i++){
+		uint32_t color = entries[i].color;
+		unsigned char rgb[3] = {static_cast<unsigned char>(color & 0xff), static_cast<unsigned char>((color >> 8) & 0xff), static_cast<unsigned char>((color >> 16) & 0xff)};
+		color_rgb8_to_rgb_batch(rgb, 3, 1, &histogram[i].color);
+		histogram[i].color.ma[3] = 0;
+		histogram[i].weight = entries[i].weight;
+	}
+	// Update modification time, which is used to find least recently used entries
+	g_utime(path.c_str(), nullptr);
+	return true;
+}
+/** \struct CacheFile
+ * \brief Cache file found in cache directory
+ */
+struct CacheFile
+{
+	string path;
+	uint64_t size;
+	int64_t modification_time;
+};
+static void remove_least_recently_used(uint64_t size_limit)
+{
+	string directory = cache_directory();
+	GDir *dir = g_dir_open(directory.c_str(), 0, nullptr);
+	if (!dir) return;
+	vector<CacheFile> files;
+	uint64_t total_size = 0;
+	const gchar *name;
+	while ((name = g_dir_read_name(dir))){
+		if (!g_str_has_suffix(name, ".cache")) continue;
+		gchar *path = g_build_filename(directory.c_str(), name, nullptr);
+		GStatBuf sb;
+		if (g_stat(path, &sb) == 0){
+			CacheFile file;
+			file.path = path;
+			file.size = sb.st_size;
+			file.modification_time = sb.st_mtime;
+			files.push_back(file);
+			total_size += file.size;
+		}
+		g_free(path);
+	}
+	g_dir_close(dir);
+	sort(files.begin(), files.end(), [](const CacheFile &a, const CacheFile &b){
+		return a.modification_time < b.modification_time;
+	});
+	for (auto &file: files){
+		if (total_size <= size_limit) break;
+		if (g_remove(file.path.c_str()) == 0)
+			total_size -= file.size;
+	}
+}
+bool palette_cache_save(const char *filename, uint64_t max_pixels, const vector<QuantizerColor> &histogram, uint64_t size_limit)
+{
+	FileCacheSource source;
+	if (!file_cache_source_stat(filename, source)) return false;
+	if (!file_cache_hash_file(filename, source.hash)) return false;
+	if (sizeof(CacheHeader) + histogram.size() * sizeof(CacheEntry) > size_limit) return false;
+	CacheHeader header;
+	memset(&header, 0, sizeof(header));
+	file_cache_header_init(header.file, CacheMagic, CacheVersion, source);
+	header.max_pixels = max_pixels;
+	header.color_count = histogram.size();
+	vector<CacheEntry> entries(histogram.size());
+	for (size_t i = 0; i < histogram.size(); i++){
+		uint32_t color = 0;
+		for (int j = 0; j < 3; j++){
+			color |= clamp_int(int(histogram[i].color.ma[j] * 255 + 0.5f), 0, 255) << (j * 8);
+		}
+		entries[i].color = color;
+		entries[i].weight = histogram[i].weight;
+	}
+	string directory = cache_directory();
+#ifndef _MSC_VER
+	g_mkdir_with_parents(directory.c_str(), S_IRWXU);
+#else
+	g_mkdir_with_parents(directory.c_str(), 0);
+#endif
+	string path = cache_filename(filename, max_pixels);
+	bool result = file_cache_write(path.c_str(), [&](ostream &file){
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(CacheEntry));
+	});
+	if (!result) return false;
+	remove_least_recently_used(size_limit);
+	return true;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_TOOLS_PALETTE_CACHE_H_
+#define GPICK_TOOLS_PALETTE_CACHE_H_
+#include "Quantizer.h"
+#include <stdint.h>
+#include <vector>
+
+/** \file source/tools/PaletteCache.h
+ * \brief Persistent cache of image color histograms used for palette extraction.
+ *
+ * Cache files are stored in user configuration directory. Each file is validated by image file size,
+ * modification time and content hash, and by sampling parameters used to build the histogram.
+ * Least recently used files are removed when total cache size exceeds the limit.
+ */
+
+/** Default total size of cache files */
+const uint64_t PaletteCacheDefaultSizeLimit = 64 * 1024 * 1024;
+
+/**
+ * Load cached image histogram
+ * @param[in] filename Image file name
+ * @param[in] max_pixels Pixel limit used when building histogram
+ * @param[out] histogram Image histogram
+ * @return True if valid cache entry was found
+ */
+bool palette_cache_load(const char *filename, uint64_t max_pixels, std::vector<QuantizerColor> &histogram);
+
+/**
+ * Store image histogram in the cache and remove least recently used entries exceeding size limit
+ * @param[in] filename Image file name
+ * @param[in] max_pixels Pixel limit used when building histogram
+ * @param[in] histogram Image histogram with 8-bit per channel colors
+ * @param[in] size_limit Maximum total size of cache files in bytes
+ * @return True on success
+ */
+bool palette_cache_save(const char *filename, uint64_t max_pixels, const std::vector<QuantizerColor> &histogram, uint64_t size_limit = PaletteCacheDefaultSizeLimit);
+#endif /* GPICK_TOOLS_PALETTE_CACHE_H_ */
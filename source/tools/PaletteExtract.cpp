@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PaletteExtract.h"
+#include "Quantizer.h"
+#include "ImageHistogram.h"
+#include "../GlobalState.h"
+#include "../ColorList.h"
+#include "../ColorObject.h"
+#include "../ImportExport.h"
+#include "../Converters.h"
+#include "../dynv/DynvSystem.h"
+#include <boost/filesystem.hpp>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <set>
+using namespace std;
+
+PaletteExtractOptions::PaletteExtractOptions():
+	colors(8),
+	quantizer(quantizers_get()),
+	format("gpl"),
+	max_pixels(16 * 1024 * 1024),
+	threads(0)
+{
+}
+
+static boost::filesystem::path get_output_path(const PaletteExtractOptions &options, const string &filename){
+	boost::filesystem::path path(filename);
+	path.replace_extension("." + options.format);
+	if (!options.output_directory.empty())
+		path = boost::filesystem::path(options.output_directory) / path.filename();
+	return path;
+}
+
+/**
+ * Get output file name for each image. Images with the same name in different directories would overwrite each other's palettes in output directory,
+ * so repeated output names get a numeric suffix.
+ */
+static vector<string> get_output_filenames(const PaletteExtractOptions &options, const vector<string> &filenames){
+	vector<string> result;
+	set<string> used;
+	for (auto &filename: filenames){
+		boost::filesystem::path path = get_output_path(options, filename);
+		string output_filename = path.string();
+		for (int suffix = 2; used.count(output_filename); suffix++){
+			stringstream ss;
+			ss << path.stem().string() << "_" << suffix << path.extension().string();
+			output_filename = (path.parent_path() / ss.str()).string();
+		}
+		if (output_filename != path.string())
+			cerr << filename << ": output file " << path.string() << " is already used, writing " << output_filename << endl;
+		used.insert(output_filename);
+		result.push_back(output_filename);
+	}
+	return result;
+}
+
+static bool write_palette(GlobalState *gs, FileType type, const string &filename, const string &output_filename, const vector<Color> &palette){
+	struct dynvHandlerMap *handler_map = dynv_system_get_handler_map(gs->getSettings());
+	ColorList *color_list = color_list_new(handler_map);
+	dynv_handler_map_release(handler_map);
+	string name = boost::filesystem::path(filename).filename().string();
+	stringstream ss;
+	for (size_t i = 0; i < palette.size(); i++){
+		ColorObject *color_object = color_list_new_color_object(color_list, &palette[i]);
+		ss.str("");
+		ss << name << " #" << i;
+		color_object->setName(ss.str());
+		color_list_add_color_object(color_list, color_object, true);
+		color_object->release();
+	}
+	ImportExport import_export(color_list, output_filename.c_str(), gs);
+	import_export.setConverter(gs->converters().firstCopyOrAny());
+	import_export.setConverters(&gs->converters());
+	bool result = import_export.exportType(type);
+	if (!result)
+		cerr << output_filename << ": could not write palette" << endl;
+	color_list_destroy(color_list);
+	return result;
+}
+
+int tools_palette_extract(GlobalState *gs, const PaletteExtractOptions &options, const vector<string> &filenames){
+	FileType type = ImportExport::getFileTypeByExtension(("." + options.format).c_str());
+	if (type == FileType::unknown || type == FileType::rgbtxt){
+		cerr << "Unsupported output format \"" << options.format << "\"" << endl;
+		return -1;
+	}
+	if (!options.quantizer || options.colors == 0){
+		cerr << "Invalid quantizer settings" << endl;
+		return -1;
+	}
+	unsigned int threads = options.threads;
+	if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+	threads = min(threads, static_cast<unsigned int>(max<size_t>(1, filenames.size())));
+	vector<string> output_filenames = get_output_filenames(options, filenames);
+	atomic<size_t> next_file(0);
+	int failed = 0;
+	mutex lock; // Color lists, converters and output are not thread safe
+	auto worker = [&](){
+		QuantizerHistogram *histogram = quantizer_histogram_new();
+		vector<QuantizerColor> colors;
+		vector<Color> palette;
+		for (;;){
+			size_t index = next_file++;
+			if (index >= filenames.size()) break;
+			const string &filename = filenames[index];
+			string error;
+			quantizer_histogram_clear(histogram);
+			bool loaded = image_histogram_load(filename.c_str(), options.max_pixels, histogram, nullptr, error);
+			if (loaded){
+				quantizer_histogram_get_colors(histogram, colors);
+				options.quantizer->quantize(colors.data(), colors.size(), options.colors, palette);
+			}
+			lock_guard<mutex> guard(lock);
+			if (!loaded){
+				cerr << filename << ": " << error << endl;
+				failed++;
+			}else if (!write_palette(gs, type, filename, output_filenames[index], palette)){
+				failed++;
+			}
+		}
+		quantizer_histogram_destroy(histogram);
+	};
+	vector<thread> pool;
+	for (unsigned int i = 1; i < threads; i++){
+		pool.emplace_back(worker);
+	}
+	worker();
+	for (auto &t: pool){
+		t.join();
+	}
+	return failed;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_TOOLS_PALETTE_EXTRACT_H_
+#define GPICK_TOOLS_PALETTE_EXTRACT_H_
+#include <stdint.h>
+#include <string>
+#include <vector>
+struct GlobalState;
+struct Quantizer;
+
+/** \file source/tools/PaletteExtract.h
+ * \brief Palette extraction from image files without user interface.
+ */
+
+/** \struct PaletteExtractOptions
+ * \brief Palette extraction settings
+ */
+struct PaletteExtractOptions{
+	uint32_t colors; /**< Maximum number of colors in each palette */
+	const Quantizer *quantizer;
+	std::string format; /**< Output file extension without dot: gpl, gpa, txt, etc. */
+	std::string output_directory; /**< Palettes are written next to images when empty */
+	uint64_t max_pixels; /**< Larger images are sampled with a stride, 0 disables the limit */
+	unsigned int threads; /**< Number of worker threads, 0 uses all available cores */
+	PaletteExtractOptions();
+};
+
+/**
+ * Extract palette from each image file and write it into a file with the same name and output format extension.
+ * Images are processed in parallel, errors are reported to standard error.
+ * When several images would write the same output file, later ones get a numeric suffix, e.g. "photo_2.gpl".
+ * @param[in] gs Global state with loaded settings and converters
+ * @param[in] options Extraction settings
+ * @param[in] filenames Image file names
+ * @return Number of images which could not be processed, or -1 if options are invalid
+ */
+int tools_palette_extract(GlobalState *gs, const PaletteExtractOptions &options, const std::vector<std::string> &filenames);
+#endif /* GPICK_TOOLS_PALETTE_EXTRACT_H_ */
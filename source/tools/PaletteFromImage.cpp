@@ -17,6 +17,10 @@
  */
 
 #include "PaletteFromImage.h"
+#include "Octree.h"
+#include "Quantizer.h"
+#include "ImageHistogram.h"
+#include "PaletteCache.h"
 #include "../ColorList.h"
 #include "../ColorObject.h"
 #include "../uiUtilities.h"
@@ -29,48 +33,57 @@
 #include <iostream>
 #include <sstream>
 #include <stack>
+#include <vector>
 #include <string>
+#include <thread>
+#include <atomic>
 using namespace std;
 
 /** \file PaletteFromImage.cpp
  * \brief
  */
 
-/** \struct Node
- * \brief Node is a cube in space with color information
- *
- * Each node can b
- */
-struct Node{
-	uint32_t n_pixels; /**< Number of colors in current Node and its children */
-	uint32_t n_pixels_in; /**< Number of colors in current Node */
-	float color[3]; /**< Sum of color values */
-	float distance; /**< Squared distances from Node center of colors in Node */
-	Node *child[8]; /**< Pointers to child Nodes */
-	Node *parent; /**< Pointer to parent Node */
-};
-
-/** \struct Cube
- * \brief Cube structure holds all information necessary to define cube size and position in space
+/** \struct PaletteFromImageJob
+ * \brief Image processing job. Owned by dialog while it runs, cancelled jobs are released when their thread finishes.
  */
-struct Cube{
-	float x; /**< X position */
-	float w; /**< Width */
-	float y; /**< Y position */
-	float h; /**< Height */
-	float z; /**< Z position */
-	float d; /**< Depth */
+struct PaletteFromImageJob{
+	string filename;
+	uint64_t max_pixels;
+	bool use_cache;
+	std::thread thread;
+	ImageHistogramProgress progress;
+	OctreeProgress tree_progress; /**< Cancellation of octree construction */
+	std::atomic<bool> done;
+	Octree *tree; /**< Result of image processing, nullptr on failure */
+	vector<QuantizerColor> histogram;
+	PaletteFromImageJob():
+		done(false),
+		tree(nullptr)
+	{
+	}
+	~PaletteFromImageJob(){
+		if (tree) octree_delete(tree);
+	}
 };
 
 struct PaletteFromImageArgs{
 	GtkWidget *file_browser;
 	GtkWidget *range_colors;
 	GtkWidget *merge_threshold;
+	GtkWidget *quantizer_combo;
 	GtkWidget *preview_expander;
 	string filename;
 	uint32_t n_colors;
+	const Quantizer *quantizer;
 	string previous_filename;
-	Node *previous_node;
+	uint64_t max_pixels; /**< Larger images are sampled with a stride */
+	bool use_cache; /**< Keep image histograms in persistent cache */
+	Octree *previous_tree; /**< Tree of previous image reduced to 200 colors */
+	vector<QuantizerColor> histogram; /**< Distinct colors of previous image */
+	GtkWidget *progress_bar;
+	PaletteFromImageJob *job; /**< Running image processing job, nullptr if there is none */
+	guint progress_timeout;
+	bool apply_pending; /**< Add colors to palette when image processing finishes */
 	ColorList *color_list;
 	ColorList *preview_color_list;
 	struct dynvSystem *params;
@@ -102,288 +115,134 @@ struct PaletteColorNameAssigner: public ToolColorNameAssigner {
 		}
 };
 
-/**
- * Allocate and initialize a new node with specified parent
- * @param[in] parent Parent node
- * @return New node
- */
-static Node* node_new(Node *parent){
-	Node *n = new Node;
-	n->color[0] = n->color[1] = n->color[2] = 0;
-	n->distance = 0;
-	n->n_pixels = 0;
-	n->n_pixels_in = 0;
-	n->parent = parent;
-	for (int i = 0; i < 8; i++){
-		n->child[i] = 0;
-	}
-	return n;
-}
+static void leaf_cb(const OctreeNode *node, void *userdata){
+	list<Color> *l = static_cast<list<Color>*>(userdata);
 
-/**
- * Deallocate node and its children
- * @param[in] node Node to deallocate
- */
-static void node_delete(Node *node){
-	for (int i = 0; i < 8; i++){
-		if (node->child[i]){
-			node_delete(node->child[i]);
-		}
-	}
+	Color c;
+	c.xyz.x = node->color[0] / node->n_pixels_in;
+	c.xyz.y = node->color[1] / node->n_pixels_in;
+	c.xyz.z = node->color[2] / node->n_pixels_in;
 
-	delete node;
+	l->push_back(c);
 }
 
 /**
- * Copy node and assing new parent
- * @param[in] node Node to copy
- * @param[in] parent Parent of copied node
- * @return A copy of node
+ * Decode image or load its histogram from cache, build reduced octree, runs in worker thread.
  */
-static Node* node_copy(Node *node, Node *parent){
-	Node *n = node_new(0);
-	memcpy(n, node, sizeof(Node));
-	n->parent = parent;
-
-	for (int i = 0; i < 8; i++){
-		if (node->child[i]){
-			n->child[i] = node_copy(node->child[i], n);
-		}else{
-			n->child[i] = 0;
+static void process_image(PaletteFromImageJob *job){
+	const string &filename = job->filename;
+	if (!job->use_cache || !palette_cache_load(filename.c_str(), job->max_pixels, job->histogram)){
+		// Images usually contain far fewer distinct colors than pixels, so only distinct colors are inserted into the octree
+		QuantizerHistogram *histogram = quantizer_histogram_new();
+		string error;
+		if (!image_histogram_load(filename.c_str(), job->max_pixels, histogram, &job->progress, error)){
+			if (!job->progress.cancel) cout << error << endl;
+			quantizer_histogram_destroy(histogram);
+			job->done = true;
+			return;
 		}
+		quantizer_histogram_get_colors(histogram, job->histogram);
+		quantizer_histogram_destroy(histogram);
+		if (job->use_cache && !job->progress.cancel)
+			palette_cache_save(filename.c_str(), job->max_pixels, job->histogram);
 	}
-	return n;
-}
-
-/**
- * Get the number of nodes with available color information in them
- * @param[in] node Start from this node
- * @return Number of nodes with available color information in them
- */
-static uint32_t node_count_leafs(Node *node){
-	uint32_t r = 0;
-	if (node->n_pixels_in) r++;
-	for (int i = 0; i < 8; i++){
-		if (node->child[i])
-			r += node_count_leafs(node->child[i]);
+	Octree *tree = octree_new();
+	if (job->progress.cancel || !octree_add_colors_parallel(tree, job->histogram.data(), job->histogram.size(), 5, 0, &job->tree_progress)){
+		octree_delete(tree);
+		job->done = true;
+		return;
 	}
-	return r;
+	octree_reduce(tree, 200);
+	octree_compact(tree);
+	job->tree = tree;
+	job->done = true;
 }
 
 /**
- * Call callback on all nodes with available color information in them
- * @param[in] node Start from this node
- * @param[in] leaf_cb Callback function
- * @param[in] userdata User supplied pointer which is passed when calling callback
+ * Join finished thread of cancelled job and release the job.
+ * @return True while the job is still running.
  */
-static void node_leaf_callback(Node *node, void (*leaf_cb)(Node* node, void* userdata), void* userdata){
-	if (node->n_pixels_in > 0) leaf_cb(node, userdata);
-
-	for (int i = 0; i < 8; i++){
-		if (node->child[i])
-			node_leaf_callback(node->child[i], leaf_cb, userdata);
-	}
+static gboolean release_cancelled_job(PaletteFromImageJob *job){
+	if (!job->done) return TRUE;
+	job->thread.join();
+	delete job;
+	return FALSE;
 }
 
 /**
- * Merge node information into its parent node
- * @param[in] node Node to merge
+ * Stop image processing and discard its result. Does not wait for the worker thread, it is released when it notices cancellation.
  */
-static void node_prune(Node *node){
-
-	for (int i = 0; i < 8; i++){
-		if (node->child[i]){
-			node_prune(node->child[i]);
-			node->child[i] = 0;
-
-		}
+static void cancel_processing(PaletteFromImageArgs *args){
+	if (args->progress_timeout){
+		g_source_remove(args->progress_timeout);
+		args->progress_timeout = 0;
 	}
-
-	if (node->parent){
-		node->parent->n_pixels_in += node->n_pixels_in;
-
-		node->parent->color[0] += node->color[0];
-		node->parent->color[1] += node->color[1];
-		node->parent->color[2] += node->color[2];
+	if (args->job){
+		args->job->progress.cancel = true;
+		args->job->tree_progress.cancel = true;
+		if (release_cancelled_job(args->job))
+			g_timeout_add(100, (GSourceFunc)release_cancelled_job, args->job);
+		args->job = nullptr;
 	}
-
-	node_delete(node);
+	args->apply_pending = false;
+	gtk_widget_hide(args->progress_bar);
 }
 
-typedef struct PruneData{
-	float threshold;
-	float min_distance;
-	uint32_t n_colors;
-	uint32_t n_colors_target;
-
-	Node *prune_node;
-	uint32_t distant_nodes;
-}PruneData;
-
-static bool node_prune_threshold(Node *node, PruneData *prune_data){
-	if (node->distance <= prune_data->threshold){
-		uint32_t colors_removed = node_count_leafs(node);
-		node_prune(node);
-		prune_data->n_colors -= colors_removed;
-		return true;
-	}
-
-	if (node->distance < prune_data->min_distance){
-		prune_data->min_distance = node->distance;
-	}
-
-	uint32_t n = node->n_pixels_in;
+static void calc(PaletteFromImageArgs *args, bool preview, int limit);
 
-	for (int i = 0; i < 8; i++){
-		if (node->child[i]){
-			if (node_prune_threshold(node->child[i], prune_data)){
-				node->child[i] = 0;
-			}
+static gboolean progress_cb(PaletteFromImageArgs *args){
+	PaletteFromImageJob *job = args->job;
+	if (!job->done){
+		int height = job->progress.rows;
+		if (height > 0){
+			gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(args->progress_bar), min(1.0, double(job->progress.rows_done) / height));
+		}else{
+			gtk_progress_bar_pulse(GTK_PROGRESS_BAR(args->progress_bar));
 		}
+		return TRUE;
 	}
-
-	if (node->n_pixels_in > 0 && n == 0) prune_data->n_colors++;
-
-	return false;
-}
-
-static void node_reduce(Node *node, uint32_t colors){
-	PruneData prune_data;
-	prune_data.n_colors = node_count_leafs(node);
-	prune_data.n_colors_target = colors;
-	prune_data.threshold = 0;
-
-	while (prune_data.n_colors > colors){
-		prune_data.min_distance = node->distance;
-
-		if (node_prune_threshold(node, &prune_data)) break;
-
-		prune_data.threshold = prune_data.min_distance;
-	}
-}
-
-static void node_update(Node *node, Color *color, Cube *cube, uint32_t max_depth){
-	Cube new_cube;
-
-	new_cube.w = cube->w / 2;
-	new_cube.h = cube->h / 2;
-	new_cube.d = cube->d / 2;
-
-	node->n_pixels++;
-
-	node->distance += (color->xyz.x - (cube->x + new_cube.w)) * (color->xyz.x - (cube->x + new_cube.w)) +
-		(color->xyz.y - (cube->y + new_cube.h)) * (color->xyz.y - (cube->y + new_cube.h)) +
-		(color->xyz.z - (cube->z + new_cube.d)) * (color->xyz.z - (cube->z + new_cube.d));
-
-	if (!max_depth){
-		node->n_pixels_in++;
-
-		node->color[0] += color->xyz.x;
-		node->color[1] += color->xyz.y;
-		node->color[2] += color->xyz.z;
-
-	}else{
-		int x, y, z;
-
-		if (color->xyz.x - cube->x < new_cube.w)
-			x = 0;
-		else
-			x = 1;
-
-		if (color->xyz.y - cube->y < new_cube.h)
-			y = 0;
-		else
-			y = 1;
-
-		if (color->xyz.z - cube->z < new_cube.d)
-			z = 0;
-		else
-			z = 1;
-
-		new_cube.x = cube->x + new_cube.w * x;
-		new_cube.y = cube->y + new_cube.h * y;
-		new_cube.z = cube->z + new_cube.d * z;
-
-		int i = x | (y<<1) | (z<<2);
-
-		if (!node->child[i])
-			node->child[i] = node_new(node);
-
-		node->n_pixels++;
-
-		node_update(node->child[x | (y<<1) | (z<<2)], color, &new_cube, max_depth - 1);
+	args->progress_timeout = 0;
+	job->thread.join();
+	args->previous_tree = job->tree;
+	job->tree = nullptr;
+	args->histogram.swap(job->histogram);
+	delete job;
+	args->job = nullptr;
+	gtk_widget_hide(args->progress_bar);
+	color_list_remove_all(args->preview_color_list);
+	calc(args, true, 100);
+	if (args->apply_pending){
+		args->apply_pending = false;
+		calc(args, false, 0);
 	}
+	return FALSE;
 }
 
-static void leaf_cb(Node *node, void *userdata){
-	list<Color> *l = static_cast<list<Color>*>(userdata);
-
-	Color c;
-	c.xyz.x = node->color[0] / node->n_pixels_in;
-	c.xyz.y = node->color[1] / node->n_pixels_in;
-	c.xyz.z = node->color[2] / node->n_pixels_in;
-
-	l->push_back(c);
-}
-
-static Node* process_image(PaletteFromImageArgs *args, const char *filename, Node* node){
-
+/**
+ * Start processing image in a worker thread if it is not processed already.
+ * @return True if tree for the image is available.
+ */
+static bool start_processing(PaletteFromImageArgs *args, const string &filename){
 	if (args->previous_filename == filename){
-		if (args->previous_node)
-			return node_copy(args->previous_node, 0);
-		else
-			return 0;
+		return args->job == nullptr;
 	}
-
+	cancel_processing(args);
 	args->previous_filename = filename;
-	if (args->previous_node){
-		node_delete(args->previous_node);
-		args->previous_node = 0;
-	}
-
-	GError *error = nullptr;
-	GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file(filename, &error);
-	if (error){
-		cout << error->message << endl;
-		g_error_free(error);
-		return 0;
-	}
-
-	int channels = gdk_pixbuf_get_n_channels(pixbuf);
-	int width = gdk_pixbuf_get_width(pixbuf);
-	int height = gdk_pixbuf_get_height(pixbuf);
-	int rowstride = gdk_pixbuf_get_rowstride(pixbuf);
-	guchar *image_data = gdk_pixbuf_get_pixels(pixbuf);
-	guchar *ptr = image_data;
-
-	Cube cube;
-	cube.x = 0;
-	cube.y = 0;
-	cube.z = 0;
-	cube.w = 1;
-	cube.h = 1;
-	cube.d = 1;
-
-	Color color;
-
-	args->previous_node = node_new(0);
-
-	for (int y = 0; y < height; y++){
-		ptr = image_data + rowstride * y;
-		for (int x = 0; x < width; x++){
-
-			color.xyz.x = ptr[0] / 255.0;
-			color.xyz.y = ptr[1] / 255.0;
-			color.xyz.z = ptr[2] / 255.0;
-
-			node_update(args->previous_node, &color, &cube, 5);
-
-			ptr += channels;
-		}
+	if (args->previous_tree){
+		octree_delete(args->previous_tree);
+		args->previous_tree = nullptr;
 	}
-	g_object_unref(pixbuf);
-	node_reduce(args->previous_node, 200);
-	return node_copy(args->previous_node, 0);
+	args->histogram.clear();
+	PaletteFromImageJob *job = new PaletteFromImageJob;
+	job->filename = filename;
+	job->max_pixels = args->max_pixels;
+	job->use_cache = args->use_cache;
+	job->thread = thread(process_image, job);
+	args->job = job;
+	gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(args->progress_bar), 0);
+	gtk_widget_show(args->progress_bar);
+	args->progress_timeout = g_timeout_add(100, (GSourceFunc)progress_cb, args);
+	return false;
 }
 
 static void get_settings(PaletteFromImageArgs *args){
@@ -397,10 +256,13 @@ static void get_settings(PaletteFromImageArgs *args){
 	}
 
 	args->n_colors = gtk_spin_button_get_value(GTK_SPIN_BUTTON(args->range_colors));
+	gint quantizer = gtk_combo_box_get_active(GTK_COMBO_BOX(args->quantizer_combo));
+	args->quantizer = quantizer >= 0 ? &quantizers_get()[quantizer] : quantizers_get();
 }
 
 static void save_settings(PaletteFromImageArgs *args){
 	dynv_set_int32(args->params, "colors", args->n_colors);
+	dynv_set_string(args->params, "quantizer", args->quantizer->name);
 	gchar *current_folder = gtk_file_chooser_get_current_folder(GTK_FILE_CHOOSER(args->file_browser));
 	if (current_folder){
 		dynv_set_string(args->params, "current_folder", current_folder);
@@ -415,12 +277,20 @@ static void save_settings(PaletteFromImageArgs *args){
 
 static void calc(PaletteFromImageArgs *args, bool preview, int limit){
 
-	Node *root_node = 0;
+	Octree *tree = nullptr;
+	bool ready = false;
 	int index = 0;
+	if (!args->filename.empty()){
+		if (!start_processing(args, args->filename)){
+			if (!preview) args->apply_pending = true;
+			return;
+		}
+		ready = args->previous_tree != nullptr;
+		if (ready && args->quantizer == quantizer_get("octree"))
+			tree = octree_copy(args->previous_tree);
+	}
 	gchar *name = g_path_get_basename(args->filename.c_str());
 	PaletteColorNameAssigner name_assigner(args->gs);
-	if (!args->filename.empty())
-		root_node = process_image(args, args->filename.c_str(), root_node);
 
 	ColorList *color_list;
 
@@ -431,10 +301,14 @@ static void calc(PaletteFromImageArgs *args, bool preview, int limit){
 
 	list<Color> tmp_list;
 
-	if (root_node){
-		node_reduce(root_node, args->n_colors);
-		node_leaf_callback(root_node, leaf_cb, &tmp_list);
-		node_delete(root_node);
+	if (tree){
+		octree_reduce(tree, args->n_colors);
+		octree_leaf_callback(tree, leaf_cb, &tmp_list);
+		octree_delete(tree);
+	}else if (ready){
+		vector<Color> palette;
+		args->quantizer->quantize(args->histogram.data(), args->histogram.size(), args->n_colors, palette);
+		tmp_list.assign(palette.begin(), palette.end());
 	}
 
 	for (list<Color>::iterator i = tmp_list.begin(); i != tmp_list.end(); i++){
@@ -444,6 +318,7 @@ static void calc(PaletteFromImageArgs *args, bool preview, int limit){
 		color_object->release();
 		index++;
 	}
+	g_free(name);
 }
 
 static void update(GtkWidget *widget, PaletteFromImageArgs *args ){
@@ -458,7 +333,8 @@ static gchar* format_threshold_value_cb(GtkScale *scale, gdouble value){
 
 static void destroy_cb(GtkWidget* widget, PaletteFromImageArgs *args){
 
-	if (args->previous_node) node_delete(args->previous_node);
+	cancel_processing(args);
+	if (args->previous_tree) octree_delete(args->previous_tree);
 
 	color_list_destroy(args->preview_color_list);
 	dynv_system_release(args->params);
@@ -496,7 +372,13 @@ void tools_palette_from_image_show(GtkWindow* parent, GlobalState* gs)
 	args->previous_filename = "";
 	args->gs = gs;
 	args->params = dynv_get_dynv(args->gs->getSettings(), "gpick.tools.palette_from_image");
-	args->previous_node = 0;
+	args->previous_tree = nullptr;
+	args->job = nullptr;
+	args->max_pixels = max(0, dynv_get_int32_wd(args->params, "max_pixels", 16 * 1024 * 1024));
+	args->use_cache = dynv_get_bool_wd(args->params, "use_cache", true);
+	args->progress_timeout = 0;
+	args->apply_pending = false;
+	args->quantizer = quantizers_get();
 	GtkWidget *table, *table_m, *widget;
 	GtkWidget *dialog = gtk_dialog_new_with_buttons(_("Palette from image"), parent, GtkDialogFlags(GTK_DIALOG_DESTROY_WITH_PARENT), GTK_STOCK_CLOSE, GTK_RESPONSE_CLOSE, GTK_STOCK_ADD, GTK_RESPONSE_APPLY, nullptr);
 	gtk_window_set_default_size(GTK_WINDOW(dialog), dynv_get_int32_wd(args->params, "window.width", -1),
@@ -568,6 +450,11 @@ void tools_palette_from_image_show(GtkWindow* parent, GlobalState* gs)
 	}
 	if (formats) g_slist_free(formats);
 
+	args->progress_bar = widget = gtk_progress_bar_new();
+	gtk_widget_set_no_show_all(widget, TRUE);
+	gtk_table_attach(GTK_TABLE(table), widget, 0, 3, table_y, table_y+1, GtkAttachOptions(GTK_FILL | GTK_EXPAND),GTK_FILL,3,3);
+	table_y++;
+
 	frame = gtk_frame_new(_("Options"));
 	gtk_frame_set_shadow_type(GTK_FRAME(frame), GTK_SHADOW_NONE);
 	gtk_table_attach(GTK_TABLE(table_m), frame, 0, 1, table_m_y, table_m_y+1, GtkAttachOptions(GTK_FILL | GTK_EXPAND), GtkAttachOptions(GTK_FILL), 5, 5);
@@ -583,6 +470,18 @@ void tools_palette_from_image_show(GtkWindow* parent, GlobalState* gs)
 	g_signal_connect(G_OBJECT(args->range_colors), "value-changed", G_CALLBACK(update), args);
 	table_y++;
 
+	gtk_table_attach(GTK_TABLE(table), gtk_label_aligned_new(_("Quantizer:"),0,0,0,0),0,1,table_y,table_y+1,GtkAttachOptions(GTK_FILL),GTK_FILL,5,5);
+	args->quantizer_combo = widget = gtk_combo_box_text_new();
+	const char *selected_quantizer = dynv_get_string_wd(args->params, "quantizer", "octree");
+	for (uint32_t j = 0; j < quantizers_get_n(); j++){
+		gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(widget), _(quantizers_get()[j].label));
+		if (g_strcmp0(quantizers_get()[j].name, selected_quantizer) == 0) gtk_combo_box_set_active(GTK_COMBO_BOX(widget), j);
+	}
+	if (gtk_combo_box_get_active(GTK_COMBO_BOX(widget)) < 0) gtk_combo_box_set_active(GTK_COMBO_BOX(widget), 0);
+	gtk_table_attach(GTK_TABLE(table), widget,1,3,table_y,table_y+1,GtkAttachOptions(GTK_FILL | GTK_EXPAND),GTK_FILL,3,3);
+	g_signal_connect(G_OBJECT(args->quantizer_combo), "changed", G_CALLBACK(update), args);
+	table_y++;
+
 	ColorList* preview_color_list = nullptr;
 	gtk_table_attach(GTK_TABLE(table_m), args->preview_expander = palette_list_preview_new(gs, true, dynv_get_bool_wd(args->params, "show_preview", true), gs->getColorList(), &preview_color_list), 0, 1, table_m_y, table_m_y+1 , GtkAttachOptions(GTK_FILL | GTK_EXPAND), GtkAttachOptions(GTK_FILL | GTK_EXPAND), 5, 5);
 	table_m_y++;
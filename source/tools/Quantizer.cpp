@@ -0,0 +1,766 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Quantizer.h"
+#include "Octree.h"
+#include "../ColorPipeline.h"
+#include "../MathUtil.h"
+#include "../I18N.h"
+#include <string.h>
+#include <math.h>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+using namespace std;
+
+#ifdef GPICK_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/** Octree depth used by octree quantizer */
+const uint32_t OctreeDepth = 5;
+/** Number of bins along each axis of Wu quantizer histogram, including one empty bin */
+const int WuSize = 33;
+/** K-means works on a reduced histogram with at most this many colors */
+const size_t KMeansMaxColors = 1 << 15;
+const int KMeansIterations = 16;
+
+/** Marks unused histogram slot, colors only use lower 24 bits */
+const uint32_t HistogramEmptyKey = 0xffffffff;
+/** Histogram is split into this many partitions by color hash, so that threads can fill partitions independently */
+const int HistogramPartitionBits = 4;
+const int HistogramPartitions = 1 << HistogramPartitionBits;
+/** Initial partition size is 2^11 slots, all partitions together have enough slots for most screenshots and illustrations */
+const int HistogramInitialBits = 11;
+/** Images with fewer pixels are added to histogram in the calling thread */
+const size_t HistogramParallelMinPixels = 1 << 16;
+
+/** \struct HistogramPartition
+ * \brief Hash table holding colors of one histogram partition
+ */
+struct HistogramPartition{
+	vector<uint32_t> keys; /**< Packed colors, open addressing with linear probing */
+	vector<uint32_t> counts;
+	size_t size;
+	int bits;
+};
+
+struct QuantizerHistogram{
+	HistogramPartition partitions[HistogramPartitions];
+};
+
+static inline uint32_t histogram_slot(uint32_t key, int bits){
+	return (key * 0x9e3779b1u) >> (32 - bits);
+}
+
+/** Partition is selected by a different hash than the slot, so that slots of each partition are still evenly used */
+static inline uint32_t histogram_partition(uint32_t key){
+	return (key * 0x85ebca77u) >> (32 - HistogramPartitionBits);
+}
+
+static void histogram_resize(HistogramPartition *partition, int bits){
+	vector<uint32_t> keys(size_t(1) << bits, HistogramEmptyKey);
+	vector<uint32_t> counts(size_t(1) << bits, 0);
+	uint32_t mask = (1u << bits) - 1;
+	for (size_t i = 0; i < partition->keys.size(); i++){
+		if (partition->keys[i] == HistogramEmptyKey) continue;
+		uint32_t slot = histogram_slot(partition->keys[i], bits);
+		while (keys[slot] != HistogramEmptyKey)
+			slot = (slot + 1) & mask;
+		keys[slot] = partition->keys[i];
+		counts[slot] = partition->counts[i];
+	}
+	partition->keys.swap(keys);
+	partition->counts.swap(counts);
+	partition->bits = bits;
+}
+
+static inline void histogram_add(HistogramPartition *partition, uint32_t key, uint32_t count){
+	uint32_t mask = (1u << partition->bits) - 1;
+	uint32_t slot = histogram_slot(key, partition->bits);
+	for (;;){
+		uint32_t current = partition->keys[slot];
+		if (current == key){
+			partition->counts[slot] += count;
+			return;
+		}
+		if (current == HistogramEmptyKey){
+			partition->keys[slot] = key;
+			partition->counts[slot] = count;
+			// Keep load factor below 1/2, so that probe sequences stay short
+			if (++partition->size * 2 > partition->keys.size())
+				histogram_resize(partition, partition->bits + 1);
+			return;
+		}
+		slot = (slot + 1) & mask;
+	}
+}
+
+/** Pack red, green and blue channels of 8-bit pixel into histogram key */
+static inline uint32_t histogram_key(const unsigned char *pixel){
+	return uint32_t(pixel[0]) | (uint32_t(pixel[1]) << 8) | (uint32_t(pixel[2]) << 16);
+}
+
+/**
+ * Add image pixels which belong to partitions first_partition, first_partition + partition_step, ... to histogram.
+ */
+static void histogram_add_rgb8(QuantizerHistogram *histogram, const unsigned char *data, int channels, int width, int height, int rowstride, int first_partition, int partition_step){
+	for (int y = 0; y < height; y++){
+		const unsigned char *pixel = data + rowstride * y;
+		int x = 0;
+		while (x < width){
+			uint32_t key = histogram_key(pixel);
+			uint32_t count = 1;
+			pixel += channels;
+			x++;
+			// Flat areas produce long runs of the same color, count them without touching the table
+			while (x < width && histogram_key(pixel) == key){
+				count++;
+				pixel += channels;
+				x++;
+			}
+			uint32_t partition = histogram_partition(key);
+			if (partition_step == 1 || int(partition) % partition_step == first_partition)
+				histogram_add(&histogram->partitions[partition], key, count);
+		}
+	}
+}
+
+QuantizerHistogram* quantizer_histogram_new(){
+	QuantizerHistogram *histogram = new QuantizerHistogram;
+	for (auto &partition: histogram->partitions){
+		partition.size = 0;
+		partition.bits = 0;
+		histogram_resize(&partition, HistogramInitialBits);
+	}
+	return histogram;
+}
+
+void quantizer_histogram_destroy(QuantizerHistogram *histogram){
+	delete histogram;
+}
+
+void quantizer_histogram_clear(QuantizerHistogram *histogram){
+	for (auto &partition: histogram->partitions){
+		partition.keys.clear();
+		partition.counts.clear();
+		partition.size = 0;
+		histogram_resize(&partition, HistogramInitialBits);
+	}
+}
+
+void quantizer_histogram_add_rgb8(QuantizerHistogram *histogram, const unsigned char *data, int channels, int width, int height, int rowstride){
+	histogram_add_rgb8(histogram, data, channels, width, height, rowstride, 0, 1);
+}
+
+void quantizer_histogram_add_rgb8_parallel(QuantizerHistogram *histogram, const unsigned char *data, int channels, int width, int height, int rowstride, unsigned int threads){
+	if (width <= 0 || height <= 0) return;
+	if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+	threads = min(threads, static_cast<unsigned int>(HistogramPartitions));
+	if (threads == 1 || size_t(width) * height < HistogramParallelMinPixels){
+		histogram_add_rgb8(histogram, data, channels, width, height, rowstride, 0, 1);
+		return;
+	}
+	// Every thread reads the whole image, but only inserts colors of its own partitions. Reading is cheap compared to table updates and threads never write to the same table.
+	vector<thread> pool;
+	for (unsigned int i = 1; i < threads; i++){
+		pool.emplace_back(histogram_add_rgb8, histogram, data, channels, width, height, rowstride, int(i), int(threads));
+	}
+	histogram_add_rgb8(histogram, data, channels, width, height, rowstride, 0, int(threads));
+	for (auto &t: pool){
+		t.join();
+	}
+}
+
+size_t quantizer_histogram_get_size(const QuantizerHistogram *histogram){
+	size_t size = 0;
+	for (auto &partition: histogram->partitions)
+		size += partition.size;
+	return size;
+}
+
+void quantizer_histogram_get_colors(const QuantizerHistogram *histogram, vector<QuantizerColor> &colors){
+	// Entries hold color in upper and count in lower 32 bits. Colors have only 24 bits, so two 12-bit radix sort passes put them in order.
+	size_t size = quantizer_histogram_get_size(histogram);
+	vector<uint64_t> entries, sorted(size);
+	entries.reserve(size);
+	for (auto &partition: histogram->partitions){
+		for (size_t i = 0; i < partition.keys.size(); i++){
+			if (partition.keys[i] != HistogramEmptyKey)
+				entries.push_back((uint64_t(partition.keys[i]) << 32) | partition.counts[i]);
+		}
+	}
+	for (int shift = 32; shift < 56; shift += 12){
+		vector<size_t> offsets(4097, 0);
+		for (auto entry: entries)
+			offsets[((entry >> shift) & 0xfff) + 1]++;
+		for (size_t i = 1; i < offsets.size(); i++)
+			offsets[i] += offsets[i - 1];
+		for (auto entry: entries)
+			sorted[offsets[(entry >> shift) & 0xfff]++] = entry;
+		entries.swap(sorted);
+	}
+	colors.resize(entries.size());
+	for (size_t i = 0; i < entries.size(); i++){
+		uint32_t key = entries[i] >> 32;
+		unsigned char rgb[3] = {static_cast<unsigned char>(key & 0xff), static_cast<unsigned char>((key >> 8) & 0xff), static_cast<unsigned char>(key >> 16)};
+		color_rgb8_to_rgb_batch(rgb, 3, 1, &colors[i].color);
+		colors[i].color.ma[3] = 0;
+		colors[i].weight = static_cast<uint32_t>(entries[i]);
+	}
+}
+
+void quantizer_histogram_rgb8(const unsigned char *data, int channels, int width, int height, int rowstride, vector<QuantizerColor> &histogram){
+	QuantizerHistogram *builder = quantizer_histogram_new();
+	quantizer_histogram_add_rgb8(builder, data, channels, width, height, rowstride);
+	quantizer_histogram_get_colors(builder, histogram);
+	quantizer_histogram_destroy(builder);
+}
+
+void quantizer_histogram_reduce(const QuantizerColor *colors, size_t count, int bits, vector<QuantizerColor> &result){
+	struct Bucket{
+		double sum[3];
+		uint64_t weight;
+	};
+	unordered_map<uint32_t, Bucket> buckets;
+	int shift = 8 - bits;
+	for (size_t i = 0; i < count; i++){
+		uint32_t key = 0;
+		for (int j = 0; j < 3; j++){
+			key |= (clamp_int(int(colors[i].color.ma[j] * 255 + 0.5f), 0, 255) >> shift) << (j * 8);
+		}
+		Bucket &bucket = buckets[key];
+		for (int j = 0; j < 3; j++){
+			bucket.sum[j] += double(colors[i].color.ma[j]) * colors[i].weight;
+		}
+		bucket.weight += colors[i].weight;
+	}
+	vector<pair<uint32_t, Bucket>> sorted(buckets.begin(), buckets.end());
+	sort(sorted.begin(), sorted.end(), [](const pair<uint32_t, Bucket> &a, const pair<uint32_t, Bucket> &b){
+		return a.first < b.first;
+	});
+	result.clear();
+	for (auto &item: sorted){
+		if (item.second.weight == 0) continue;
+		QuantizerColor color;
+		for (int j = 0; j < 3; j++){
+			color.color.ma[j] = item.second.sum[j] / item.second.weight;
+		}
+		color.color.ma[3] = 0;
+		color.weight = static_cast<uint32_t>(min<uint64_t>(item.second.weight, numeric_limits<uint32_t>::max()));
+		result.push_back(color);
+	}
+}
+
+static void quantize_octree(const QuantizerColor *colors, size_t count, uint32_t max_colors, vector<Color> &palette){
+	Octree *tree = octree_new();
+	octree_add_colors_parallel(tree, colors, count, OctreeDepth, 0, nullptr);
+	octree_reduce(tree, max_colors);
+	octree_get_colors(tree, palette);
+	octree_delete(tree);
+}
+
+/** \struct WuBox
+ * \brief Box in Wu quantizer histogram, lower bounds are exclusive
+ */
+struct WuBox{
+	int r0, r1;
+	int g0, g1;
+	int b0, b1;
+	int volume;
+};
+
+/** \struct WuMoments
+ * \brief Cumulative moments of Wu quantizer histogram
+ */
+struct WuMoments{
+	vector<double> weight, r, g, b, square;
+	WuMoments():
+		weight(WuSize * WuSize * WuSize),
+		r(WuSize * WuSize * WuSize),
+		g(WuSize * WuSize * WuSize),
+		b(WuSize * WuSize * WuSize),
+		square(WuSize * WuSize * WuSize)
+	{
+	}
+};
+
+static inline int wu_index(int r, int g, int b){
+	return (r * WuSize + g) * WuSize + b;
+}
+
+static double wu_volume(const WuBox &box, const vector<double> &m){
+	return m[wu_index(box.r1, box.g1, box.b1)] - m[wu_index(box.r1, box.g1, box.b0)] - m[wu_index(box.r1, box.g0, box.b1)] + m[wu_index(box.r1, box.g0, box.b0)]
+		- m[wu_index(box.r0, box.g1, box.b1)] + m[wu_index(box.r0, box.g1, box.b0)] + m[wu_index(box.r0, box.g0, box.b1)] - m[wu_index(box.r0, box.g0, box.b0)];
+}
+
+/**
+ * Part of box volume which does not depend on cut position along direction
+ */
+static double wu_bottom(const WuBox &box, int direction, const vector<double> &m){
+	switch (direction){
+		case 0:
+			return -m[wu_index(box.r0, box.g1, box.b1)] + m[wu_index(box.r0, box.g1, box.b0)] + m[wu_index(box.r0, box.g0, box.b1)] - m[wu_index(box.r0, box.g0, box.b0)];
+		case 1:
+			return -m[wu_index(box.r1, box.g0, box.b1)] + m[wu_index(box.r1, box.g0, box.b0)] + m[wu_index(box.r0, box.g0, box.b1)] - m[wu_index(box.r0, box.g0, box.b0)];
+		default:
+			return -m[wu_index(box.r1, box.g1, box.b0)] + m[wu_index(box.r1, box.g0, box.b0)] + m[wu_index(box.r0, box.g1, box.b0)] - m[wu_index(box.r0, box.g0, box.b0)];
+	}
+}
+
+/**
+ * Part of box volume which depends on cut position along direction
+ */
+static double wu_top(const WuBox &box, int direction, int position, const vector<double> &m){
+	switch (direction){
+		case 0:
+			return m[wu_index(position, box.g1, box.b1)] - m[wu_index(position, box.g1, box.b0)] - m[wu_index(position, box.g0, box.b1)] + m[wu_index(position, box.g0, box.b0)];
+		case 1:
+			return m[wu_index(box.r1, position, box.b1)] - m[wu_index(box.r1, position, box.b0)] - m[wu_index(box.r0, position, box.b1)] + m[wu_index(box.r0, position, box.b0)];
+		default:
+			return m[wu_index(box.r1, box.g1, position)] - m[wu_index(box.r1, box.g0, position)] - m[wu_index(box.r0, box.g1, position)] + m[wu_index(box.r0, box.g0, position)];
+	}
+}
+
+static double wu_variance(const WuBox &box, const WuMoments &moments){
+	double r = wu_volume(box, moments.r);
+	double g = wu_volume(box, moments.g);
+	double b = wu_volume(box, moments.b);
+	double weight = wu_volume(box, moments.weight);
+	if (weight <= 0) return 0;
+	return wu_volume(box, moments.square) - (r * r + g * g + b * b) / weight;
+}
+
+/**
+ * Find cut position along direction which maximizes sum of squared means of both parts
+ */
+static double wu_maximize(const WuBox &box, int direction, int first, int last, int *cut, const double whole[4], const WuMoments &moments){
+	double base[4] = {
+		wu_bottom(box, direction, moments.r),
+		wu_bottom(box, direction, moments.g),
+		wu_bottom(box, direction, moments.b),
+		wu_bottom(box, direction, moments.weight),
+	};
+	double max = 0;
+	*cut = -1;
+	for (int i = first; i < last; i++){
+		double half[4] = {
+			base[0] + wu_top(box, direction, i, moments.r),
+			base[1] + wu_top(box, direction, i, moments.g),
+			base[2] + wu_top(box, direction, i, moments.b),
+			base[3] + wu_top(box, direction, i, moments.weight),
+		};
+		if (half[3] <= 0) continue;
+		double value = (half[0] * half[0] + half[1] * half[1] + half[2] * half[2]) / half[3];
+		for (int j = 0; j < 4; j++){
+			half[j] = whole[j] - half[j];
+		}
+		if (half[3] <= 0) continue;
+		value += (half[0] * half[0] + half[1] * half[1] + half[2] * half[2]) / half[3];
+		if (value > max){
+			max = value;
+			*cut = i;
+		}
+	}
+	return max;
+}
+
+static bool wu_cut(WuBox &box1, WuBox &box2, const WuMoments &moments){
+	double whole[4] = {
+		wu_volume(box1, moments.r),
+		wu_volume(box1, moments.g),
+		wu_volume(box1, moments.b),
+		wu_volume(box1, moments.weight),
+	};
+	int cut_r, cut_g, cut_b;
+	double max_r = wu_maximize(box1, 0, box1.r0 + 1, box1.r1, &cut_r, whole, moments);
+	double max_g = wu_maximize(box1, 1, box1.g0 + 1, box1.g1, &cut_g, whole, moments);
+	double max_b = wu_maximize(box1, 2, box1.b0 + 1, box1.b1, &cut_b, whole, moments);
+	box2 = box1;
+	if (max_r >= max_g && max_r >= max_b){
+		if (cut_r < 0) return false;
+		box2.r0 = box1.r1 = cut_r;
+	}else if (max_g >= max_r && max_g >= max_b){
+		if (cut_g < 0) return false;
+		box2.g0 = box1.g1 = cut_g;
+	}else{
+		if (cut_b < 0) return false;
+		box2.b0 = box1.b1 = cut_b;
+	}
+	box1.volume = (box1.r1 - box1.r0) * (box1.g1 - box1.g0) * (box1.b1 - box1.b0);
+	box2.volume = (box2.r1 - box2.r0) * (box2.g1 - box2.g0) * (box2.b1 - box2.b0);
+	return true;
+}
+
+static void quantize_wu(const QuantizerColor *colors, size_t count, uint32_t max_colors, vector<Color> &palette){
+	palette.clear();
+	if (count == 0 || max_colors == 0) return;
+	WuMoments moments;
+	for (size_t i = 0; i < count; i++){
+		int bin[3];
+		for (int j = 0; j < 3; j++){
+			bin[j] = (clamp_int(int(colors[i].color.ma[j] * 255 + 0.5f), 0, 255) >> 3) + 1;
+		}
+		int index = wu_index(bin[0], bin[1], bin[2]);
+		double weight = colors[i].weight;
+		double r = colors[i].color.rgb.red, g = colors[i].color.rgb.green, b = colors[i].color.rgb.blue;
+		moments.weight[index] += weight;
+		moments.r[index] += weight * r;
+		moments.g[index] += weight * g;
+		moments.b[index] += weight * b;
+		moments.square[index] += weight * (r * r + g * g + b * b);
+	}
+	vector<double>* tables[] = {&moments.weight, &moments.r, &moments.g, &moments.b, &moments.square};
+	for (auto table: tables){
+		vector<double> &m = *table;
+		for (int r = 1; r < WuSize; r++){
+			double area[WuSize] = {0};
+			for (int g = 1; g < WuSize; g++){
+				double line = 0;
+				for (int b = 1; b < WuSize; b++){
+					line += m[wu_index(r, g, b)];
+					area[b] += line;
+					m[wu_index(r, g, b)] = m[wu_index(r - 1, g, b)] + area[b];
+				}
+			}
+		}
+	}
+	vector<WuBox> boxes(max_colors);
+	vector<double> variance(max_colors, 0);
+	boxes[0].r0 = boxes[0].g0 = boxes[0].b0 = 0;
+	boxes[0].r1 = boxes[0].g1 = boxes[0].b1 = WuSize - 1;
+	boxes[0].volume = (WuSize - 1) * (WuSize - 1) * (WuSize - 1);
+	uint32_t box_count = 1;
+	uint32_t next = 0;
+	while (box_count < max_colors){
+		if (wu_cut(boxes[next], boxes[box_count], moments)){
+			variance[next] = boxes[next].volume > 1 ? wu_variance(boxes[next], moments) : 0;
+			variance[box_count] = boxes[box_count].volume > 1 ? wu_variance(boxes[box_count], moments) : 0;
+			box_count++;
+		}else{
+			variance[next] = 0;
+		}
+		next = 0;
+		for (uint32_t i = 1; i < box_count; i++){
+			if (variance[i] > variance[next]) next = i;
+		}
+		if (variance[next] <= 0) break;
+	}
+	for (uint32_t i = 0; i < box_count; i++){
+		double weight = wu_volume(boxes[i], moments.weight);
+		if (weight <= 0) continue;
+		Color c;
+		c.rgb.red = wu_volume(boxes[i], moments.r) / weight;
+		c.rgb.green = wu_volume(boxes[i], moments.g) / weight;
+		c.rgb.blue = wu_volume(boxes[i], moments.b) / weight;
+		c.ma[3] = 0;
+		palette.push_back(c);
+	}
+}
+
+/** \struct MedianCutBox
+ * \brief Range of colors in median cut quantizer
+ */
+struct MedianCutBox{
+	size_t begin, end;
+	double error; /**< Weighted sum of squared distances from the mean */
+	Color mean;
+};
+
+static void median_cut_update(MedianCutBox &box, const vector<QuantizerColor> &colors){
+	double sum[3] = {0, 0, 0}, square = 0, weight = 0;
+	for (size_t i = box.begin; i < box.end; i++){
+		double w = colors[i].weight;
+		for (int j = 0; j < 3; j++){
+			double value = colors[i].color.ma[j];
+			sum[j] += w * value;
+			square += w * value * value;
+		}
+		weight += w;
+	}
+	box.error = 0;
+	for (int j = 0; j < 3; j++){
+		box.mean.ma[j] = weight > 0 ? sum[j] / weight : 0;
+	}
+	box.mean.ma[3] = 0;
+	if (weight > 0 && box.end - box.begin > 1)
+		box.error = square - (sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]) / weight;
+}
+
+static void quantize_median_cut(const QuantizerColor *colors, size_t count, uint32_t max_colors, vector<Color> &palette){
+	palette.clear();
+	if (count == 0 || max_colors == 0) return;
+	vector<QuantizerColor> items(colors, colors + count);
+	vector<MedianCutBox> boxes;
+	MedianCutBox box;
+	box.begin = 0;
+	box.end = count;
+	median_cut_update(box, items);
+	boxes.push_back(box);
+	while (boxes.size() < max_colors){
+		size_t selected = 0;
+		for (size_t i = 1; i < boxes.size(); i++){
+			if (boxes[i].error > boxes[selected].error) selected = i;
+		}
+		MedianCutBox &current = boxes[selected];
+		if (current.error <= 0) break;
+		float min_value[3], max_value[3];
+		for (int j = 0; j < 3; j++){
+			min_value[j] = numeric_limits<float>::max();
+			max_value[j] = -numeric_limits<float>::max();
+		}
+		uint64_t total = 0;
+		for (size_t i = current.begin; i < current.end; i++){
+			for (int j = 0; j < 3; j++){
+				min_value[j] = min(min_value[j], items[i].color.ma[j]);
+				max_value[j] = max(max_value[j], items[i].color.ma[j]);
+			}
+			total += items[i].weight;
+		}
+		int axis = 0;
+		for (int j = 1; j < 3; j++){
+			if (max_value[j] - min_value[j] > max_value[axis] - min_value[axis]) axis = j;
+		}
+		sort(items.begin() + current.begin, items.begin() + current.end, [axis](const QuantizerColor &a, const QuantizerColor &b){
+			return a.color.ma[axis] < b.color.ma[axis];
+		});
+		size_t split = current.begin;
+		uint64_t weight = 0;
+		while (split < current.end - 1 && (weight + items[split].weight) * 2 <= total){
+			weight += items[split].weight;
+			split++;
+		}
+		if (split == current.begin) split++;
+		MedianCutBox upper;
+		upper.begin = split;
+		upper.end = current.end;
+		current.end = split;
+		median_cut_update(current, items);
+		median_cut_update(upper, items);
+		boxes.push_back(upper);
+	}
+	for (auto &box: boxes){
+		palette.push_back(box.mean);
+	}
+}
+
+/**
+ * Find nearest center for each point. Points and centers are stored as separate coordinate arrays.
+ */
+static void nearest_center_scalar(const float *l, const float *a, const float *b, size_t count, const float *cl, const float *ca, const float *cb, size_t centers, uint32_t *index, float *distance){
+	for (size_t i = 0; i < count; i++){
+		float best = numeric_limits<float>::max();
+		uint32_t best_index = 0;
+		for (size_t c = 0; c < centers; c++){
+			float dl = l[i] - cl[c], da = a[i] - ca[c], db = b[i] - cb[c];
+			float d = dl * dl + da * da + db * db;
+			if (d < best){
+				best = d;
+				best_index = c;
+			}
+		}
+		index[i] = best_index;
+		distance[i] = best;
+	}
+}
+
+#ifdef GPICK_X86_KERNELS
+/* SIMD kernels process several points at once and use the same operation order as the scalar kernel, so results are identical. */
+GPICK_TARGET("sse2")
+static void nearest_center_sse2(const float *l, const float *a, const float *b, size_t count, const float *cl, const float *ca, const float *cb, size_t centers, uint32_t *index, float *distance){
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4){
+		__m128 pl = _mm_loadu_ps(l + i), pa = _mm_loadu_ps(a + i), pb = _mm_loadu_ps(b + i);
+		__m128 best = _mm_set1_ps(numeric_limits<float>::max());
+		__m128i best_index = _mm_setzero_si128();
+		for (size_t c = 0; c < centers; c++){
+			__m128 dl = _mm_sub_ps(pl, _mm_set1_ps(cl[c]));
+			__m128 da = _mm_sub_ps(pa, _mm_set1_ps(ca[c]));
+			__m128 db = _mm_sub_ps(pb, _mm_set1_ps(cb[c]));
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dl, dl), _mm_mul_ps(da, da)), _mm_mul_ps(db, db));
+			__m128 mask = _mm_cmplt_ps(d, best);
+			best = _mm_or_ps(_mm_and_ps(mask, d), _mm_andnot_ps(mask, best));
+			__m128i imask = _mm_castps_si128(mask);
+			best_index = _mm_or_si128(_mm_and_si128(imask, _mm_set1_epi32(c)), _mm_andnot_si128(imask, best_index));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(index + i), best_index);
+		_mm_storeu_ps(distance + i, best);
+	}
+	nearest_center_scalar(l + i, a + i, b + i, count - i, cl, ca, cb, centers, index + i, distance + i);
+}
+
+GPICK_TARGET("avx2")
+static void nearest_center_avx2(const float *l, const float *a, const float *b, size_t count, const float *cl, const float *ca, const float *cb, size_t centers, uint32_t *index, float *distance){
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8){
+		__m256 pl = _mm256_loadu_ps(l + i), pa = _mm256_loadu_ps(a + i), pb = _mm256_loadu_ps(b + i);
+		__m256 best = _mm256_set1_ps(numeric_limits<float>::max());
+		__m256i best_index = _mm256_setzero_si256();
+		for (size_t c = 0; c < centers; c++){
+			__m256 dl = _mm256_sub_ps(pl, _mm256_set1_ps(cl[c]));
+			__m256 da = _mm256_sub_ps(pa, _mm256_set1_ps(ca[c]));
+			__m256 db = _mm256_sub_ps(pb, _mm256_set1_ps(cb[c]));
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dl, dl), _mm256_mul_ps(da, da)), _mm256_mul_ps(db, db));
+			__m256 mask = _mm256_cmp_ps(d, best, _CMP_LT_OQ);
+			best = _mm256_blendv_ps(best, d, mask);
+			best_index = _mm256_blendv_epi8(best_index, _mm256_set1_epi32(c), _mm256_castps_si256(mask));
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(index + i), best_index);
+		_mm256_storeu_ps(distance + i, best);
+	}
+	nearest_center_sse2(l + i, a + i, b + i, count - i, cl, ca, cb, centers, index + i, distance + i);
+}
+#endif
+
+typedef void (*NearestCenterKernel)(const float *l, const float *a, const float *b, size_t count, const float *cl, const float *ca, const float *cb, size_t centers, uint32_t *index, float *distance);
+
+/**
+ * Simple deterministic random number generator, so palettes do not change between runs
+ */
+static float kmeans_random(uint32_t &state){
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (state >> 8) / 16777216.0f;
+}
+
+/**
+ * Select index of a point with probability proportional to its weight
+ */
+static size_t kmeans_pick(const vector<double> &weights, double total, uint32_t &state){
+	double target = kmeans_random(state) * total;
+	for (size_t i = 0; i < weights.size(); i++){
+		if (target < weights[i]) return i;
+		target -= weights[i];
+	}
+	return weights.size() - 1;
+}
+
+static void quantize_kmeans(const QuantizerColor *colors, size_t count, uint32_t max_colors, vector<Color> &palette){
+	NearestCenterKernel nearest_center = simd_select<NearestCenterKernel>(nearest_center_scalar, GPICK_KERNEL(nearest_center_sse2), GPICK_KERNEL(nearest_center_avx2));
+	palette.clear();
+	if (count == 0 || max_colors == 0) return;
+	vector<QuantizerColor> reduced;
+	for (int bits = 7; count > KMeansMaxColors && bits >= 4; bits--){
+		quantizer_histogram_reduce(colors, count, bits, reduced);
+		if (reduced.size() <= KMeansMaxColors || bits == 4){
+			colors = reduced.data();
+			count = reduced.size();
+		}
+	}
+	vector<Color> lab(count);
+	for (size_t i = 0; i < count; i++){
+		lab[i] = colors[i].color;
+	}
+	RgbToLabPipeline to_lab;
+	to_lab(lab.data(), lab.data(), count);
+	vector<float> l(count), a(count), b(count);
+	vector<double> weights(count);
+	for (size_t i = 0; i < count; i++){
+		l[i] = lab[i].lab.L;
+		a[i] = lab[i].lab.a;
+		b[i] = lab[i].lab.b;
+		weights[i] = colors[i].weight;
+	}
+
+	// k-means++ seeding
+	uint32_t state = 0x9e3779b9;
+	size_t k = min<size_t>(max_colors, count);
+	vector<float> cl, ca, cb;
+	vector<uint32_t> assignment(count);
+	vector<float> distance(count), center_distance(count);
+	vector<double> seed_weights(weights);
+	double total = 0;
+	for (auto w: weights) total += w;
+	while (cl.size() < k && total > 0){
+		size_t selected = kmeans_pick(seed_weights, total, state);
+		cl.push_back(l[selected]);
+		ca.push_back(a[selected]);
+		cb.push_back(b[selected]);
+		nearest_center(l.data(), a.data(), b.data(), count, &cl.back(), &ca.back(), &cb.back(), 1, assignment.data(), center_distance.data());
+		total = 0;
+		for (size_t i = 0; i < count; i++){
+			if (cl.size() == 1 || center_distance[i] < distance[i]) distance[i] = center_distance[i];
+			seed_weights[i] = weights[i] * distance[i];
+			total += seed_weights[i];
+		}
+	}
+
+	// Lloyd iterations
+	k = cl.size();
+	vector<double> sum_l(k), sum_a(k), sum_b(k), sum_weight(k);
+	vector<uint32_t> previous;
+	for (int iteration = 0; iteration < KMeansIterations; iteration++){
+		nearest_center(l.data(), a.data(), b.data(), count, cl.data(), ca.data(), cb.data(), k, assignment.data(), distance.data());
+		if (assignment == previous) break;
+		fill(sum_l.begin(), sum_l.end(), 0);
+		fill(sum_a.begin(), sum_a.end(), 0);
+		fill(sum_b.begin(), sum_b.end(), 0);
+		fill(sum_weight.begin(), sum_weight.end(), 0);
+		for (size_t i = 0; i < count; i++){
+			uint32_t c = assignment[i];
+			sum_l[c] += weights[i] * l[i];
+			sum_a[c] += weights[i] * a[i];
+			sum_b[c] += weights[i] * b[i];
+			sum_weight[c] += weights[i];
+		}
+		for (size_t c = 0; c < k; c++){
+			if (sum_weight[c] <= 0) continue;
+			cl[c] = sum_l[c] / sum_weight[c];
+			ca[c] = sum_a[c] / sum_weight[c];
+			cb[c] = sum_b[c] / sum_weight[c];
+		}
+		previous.swap(assignment);
+		assignment.resize(count);
+	}
+
+	LabToRgbPipeline to_rgb;
+	for (size_t c = 0; c < k; c++){
+		Color center, rgb;
+		center.lab.L = cl[c];
+		center.lab.a = ca[c];
+		center.lab.b = cb[c];
+		center.ma[3] = 0;
+		to_rgb(&center, &rgb);
+		color_rgb_normalize(&rgb);
+		palette.push_back(rgb);
+	}
+}
+
+const Quantizer quantizers[] = {
+	{"octree", N_("Octree"), quantize_octree},
+	{"wu", N_("Wu"), quantize_wu},
+	{"median_cut", N_("Median cut"), quantize_median_cut},
+	{"kmeans", N_("K-means (Lab)"), quantize_kmeans},
+};
+
+const Quantizer* quantizers_get(){
+	return quantizers;
+}
+
+uint32_t quantizers_get_n(){
+	return sizeof(quantizers) / sizeof(Quantizer);
+}
+
+const Quantizer* quantizer_get(const char *name){
+	for (uint32_t i = 0; i < quantizers_get_n(); i++){
+		if (strcmp(quantizers[i].name, name) == 0) return &quantizers[i];
+	}
+	return nullptr;
+}
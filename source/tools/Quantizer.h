@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2009-2016, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_TOOLS_QUANTIZER_H_
+#define GPICK_TOOLS_QUANTIZER_H_
+#include "../Color.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/** \file source/tools/Quantizer.h
+ * \brief Color quantization engines used to build palettes from images.
+ */
+
+/** \struct QuantizerColor
+ * \brief Color with a weight, usually the number of pixels with that color
+ */
+struct QuantizerColor{
+	Color color; /**< Color in RGB color space */
+	uint32_t weight; /**< Color weight */
+};
+
+/** \struct Quantizer
+ * \brief Quantizer structure contains quantization engine name and function
+ */
+typedef struct Quantizer{
+	const char *name; /**< Identifier used in settings and on command line */
+	const char *label; /**< Human readable name */
+/**
+ * Callback used to find a palette representing weighted colors
+ * @param[in] colors Weighted colors, every color should be present only once
+ * @param[in] count Number of colors
+ * @param[in] max_colors Maximum number of colors in palette
+ * @param[out] palette Palette colors in RGB color space
+ */
+	void (*quantize)(const QuantizerColor *colors, size_t count, uint32_t max_colors, std::vector<Color> &palette);
+}Quantizer;
+
+/**
+ * Get available quantizers
+ * @return Constant array of available quantizers
+ */
+const Quantizer* quantizers_get();
+
+/**
+ * Get the number of available quantizers
+ * @return Number of available quantizers
+ */
+uint32_t quantizers_get_n();
+
+/**
+ * Find quantizer by name
+ * @param[in] name Quantizer name
+ * @return Quantizer or nullptr if there is no quantizer with specified name
+ */
+const Quantizer* quantizer_get(const char *name);
+
+/** \struct QuantizerHistogram
+ * \brief Incrementally built histogram of distinct 24-bit colors
+ */
+typedef struct QuantizerHistogram QuantizerHistogram;
+
+/**
+ * Create empty histogram
+ * @return New histogram
+ */
+QuantizerHistogram* quantizer_histogram_new();
+
+/**
+ * Destroy histogram
+ * @param[in] histogram Histogram
+ */
+void quantizer_histogram_destroy(QuantizerHistogram *histogram);
+
+/**
+ * Remove all colors from histogram
+ * @param[in] histogram Histogram
+ */
+void quantizer_histogram_clear(QuantizerHistogram *histogram);
+
+/**
+ * Add pixels of 8-bit per channel image to the histogram. Can be called repeatedly to add image in parts.
+ * @param[in] histogram Histogram
+ * @param[in] data Image data
+ * @param[in] channels Number of channels in each pixel, first three are red, green and blue
+ * @param[in] width Image width
+ * @param[in] height Number of rows to add
+ * @param[in] rowstride Number of bytes between rows
+ */
+void quantizer_histogram_add_rgb8(QuantizerHistogram *histogram, const unsigned char *data, int channels, int width, int height, int rowstride);
+
+/**
+ * Add pixels of 8-bit per channel image to the histogram using multiple threads. Histogram is split into partitions by color, each thread reads all pixels and counts colors of its own partitions, so the result is identical to quantizer_histogram_add_rgb8.
+ * Small images are added in the calling thread.
+ * @param[in] histogram Histogram
+ * @param[in] data Image data
+ * @param[in] channels Number of channels in each pixel, first three are red, green and blue
+ * @param[in] width Image width
+ * @param[in] height Number of rows to add
+ * @param[in] rowstride Number of bytes between rows
+ * @param[in] threads Number of threads, 0 to use one thread for each processor
+ */
+void quantizer_histogram_add_rgb8_parallel(QuantizerHistogram *histogram, const unsigned char *data, int channels, int width, int height, int rowstride, unsigned int threads);
+
+/**
+ * Get the number of distinct colors in histogram
+ * @param[in] histogram Histogram
+ * @return Number of distinct colors
+ */
+size_t quantizer_histogram_get_size(const QuantizerHistogram *histogram);
+
+/**
+ * Get histogram colors
+ * @param[in] histogram Histogram
+ * @param[out] colors Distinct colors weighted by pixel count, sorted by color value
+ */
+void quantizer_histogram_get_colors(const QuantizerHistogram *histogram, std::vector<QuantizerColor> &colors);
+
+/**
+ * Build histogram of distinct colors in 8-bit per channel image
+ * @param[in] data Image data
+ * @param[in] channels Number of channels in each pixel, first three are red, green and blue
+ * @param[in] width Image width
+ * @param[in] height Image height
+ * @param[in] rowstride Number of bytes between rows
+ * @param[out] histogram Distinct colors weighted by pixel count, sorted by color value
+ */
+void quantizer_histogram_rgb8(const unsigned char *data, int channels, int width, int height, int rowstride, std::vector<QuantizerColor> &histogram);
+
+/**
+ * Reduce histogram size by merging colors which are equal in the specified number of most significant bits.
+ * Merged colors are replaced by their weighted average.
+ * @param[in] colors Weighted colors
+ * @param[in] count Number of colors
+ * @param[in] bits Number of bits per channel to keep
+ * @param[out] result Merged colors
+ */
+void quantizer_histogram_reduce(const QuantizerColor *colors, size_t count, int bits, std::vector<QuantizerColor> &result);
+#endif /* GPICK_TOOLS_QUANTIZER_H_ */
@@ -51,6 +51,9 @@
 #include "tools/PaletteFromCssFile.h"
 #include "tools/ColorSpaceSampler.h"
 #include "dbus/Control.h"
+#include "Sampler.h"
+#include "ScreenReader.h"
+#include "PickerTimings.h"
 #include "DynvHelpers.h"
 #include "FileFormat.h"
 #include "MathUtil.h"
@@ -67,6 +70,7 @@
 #include <algorithm>
 #include <functional>
 #include <iostream>
+#include <fstream>
 #include <boost/filesystem.hpp>
 #include <boost/interprocess/sync/named_mutex.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
@@ -1648,6 +1652,23 @@ void app_initialize()
 	gtk_icon_theme_append_search_path(icon_theme, tmp = build_filename(nullptr));
 	g_free(tmp);
 }
+/** Get picker stage latencies and screen reader statistics as JSON object */
+static string app_get_statistics(AppArgs *args)
+{
+	ScreenReaderStatistics screen_reader;
+	screen_reader_get_statistics(args->gs->getScreenReader(), &screen_reader);
+	stringstream ss;
+	ss << "{\"stages\": " << picker_timings_to_json() << ", \"screen_reader\": {\"updates\": " << screen_reader.updates << ", \"skipped\": " << screen_reader.skipped << ", \"damage_tracking\": " << (screen_reader.damage_tracking ? "true" : "false") << "}}";
+	return ss.str();
+}
+static void app_save_statistics(AppArgs *args, const char *filename)
+{
+	ofstream file(filename, ios::out | ios::trunc);
+	if (file.is_open())
+		file << app_get_statistics(args) << endl;
+	if (!file.good())
+		cerr << "failed to save statistics: " << filename << endl;
+}
 AppArgs* app_create_main(const AppOptions &options, int &return_value)
 {
 	AppArgs* args = new AppArgs;
@@ -1670,6 +1691,28 @@ AppArgs* app_create_main(const AppOptions &options, int &return_value)
 			}
 			return true;
 		};
+		args->dbus_control.onSamplePoints = [args](const vector<math::Vec2<int>> &points, vector<Color> &colors){
+			colors.resize(points.size());
+			if (points.empty()) return true;
+			size_t sampled = sampler_get_color_samples(args->gs->getSampler(), gdk_screen_get_default(), &points.front(), points.size(), &colors.front());
+			return sampled == points.size();
+		};
+		args->dbus_control.onSampleRegions = [args](const vector<math::Rect2<int>> &regions, vector<Color> &colors){
+			colors.resize(regions.size());
+			if (regions.empty()) return true;
+			size_t sampled = sampler_get_region_colors(args->gs->getSampler(), gdk_screen_get_default(), &regions.front(), regions.size(), &colors.front());
+			return sampled == regions.size();
+		};
+		args->dbus_control.onSampleGrid = [args](const math::Rect2<int> &area, int columns, int rows, vector<Color> &colors){
+			vector<math::Vec2<int>> points(columns * rows);
+			colors.resize(points.size());
+			sampler_get_grid_points(area, columns, rows, &points.front());
+			size_t sampled = sampler_get_color_samples(args->gs->getSampler(), gdk_screen_get_default(), &points.front(), points.size(), &colors.front());
+			return sampled == points.size();
+		};
+		args->dbus_control.onGetStatistics = [args](){
+			return app_get_statistics(args);
+		};
 		args->dbus_control.onSingleInstanceActivate = [args]{
 			status_icon_set_visible(args->status_icon, false);
 			main_show_window(args->window, args->params);
@@ -1968,6 +2011,8 @@ int app_run(AppArgs *args)
 		args->dbus_control.unownName();
 		status_icon_destroy(args->status_icon);
 	}
+	if (!args->options.statistics_filename.empty())
+		app_save_statistics(args, args->options.statistics_filename.c_str());
 	args->gs->writeSettings();
 	dynv_system_release(args->params);
 	delete args->gs;
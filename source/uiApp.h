@@ -34,6 +34,7 @@ struct AppOptions
 	bool output_without_newline;
 	bool single_color_pick_mode;
 	bool do_not_start;
+	std::string statistics_filename; /**< File for picker latency statistics written on exit, empty if statistics are not saved */
 };
 void app_initialize();
 AppArgs* app_create_main(const AppOptions &options, int &return_value);
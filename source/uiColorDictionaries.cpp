@@ -310,8 +310,7 @@ void dialog_color_dictionaries_show(GtkWindow* parent, GlobalState* gs)
 		}else{
 			dynv_set_dynv_array(args->params, "color_dictionaries.items", nullptr, 0);
 		}
-		color_names_clear(args->gs->getColorNames());
-		color_names_load(args->gs->getColorNames(), args->params);
+		color_names_load_async(args->gs->getColorNames(), args->params);
 	}
 	gint width, height;
 	gtk_window_get_size(GTK_WINDOW(dialog), &width, &height);
@@ -22,6 +22,7 @@
 #include "ColorList.h"
 #include "ColorObject.h"
 #include "MathUtil.h"
+#include "TreeReduce.h"
 #include "DynvHelpers.h"
 #include "GlobalState.h"
 #include "ColorRYB.h"
@@ -33,6 +34,7 @@
 #include <math.h>
 #include <sstream>
 #include <iostream>
+#include <vector>
 using namespace std;
 
 typedef struct DialogSortArgs{
@@ -51,13 +53,22 @@ typedef struct DialogSortArgs{
 	GlobalState* gs;
 }DialogSortArgs;
 
+typedef enum ConversionSpace{
+	CONVERSION_RGB,
+	CONVERSION_HSL,
+	CONVERSION_LAB,
+	CONVERSION_LCH,
+}ConversionSpace;
+
 typedef struct SortType{
 	const char *name;
+	ConversionSpace space; /**< Color space colors are converted to before calling get_value */
 	double (*get_value)(Color *color);
 }SortType;
 
 typedef struct GroupType{
 	const char *name;
+	ConversionSpace space; /**< Color space colors are converted to before calling get_group */
 	double (*get_group)(Color *color);
 }GroupType;
 
@@ -77,75 +88,57 @@ static double sort_rgb_grayscale(Color *color)
 {
 	return (color->rgb.red + color->rgb.green + color->rgb.blue) / 3.0;
 }
-static double sort_hsl_hue(Color *color)
+static double sort_hsl_hue(Color *hsl)
 {
-	Color hsl;
-	color_rgb_to_hsl(color, &hsl);
-	return hsl.hsl.hue;
+	return hsl->hsl.hue;
 }
-static double sort_hsl_saturation(Color *color)
+static double sort_hsl_saturation(Color *hsl)
 {
-	Color hsl;
-	color_rgb_to_hsl(color, &hsl);
-	return hsl.hsl.saturation;
+	return hsl->hsl.saturation;
 }
-static double sort_hsl_lightness(Color *color)
+static double sort_hsl_lightness(Color *hsl)
 {
-	Color hsl;
-	color_rgb_to_hsl(color, &hsl);
-	return hsl.hsl.lightness;
+	return hsl->hsl.lightness;
 }
-static double sort_lab_lightness(Color *color)
+static double sort_lab_lightness(Color *lab)
 {
-	Color lab;
-	color_rgb_to_lab_d50(color, &lab);
-	return lab.lab.L;
+	return lab->lab.L;
 }
-static double sort_lab_a(Color *color)
+static double sort_lab_a(Color *lab)
 {
-	Color lab;
-	color_rgb_to_lab_d50(color, &lab);
-	return lab.lab.a;
+	return lab->lab.a;
 }
-static double sort_lab_b(Color *color)
+static double sort_lab_b(Color *lab)
 {
-	Color lab;
-	color_rgb_to_lab_d50(color, &lab);
-	return lab.lab.b;
+	return lab->lab.b;
 }
-static double sort_lch_lightness(Color *color)
+static double sort_lch_lightness(Color *lch)
 {
-	Color lch;
-	color_rgb_to_lch_d50(color, &lch);
-	return lch.lch.L;
+	return lch->lch.L;
 }
-static double sort_lch_chroma(Color *color)
+static double sort_lch_chroma(Color *lch)
 {
-	Color lch;
-	color_rgb_to_lch_d50(color, &lch);
-	return lch.lch.C;
+	return lch->lch.C;
 }
-static double sort_lch_hue(Color *color)
+static double sort_lch_hue(Color *lch)
 {
-	Color lch;
-	color_rgb_to_lch_d50(color, &lch);
-	return lch.lch.h;
+	return lch->lch.h;
 }
 
 const SortType sort_types[] = {
-	{N_("RGB Red"), sort_rgb_red},
-	{N_("RGB Green"), sort_rgb_green},
-	{N_("RGB Blue"), sort_rgb_blue},
-	{N_("RGB Grayscale"), sort_rgb_grayscale},
-	{N_("HSL Hue"), sort_hsl_hue},
-	{N_("HSL Saturation"), sort_hsl_saturation},
-	{N_("HSL Lightness"), sort_hsl_lightness},
-	{N_("Lab Lightness"), sort_lab_lightness},
-	{N_("Lab A"), sort_lab_a},
-	{N_("Lab B"), sort_lab_b},
-	{N_("LCh Lightness"), sort_lch_lightness},
-	{N_("LCh Chroma"), sort_lch_chroma},
-	{N_("LCh Hue"), sort_lch_hue},
+	{N_("RGB Red"), CONVERSION_RGB, sort_rgb_red},
+	{N_("RGB Green"), CONVERSION_RGB, sort_rgb_green},
+	{N_("RGB Blue"), CONVERSION_RGB, sort_rgb_blue},
+	{N_("RGB Grayscale"), CONVERSION_RGB, sort_rgb_grayscale},
+	{N_("HSL Hue"), CONVERSION_HSL, sort_hsl_hue},
+	{N_("HSL Saturation"), CONVERSION_HSL, sort_hsl_saturation},
+	{N_("HSL Lightness"), CONVERSION_HSL, sort_hsl_lightness},
+	{N_("Lab Lightness"), CONVERSION_LAB, sort_lab_lightness},
+	{N_("Lab A"), CONVERSION_LAB, sort_lab_a},
+	{N_("Lab B"), CONVERSION_LAB, sort_lab_b},
+	{N_("LCh Lightness"), CONVERSION_LCH, sort_lch_lightness},
+	{N_("LCh Chroma"), CONVERSION_LCH, sort_lch_chroma},
+	{N_("LCh Hue"), CONVERSION_LCH, sort_lch_hue},
 };
 
 static double group_rgb_red(Color *color)
@@ -164,88 +157,91 @@ static double group_rgb_grayscale(Color *color)
 {
 	return (color->rgb.red + color->rgb.green + color->rgb.blue) / 3.0;
 }
-static double group_hsl_hue(Color *color)
+static double group_hsl_hue(Color *hsl)
 {
-	Color hsl;
-	color_rgb_to_hsl(color, &hsl);
-	return hsl.hsl.hue;
+	return hsl->hsl.hue;
 }
-static double group_hsl_saturation(Color *color)
+static double group_hsl_saturation(Color *hsl)
 {
-	Color hsl;
-	color_rgb_to_hsl(color, &hsl);
-	return hsl.hsl.saturation;
+	return hsl->hsl.saturation;
 }
-static double group_hsl_lightness(Color *color)
+static double group_hsl_lightness(Color *hsl)
 {
-	Color hsl;
-	color_rgb_to_hsl(color, &hsl);
-	return hsl.hsl.lightness;
+	return hsl->hsl.lightness;
 }
-static double group_lab_lightness(Color *color)
+static double group_lab_lightness(Color *lab)
 {
-	Color lab;
-	color_rgb_to_lab_d50(color, &lab);
-	return lab.lab.L / 100.0;
+	return lab->lab.L / 100.0;
 }
-static double group_lab_a(Color *color)
+static double group_lab_a(Color *lab)
 {
-	Color lab;
-	color_rgb_to_lab_d50(color, &lab);
-	return (lab.lab.a + 145) / 290.0;
+	return (lab->lab.a + 145) / 290.0;
 }
-static double group_lab_b(Color *color)
+static double group_lab_b(Color *lab)
 {
-	Color lab;
-	color_rgb_to_lab_d50(color, &lab);
-	return (lab.lab.b + 145) / 290.0;
+	return (lab->lab.b + 145) / 290.0;
 }
-static double group_lch_lightness(Color *color)
+static double group_lch_lightness(Color *lch)
 {
-	Color lch;
-	color_rgb_to_lch_d50(color, &lch);
-	return lch.lch.L / 100.0;
+	return lch->lch.L / 100.0;
 }
-static double group_lch_chroma(Color *color)
+static double group_lch_chroma(Color *lch)
 {
-	Color lch;
-	color_rgb_to_lch_d50(color, &lch);
-	return lch.lch.C / 136.0;
+	return lch->lch.C / 136.0;
 }
-static double group_lch_hue(Color *color)
+static double group_lch_hue(Color *lch)
 {
-	Color lch;
-	color_rgb_to_lch_d50(color, &lch);
-	return lch.lch.h / 360.0;
+	return lch->lch.h / 360.0;
 }
 
 const GroupType group_types[] = {
-	{N_("None"), nullptr},
-	{N_("RGB Red"), group_rgb_red},
-	{N_("RGB Green"), group_rgb_green},
-	{N_("RGB Blue"), group_rgb_blue},
-	{N_("RGB Grayscale"), group_rgb_grayscale},
-	{N_("HSL Hue"), group_hsl_hue},
-	{N_("HSL Saturation"), group_hsl_saturation},
-	{N_("HSL Lightness"), group_hsl_lightness},
-	{N_("Lab Lightness"), group_lab_lightness},
-	{N_("Lab A"), group_lab_a},
-	{N_("Lab B"), group_lab_b},
-	{N_("LCh Lightness"), group_lch_lightness},
-	{N_("LCh Chroma"), group_lch_chroma},
-	{N_("LCh Hue"), group_lch_hue},
+	{N_("None"), CONVERSION_RGB, nullptr},
+	{N_("RGB Red"), CONVERSION_RGB, group_rgb_red},
+	{N_("RGB Green"), CONVERSION_RGB, group_rgb_green},
+	{N_("RGB Blue"), CONVERSION_RGB, group_rgb_blue},
+	{N_("RGB Grayscale"), CONVERSION_RGB, group_rgb_grayscale},
+	{N_("HSL Hue"), CONVERSION_HSL, group_hsl_hue},
+	{N_("HSL Saturation"), CONVERSION_HSL, group_hsl_saturation},
+	{N_("HSL Lightness"), CONVERSION_HSL, group_hsl_lightness},
+	{N_("Lab Lightness"), CONVERSION_LAB, group_lab_lightness},
+	{N_("Lab A"), CONVERSION_LAB, group_lab_a},
+	{N_("Lab B"), CONVERSION_LAB, group_lab_b},
+	{N_("LCh Lightness"), CONVERSION_LCH, group_lch_lightness},
+	{N_("LCh Chroma"), CONVERSION_LCH, group_lch_chroma},
+	{N_("LCh Hue"), CONVERSION_LCH, group_lch_hue},
 };
 
+static void convert_colors(ConversionSpace space, const vector<Color> &colors, vector<Color> &result)
+{
+	result.resize(colors.size());
+	if (colors.empty()) return;
+	switch (space){
+		case CONVERSION_RGB:
+			result = colors;
+			break;
+		case CONVERSION_HSL:
+			color_rgb_to_hsl_batch(&colors[0], &result[0], colors.size());
+			break;
+		case CONVERSION_LAB:
+			color_rgb_to_lab_d50_batch(&colors[0], &result[0], colors.size());
+			break;
+		case CONVERSION_LCH:
+			color_rgb_to_lch_d50_batch(&colors[0], &result[0], colors.size());
+			break;
+	}
+}
 
-
+/** \struct Node
+ * \brief Binary tree node holding values in a part of value range
+ */
 typedef struct Node{
 	uint32_t n_values;
 	uint32_t n_values_in;
 	double value_sum;
 	double distance;
 
-	Node *child[2];
-	Node *parent;
+	uint32_t child[2]; /**< Indices of child nodes, 0 if there is no child */
+	uint32_t parent;
 }Node;
 
 typedef struct Range{
@@ -253,138 +249,30 @@ typedef struct Range{
 	double w;
 }Range;
 
-static Node* node_new(Node *parent){
-	Node *n = new Node;
-	n->value_sum = 0;
-	n->distance = 0;
-	n->n_values = 0;
-	n->n_values_in = 0;
-	n->parent = parent;
+static uint32_t node_new(vector<Node> &nodes, uint32_t parent){
+	Node n;
+	n.value_sum = 0;
+	n.distance = 0;
+	n.n_values = 0;
+	n.n_values_in = 0;
+	n.parent = parent;
 	for (int i = 0; i < 2; i++){
-		n->child[i] = 0;
+		n.child[i] = 0;
 	}
-	return n;
+	nodes.push_back(n);
+	return nodes.size() - 1;
 }
 
-static void node_delete(Node *node){
-	for (int i = 0; i < 2; i++){
-		if (node->child[i]){
-			node_delete(node->child[i]);
-		}
-	}
-	delete node;
-}
-
-static Node* node_copy(Node *node, Node *parent){
-	Node *n = node_new(0);
-	memcpy(n, node, sizeof(Node));
-	n->parent = parent;
-
-	for (int i = 0; i < 2; i++){
-		if (node->child[i]){
-			n->child[i] = node_copy(node->child[i], n);
-		}else{
-			n->child[i] = 0;
-		}
-	}
-	return n;
+static void node_reduce(vector<Node> &nodes, double threshold, uintptr_t max_values){
+	tree_reduce(nodes, threshold, max_values, [](const Node &node){
+		return node.n_values_in > 0;
+	}, [](Node &parent, const Node &node){
+		parent.n_values_in += node.n_values_in;
+		parent.value_sum += node.value_sum;
+	});
 }
 
-static uint32_t node_count_leafs(Node *node){
-	uint32_t r = 0;
-	if (node->n_values_in) r++;
-	for (int i = 0; i < 2; i++){
-		if (node->child[i])
-			r += node_count_leafs(node->child[i]);
-	}
-	return r;
-}
-
-static void node_leaf_callback(Node *node, void (*leaf_cb)(Node* node, void* userdata), void* userdata){
-	if (node->n_values_in > 0) leaf_cb(node, userdata);
-
-	for (int i = 0; i < 2; i++){
-		if (node->child[i])
-			node_leaf_callback(node->child[i], leaf_cb, userdata);
-	}
-}
-
-static void node_prune(Node *node){
-	for (int i = 0; i < 2; i++){
-		if (node->child[i]){
-			node_prune(node->child[i]);
-			node->child[i] = 0;
-		}
-	}
-	if (node->parent){
-		node->parent->n_values_in += node->n_values_in;
-		node->parent->value_sum += node->value_sum;
-	}
-	node_delete(node);
-}
-
-typedef struct PruneData{
-	double threshold;
-	double min_distance;
-	uint32_t n_values;
-	uint32_t n_values_target;
-
-	Node *prune_node;
-	uint32_t distant_nodes;
-}PruneData;
-
-static bool node_prune_threshold(Node *node, PruneData *prune_data, bool leave_node){
-	if (node->distance <= prune_data->threshold){
-		uint32_t values_removed;
-		if (leave_node){
-			values_removed = 0;
-			for (int i = 0; i < 2; i++){
-				if (node->child[i]){
-					values_removed += node_count_leafs(node->child[i]);
-					node_prune(node->child[i]);
-					node->child[i] = 0;
-				}
-			}
-		}else{
-			values_removed = node_count_leafs(node);
-			node_prune(node);
-		}
-		prune_data->n_values -= values_removed;
-		return true;
-	}
-	if (node->distance < prune_data->min_distance){
-		prune_data->min_distance = node->distance;
-	}
-	uint32_t n = node->n_values_in;
-	for (int i = 0; i < 2; i++){
-		if (node->child[i]){
-			if (node_prune_threshold(node->child[i], prune_data, false)){
-				node->child[i] = 0;
-			}
-		}
-	}
-	if (node->n_values_in > 0 && n == 0) prune_data->n_values++;
-	return false;
-}
-
-static void node_reduce(Node *node, double threshold, uintptr_t max_values){
-	PruneData prune_data;
-	prune_data.n_values = node_count_leafs(node);
-	prune_data.n_values_target = max_values;
-	prune_data.threshold = threshold;
-
-	prune_data.min_distance = node->distance;
-	node_prune_threshold(node, &prune_data, true);
-	prune_data.threshold = prune_data.min_distance;
-
-	while (prune_data.n_values > max_values){
-		prune_data.min_distance = node->distance;
-		if (node_prune_threshold(node, &prune_data, true)) break;
-		prune_data.threshold = prune_data.min_distance;
-	}
-}
-
-static Node* node_find(Node *node, Range *range, double value)
+static uint32_t node_find(const vector<Node> &nodes, uint32_t index, Range *range, double value)
 {
 	Range new_range;
 	new_range.w = range->w / 2;
@@ -394,20 +282,20 @@ static Node* node_find(Node *node, Range *range, double value)
 	else
 		x = 1;
 	new_range.x = range->x + new_range.w * x;
-	if (node->child[x]){
-		return node_find(node->child[x], &new_range, value);
-	}else return node;
+	if (nodes[index].child[x]){
+		return node_find(nodes, nodes[index].child[x], &new_range, value);
+	}else return index;
 }
 
-static void node_update(Node *node, Range *range, double value, uint32_t max_depth){
+static void node_update(vector<Node> &nodes, uint32_t index, Range *range, double value, uint32_t max_depth){
 	Range new_range;
 	new_range.w = range->w / 2;
-	node->n_values++;
-	node->distance += (value - (range->x + new_range.w)) * (value - (range->x + new_range.w));
+	nodes[index].n_values++;
+	nodes[index].distance += (value - (range->x + new_range.w)) * (value - (range->x + new_range.w));
 
 	if (!max_depth){
-		node->n_values_in++;
-		node->value_sum += value;
+		nodes[index].n_values_in++;
+		nodes[index].value_sum += value;
 	}else{
 		int x;
 		if (value - range->x < new_range.w)
@@ -416,11 +304,13 @@ static void node_update(Node *node, Range *range, double value, uint32_t max_dep
 			x = 1;
 
 		new_range.x = range->x + new_range.w * x;
-		if (!node->child[x])
-			node->child[x] = node_new(node);
+		if (!nodes[index].child[x]){
+			uint32_t child = node_new(nodes, index);
+			nodes[index].child[x] = child;
+		}
 
-		node->n_values++;
-		node_update(node->child[x], &new_range, value, max_depth - 1);
+		nodes[index].n_values++;
+		node_update(nodes, nodes[index].child[x], &new_range, value, max_depth - 1);
 	}
 }
 
@@ -458,48 +348,42 @@ static void calc(DialogSortArgs *args, bool preview, int limit){
 	const GroupType *group = &group_types[group_type];
 	const SortType *sort = &sort_types[sort_type];
 
-	Color in;
-	Node *group_nodes = node_new(0);
+	vector<ColorObject*> color_objects;
+	vector<Color> colors;
+	for (ColorList::iter i = args->selected_color_list->colors.begin(); i != args->selected_color_list->colors.end(); ++i){
+		color_objects.push_back(*i);
+		colors.push_back((*i)->getColor());
+		if (preview && colors.size() > size_t(limit))
+			break;
+	}
+
+	vector<Node> group_nodes;
+	node_new(group_nodes, 0);
 	Range range;
 	range.x = 0;
 	range.w = 1;
-	int tmp_limit = limit;
+	vector<Color> group_colors;
 	if (group->get_group){
-		for (ColorList::iter i = args->selected_color_list->colors.begin(); i != args->selected_color_list->colors.end(); ++i){
-			in = (*i)->getColor();
-			node_update(group_nodes, &range, group->get_group(&in), 8);
-			if (preview){
-				if (tmp_limit <= 0)
-					break;
-				tmp_limit--;
-			}
+		convert_colors(group->space, colors, group_colors);
+		for (size_t i = 0; i < group_colors.size(); ++i){
+			node_update(group_nodes, 0, &range, group->get_group(&group_colors[i]), 8);
 		}
 	}
 
 	node_reduce(group_nodes, group_sensitivity / 100.0, max_groups);
 
-	tmp_limit = limit;
-	for (ColorList::iter i = args->selected_color_list->colors.begin(); i != args->selected_color_list->colors.end(); ++i){
-		in = (*i)->getColor();
-
-		uintptr_t node_ptr = 0;
+	vector<Color> sort_colors;
+	convert_colors(sort->space, colors, sort_colors);
+	for (size_t i = 0; i < color_objects.size(); ++i){
+		uintptr_t group_index = 0;
 		if (group->get_group){
-			node_ptr = reinterpret_cast<uintptr_t>(node_find(group_nodes, &range, group->get_group(&in)));
-		}
-		grouped_sorted_colors[node_ptr].insert(std::pair<double, ColorObject*>(sort->get_value(&in), *i));
-
-		if (preview){
-			if (tmp_limit <= 0)
-				break;
-			tmp_limit--;
+			group_index = node_find(group_nodes, 0, &range, group->get_group(&group_colors[i]));
 		}
+		grouped_sorted_colors[group_index].insert(std::pair<double, ColorObject*>(sort->get_value(&sort_colors[i]), color_objects[i]));
 	}
 
-	node_delete(group_nodes);
-
 	for (GroupedSortedColors::iterator i = grouped_sorted_colors.begin(); i != grouped_sorted_colors.end(); ++i){
-		in = (*(*i).second.begin()).second->getColor();
-		sorted_groups.insert(std::pair<double, uintptr_t>(sort->get_value(&in), (*i).first));
+		sorted_groups.insert(std::pair<double, uintptr_t>((*(*i).second.begin()).first, (*i).first));
 	}
 
 	if (reverse_groups){